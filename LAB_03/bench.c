@@ -0,0 +1,99 @@
+/** \file bench.c
+ * 	\brief Benchmark of the module mySAG
+ *
+ *  Compares the incremental queries (MySAGMax(), MySAGMin(), MySAGAvg() and
+ * MySAGFreq()) against the full scan reference implementation, querying the
+ * four values after every MySAGInsert(), for windows from 10 to 100k elements.
+ *
+ * \author André Brandão
+ * \author Emanuel Pereira
+ * \date 22/03/2022
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "mySAG.h"
+
+#define OPS_BUDGET 20000000L	/**< Scanned elements per window size (limits full scan run time) */
+#define MIN_OPS 200				/**< Minimum number of insert + query operations */
+#define MAX_N 100000			/**< Biggest window size */
+
+static int buf[MYSAG_BUF_SIZE(MAX_N)];	/**< Storage of the stream */
+static MySAG sag;						/**< Stream under test */
+
+/** \brief Current time in nanoseconds */
+static double now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+/** \brief Runs ops inserts, each followed by the four queries
+ *
+ * \param[in] N window size
+ * \param[in] ops number of operations
+ * \param[in] scan 1 to use the full scan implementation, 0 the incremental one
+ * \param[out] check accumulated query results (to compare both implementations)
+ *
+ * \return time per operation in nanoseconds
+*/
+static double run(int N, long ops, int scan, long long *check)
+{
+	double start;
+	long long acc = 0;
+	int val;
+
+	MySAGCreate(&sag, buf, N);
+	srand(1);
+
+	// Fill the window first so that every measured insert evicts a value
+	for(int i=0; i < N; i++)
+		MySAGInsert(&sag, rand() % 1000);
+
+	start = now_ns();
+	for(long i=0; i < ops; i++)
+	{
+		val = rand() % 1000;
+		MySAGInsert(&sag, val);
+
+		if(scan)
+			acc += MySAGMaxScan(&sag) + MySAGMinScan(&sag) + MySAGAvgScan(&sag) + MySAGFreqScan(&sag, val);
+		else
+			acc += MySAGMax(&sag) + MySAGMin(&sag) + MySAGAvg(&sag) + MySAGFreq(&sag, val);
+	}
+
+	*check = acc;
+	return (now_ns() - start) / ops;
+}
+
+int main(void)
+{
+	int sizes[] = {10, 100, 1000, 10000, MAX_N};
+	long long check_scan, check_inc;
+	double t_scan, t_inc;
+	long ops;
+
+	printf("%8s %10s %14s %14s %10s\n", "N", "ops", "scan (ns/op)", "incr (ns/op)", "speedup");
+
+	for(unsigned int i=0; i < sizeof(sizes)/sizeof(sizes[0]); i++)
+	{
+		ops = OPS_BUDGET / sizes[i];
+		if(ops < MIN_OPS)
+			ops = MIN_OPS;
+
+		t_scan = run(sizes[i], ops, 1, &check_scan);
+		t_inc = run(sizes[i], ops, 0, &check_inc);
+
+		if(check_scan != check_inc)
+		{
+			printf("Mismatch between implementations for N = %d\n", sizes[i]);
+			return 1;
+		}
+
+		printf("%8d %10ld %14.1f %14.1f %9.1fx\n", sizes[i], ops, t_scan, t_inc, t_scan / t_inc);
+	}
+
+	return 0;
+}
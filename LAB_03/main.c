@@ -1,42 +1,96 @@
 /** \file main.c
  * 	\brief This file tests the module mySAG
- * 
+ *
+ *  Besides the basic usage, it runs several independent streams at the same
+ * time, one per thread, and checks every query against the full scan result.
+ *
  * \author André Brandão
  * \author Emanuel Pereira
  * \date 22/03/2022
  */
 #include <stdio.h>
+#include <pthread.h>
 #include "mySAG.h"
 
+#define NTHREADS 32		/**< Number of streams (one thread each) of the concurrency test */
+#define NINSERTS 100000	/**< Number of inserts done by each thread */
+
+MYSAG_DEFINE(sag, 10);	/**< Stream used on the basic test */
+
+static int bufs[NTHREADS][MYSAG_BUF_SIZE(NTHREADS + 1)];	/**< Storage of the concurrent streams */
+static MySAG sags[NTHREADS];	/**< Concurrent streams, stream i has i+1 elements */
+static int errors[NTHREADS];	/**< Number of wrong queries of each stream */
+
+/** \brief Thread that fills one stream and checks its queries
+ *
+ * \param[in] arg index of the stream
+*/
+static void *stream_thread(void *arg)
+{
+	int id = (int)(long)arg;
+	unsigned int seed = id + 1;
+	int val;
+
+	for(unsigned int i=0; i < NINSERTS; i++)
+	{
+		seed = seed * 1103515245u + 12345u;	// Thread-local pseudo random values
+		val = (int)((seed >> 16) % 64) - 32;
+		MySAGInsert(&sags[id], val);
+
+		if(MySAGMax(&sags[id]) != MySAGMaxScan(&sags[id]) ||
+		   MySAGMin(&sags[id]) != MySAGMinScan(&sags[id]) ||
+		   MySAGAvg(&sags[id]) != MySAGAvgScan(&sags[id]) ||
+		   MySAGFreq(&sags[id], val) != MySAGFreqScan(&sags[id], val))
+			errors[id]++;
+	}
+
+	return NULL;
+}
 
 int main(void)
 {
+	pthread_t tid[NTHREADS];
 	int N=10; //value of array size
-	int val = 2; 
+	int val = 2;
+	int fails = 0;
 	printf("Using array SIZE, N= %d: \n", N);
-	// Inits the module
-	if(MySAGInit(N) == -1)
-		return 1;
-	
+
 	printf("vector=[ ");
 	// Adds an element to the stream
 	for(unsigned int i=0; i<N; i++){
-		MySAGInsert(i);
+		MySAGInsert(&sag, i);
 		printf("%d ", i);
 	}
 	printf("]\n");
 
-	printf("Min = %d\n", MySAGMin()); //minimum value of the stream window
-	printf("Max = %d\n", MySAGMax()); //maximum value of the stream window
-	printf("Average = %d\n", MySAGAvg()); //average of the values of the stream window
-	printf("Frequency of %d = %d\n", val, MySAGFreq(val)); //number of times that val appears
-	
+	printf("Min = %d\n", MySAGMin(&sag)); //minimum value of the stream window
+	printf("Max = %d\n", MySAGMax(&sag)); //maximum value of the stream window
+	printf("Average = %d\n", MySAGAvg(&sag)); //average of the values of the stream window
+	printf("Frequency of %d = %d\n", val, MySAGFreq(&sag, val)); //number of times that val appears
+
 	printf("################################\n");
-	N=200;
-	printf("Using bigger array SIZE then allowed, N= %d \n", N);
-	if(MySAGInit(N) == -1)
+	N=0;
+	printf("Using invalid array SIZE, N= %d \n", N);
+	if(MySAGCreate(&sags[0], bufs[0], N) == 0)
 		return 1;
-	
 
-	return 0;
-}
\ No newline at end of file
+	printf("################################\n");
+	printf("Running %d streams on %d threads\n", NTHREADS, NTHREADS);
+	for(int i=0; i < NTHREADS; i++)
+	{
+		if(MySAGCreate(&sags[i], bufs[i], i + 1) == -1)
+			return 1;
+
+		pthread_create(&tid[i], NULL, stream_thread, (void *)(long)i);
+	}
+
+	for(int i=0; i < NTHREADS; i++)
+	{
+		pthread_join(tid[i], NULL);
+		fails += errors[i];
+	}
+
+	printf("Wrong queries = %d\n", fails);
+
+	return fails != 0;
+}
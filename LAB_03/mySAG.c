@@ -1,6 +1,11 @@
 /** \file mySAG.c
  * 	\brief Module to manipulate stream of integers
- * 
+ *
+ *  Besides the stream itself each handle keeps a running sum, two monotonic
+ * deques (for the minimum and maximum) and a frequency table, all updated on
+ * MySAGInsert(), so that every query is answered in (amortized) constant time.
+ * The full scan versions are kept (MySAG*Scan()) as reference implementation.
+ *
  * \author André Brandão
  * \author Emanuel Pereira
  * \date 22/03/2022
@@ -9,116 +14,297 @@
 #include <limits.h>
 #include "mySAG.h"
 
-int stream[MAXSIZE];	/**> Stream to store data */
-int size = 0;			/**> Size of the stream gyven by user */
-int n_elements = 0;		/**> Number of elements present in the stream */
-int pos = 0;			/**> Next position to insert the value in the stream */
+/** \brief Position of the last element of a deque */
+static int dq_back(const MySAG *sag, const MySAGDeque *dq)
+{
+	return dq->idx[(dq->head + dq->len - 1) % sag->size];
+}
+
+/** \brief Appends a stream position to the end of a deque */
+static void dq_push_back(const MySAG *sag, MySAGDeque *dq, int idx)
+{
+	dq->idx[(dq->head + dq->len) % sag->size] = idx;
+	dq->len++;
+}
+
+/** \brief Removes the first element of a deque */
+static void dq_pop_front(const MySAG *sag, MySAGDeque *dq)
+{
+	dq->head = (dq->head + 1) % sag->size;
+	dq->len--;
+}
+
+/** \brief Home slot of a value in the frequency table */
+static int freq_hash(const MySAG *sag, int val)
+{
+	return (int)(((unsigned int)val * 2654435761u) % (unsigned int)(2 * sag->size));
+}
+
+/** \brief Finds the slot of a value in the frequency table
+ *
+ * \param[in] sag stream handle
+ * \param[in] val value to search
+ *
+ * \return slot holding val or the free slot where it must be inserted
+*/
+static int freq_find(const MySAG *sag, int val)
+{
+	int i = freq_hash(sag, val);
+
+	while(sag->freq_cnt[i] != 0 && sag->freq_key[i] != val)
+		i = (i + 1) % (2 * sag->size);
+
+	return i;
+}
+
+/** \brief Increments the number of occurrences of a value */
+static void freq_add(MySAG *sag, int val)
+{
+	int i = freq_find(sag, val);
 
-/** \brief Function to initialize stream with zeros
- * 
+	sag->freq_key[i] = val;
+	sag->freq_cnt[i]++;
+}
+
+/** \brief Decrements the number of occurrences of a value
+ *
+ * When the count reaches zero the slot is freed and the following entries
+ * of the cluster are shifted back (linear probing deletion without tombstones)
+*/
+static void freq_remove(MySAG *sag, int val)
+{
+	int i = freq_find(sag, val), j = i, k;
+
+	if(--sag->freq_cnt[i] > 0)
+		return;
+
+	for(;;)
+	{
+		j = (j + 1) % (2 * sag->size);
+		if(sag->freq_cnt[j] == 0)
+			break;
+
+		k = freq_hash(sag, sag->freq_key[j]);
+
+		// Entry can stay if its home slot is cyclically in ]i, j]
+		if((i <= j) ? (i < k && k <= j) : (i < k || k <= j))
+			continue;
+
+		sag->freq_key[i] = sag->freq_key[j];
+		sag->freq_cnt[i] = sag->freq_cnt[j];
+		i = j;
+	}
+
+	sag->freq_cnt[i] = 0;
+}
+
+/** \brief Function to initialize a stream with zeros
+ *
+ * \param[out] sag stream handle
+ * \param[in] buf storage for the stream, must hold MYSAG_BUF_SIZE(N) integers
  * \param[in] N Size of stream
- * 
+ *
  * \return returns -1 if error initializing stream or 0 otherwise
 */
-int MySAGInit(int N)
+int MySAGCreate(MySAG *sag, int *buf, int N)
 {
-	if(N > MAXSIZE)
+	if(sag == NULL || buf == NULL)
+	{
+		printf("Error Initializing stream - no storage given\n");
+		return -1;
+	}
+
+	if(N < 1)
 	{
-		printf("Error Initializing array - N bigger than %d\n", MAXSIZE);
+		printf("Error Initializing stream - N must be positive\n");
 		return -1;
 	}
 
-	for(unsigned int i=0; i < N; i++)
+	for(unsigned int i=0; i < MYSAG_BUF_SIZE(N); i++)
 	{
-		stream[i] = 0;
+		buf[i] = 0;
 	}
 
-	size = N;
+	sag->stream = buf;
+	sag->freq_key = buf + N;
+	sag->freq_cnt = buf + 3 * N;
+	sag->max_dq.idx = buf + 5 * N;
+	sag->max_dq.head = sag->max_dq.len = 0;
+	sag->min_dq.idx = buf + 6 * N;
+	sag->min_dq.head = sag->min_dq.len = 0;
+	sag->size = N;
+	sag->n_elements = 0;
+	sag->pos = 0;
+	sag->sum = 0;
 
 	return 0;
 }
 
 /** \brief Function to insert value in stream
- * 
+ *
  * Inserts a value in the first available position.\n
  * If stream is full overwrites oldest value\n
- * The stream is treated as a circular array
- * 
+ * The stream is treated as a circular array\n
+ * The running sum, min/max deques and frequency table are updated here
+ *
+ * \param[in,out] sag stream handle
  * \param[in] val value to insert
 */
-void MySAGInsert(int val)
+void MySAGInsert(MySAG *sag, int val)
 {
-	stream[pos] = val;
-	
-	if(n_elements < size)
-		n_elements++;
-	
-	pos = (pos + 1) % size;
+	int pos = sag->pos;
+
+	if(sag->n_elements == sag->size)	// Evict oldest value
+	{
+		sag->sum -= sag->stream[pos];
+		freq_remove(sag, sag->stream[pos]);
+
+		// The oldest value, if still in a deque, is at its front
+		if(sag->max_dq.len > 0 && sag->max_dq.idx[sag->max_dq.head] == pos)
+			dq_pop_front(sag, &sag->max_dq);
+
+		if(sag->min_dq.len > 0 && sag->min_dq.idx[sag->min_dq.head] == pos)
+			dq_pop_front(sag, &sag->min_dq);
+	}
+
+	sag->stream[pos] = val;
+	sag->sum += val;
+	freq_add(sag, val);
+
+	// Values dominated by the new one will never be the max/min again
+	while(sag->max_dq.len > 0 && sag->stream[dq_back(sag, &sag->max_dq)] <= val)
+		sag->max_dq.len--;
+	dq_push_back(sag, &sag->max_dq, pos);
+
+	while(sag->min_dq.len > 0 && sag->stream[dq_back(sag, &sag->min_dq)] >= val)
+		sag->min_dq.len--;
+	dq_push_back(sag, &sag->min_dq, pos);
+
+	if(sag->n_elements < sag->size)
+		sag->n_elements++;
+
+	sag->pos = (pos + 1) % sag->size;
 }
 
 /** \brief Function to compute MAX value of stream
- * 
+ *
+ * \param[in] sag stream handle
+ * \return returns maximum value of stream
+*/
+int MySAGMax(const MySAG *sag)
+{
+	if(sag->max_dq.len == 0)
+		return INT_MIN;
+
+	return sag->stream[sag->max_dq.idx[sag->max_dq.head]];
+}
+
+/** \brief Function to compute MIN value of stream
+ *
+ * \param[in] sag stream handle
+ * \return returns minimum value of stream
+*/
+int MySAGMin(const MySAG *sag)
+{
+	if(sag->min_dq.len == 0)
+		return INT_MAX;
+
+	return sag->stream[sag->min_dq.idx[sag->min_dq.head]];
+}
+
+/** \brief Function to compute average value of stream
+ *
+ * \param[in] sag stream handle
+ * \return returns average value of stream
+*/
+int MySAGAvg(const MySAG *sag)
+{
+	if(sag->n_elements == 0)
+		return 0;
+
+	return (int)(sag->sum / sag->n_elements);
+}
+
+/** \brief This function compute the number of times a value is contained in the stream
+ * \param[in] sag stream handle
+ * \param[in] val value to search
+ * \return returns number of times the value appear
+*/
+int MySAGFreq(const MySAG *sag, int val)
+{
+	return sag->freq_cnt[freq_find(sag, val)];
+}
+
+/** \brief Function to compute MAX value of stream (full scan)
+ *
+ * \param[in] sag stream handle
  * \return returns maximum value of stream
 */
-int MySAGMax()
+int MySAGMaxScan(const MySAG *sag)
 {
 	int max = INT_MIN;
 
-	for(unsigned int i=0; i < n_elements; i++)
+	for(unsigned int i=0; i < sag->n_elements; i++)
 	{
-		if(stream[i] > max)
-			max = stream[i];
+		if(sag->stream[i] > max)
+			max = sag->stream[i];
 	}
 
 	return max;
 }
 
-/** \brief Function to compute MIN value of stream
- * 
+/** \brief Function to compute MIN value of stream (full scan)
+ *
+ * \param[in] sag stream handle
  * \return returns minimum value of stream
 */
-int MySAGMin()
+int MySAGMinScan(const MySAG *sag)
 {
 	int min = INT_MAX;
 
-	for(unsigned int i=0; i < n_elements; i++)
+	for(unsigned int i=0; i < sag->n_elements; i++)
 	{
-		if(stream[i] < min)
-			min = stream[i];
+		if(sag->stream[i] < min)
+			min = sag->stream[i];
 	}
 
 	return min;
 }
 
-/** \brief Function to compute average value of stream
- * 
+/** \brief Function to compute average value of stream (full scan)
+ *
+ * \param[in] sag stream handle
  * \return returns average value of stream
 */
-int MySAGAvg()
+int MySAGAvgScan(const MySAG *sag)
 {
-	int sum = 0;
+	long long sum = 0;
+
+	if(sag->n_elements == 0)
+		return 0;
 
-	for(unsigned int i=0; i < n_elements; i++)
+	for(unsigned int i=0; i < sag->n_elements; i++)
 	{
-		sum += stream[i];
+		sum += sag->stream[i];
 	}
 
-	return sum / n_elements;
+	return (int)(sum / sag->n_elements);
 }
 
-/** \brief This function compute the number of times a value is contained in the stream
+/** \brief This function compute the number of times a value is contained in the stream (full scan)
+ * \param[in] sag stream handle
  * \param[in] val value to search
  * \return returns number of times the value appear
 */
-int MySAGFreq(int val)
+int MySAGFreqScan(const MySAG *sag, int val)
 {
 	int count = 0;
 
-	for(unsigned int i=0; i < n_elements; i++)
+	for(unsigned int i=0; i < sag->n_elements; i++)
 	{
-		if(stream[i] == val)
+		if(sag->stream[i] == val)
 			count++;
 	}
 
 	return count;
-}
\ No newline at end of file
+}
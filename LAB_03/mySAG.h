@@ -1,6 +1,12 @@
-/** \file mySAG.h 
+/** \file mySAG.h
  * \brief Module to manipulate stream of integers
- * 
+ *
+ *  Each stream is a MySAG handle whose storage is supplied by the caller,
+ * either with MYSAG_DEFINE() or with a buffer of MYSAG_BUF_SIZE(N) integers
+ * passed to MySAGCreate(). The module never allocates memory and handles are
+ * independent, so several streams can be used at the same time (one handle
+ * must not be shared between threads without external locking).
+ *
  * \author André Brandão
  * \date 22/03/2022
  */
@@ -8,18 +14,60 @@
 #ifndef _MYSAG_H
 #define _MYSAG_H
 
-/** Maximum Numbers of elements of the stream
- * \def MAXSIZE
+/** Number of integers of storage needed by a stream of N elements
+ * (stream, min/max deques and the 2N slots frequency table)
+ * \def MYSAG_BUF_SIZE
 */
-#define MAXSIZE 100
+#define MYSAG_BUF_SIZE(N) (7 * (N))
 
-int MySAGInit(int);
-void MySAGInsert(int);
+/** Double ended queue of stream positions (circular array) */
+typedef struct {
+	int *idx;	/**< Positions of the stream kept in the deque */
+	int head;	/**< Index of the first element */
+	int len;	/**< Number of elements in the deque */
+} MySAGDeque;
 
-int MySAGMax();
-int MySAGMin();
-int MySAGAvg();
+/** Stream handle */
+typedef struct {
+	int *stream;		/**< Stream to store data */
+	int *freq_key;		/**< Values of the frequency table */
+	int *freq_cnt;		/**< Number of occurrences of each value (0 - free slot) */
+	MySAGDeque max_dq;	/**< Positions of decreasing values, front is the maximum */
+	MySAGDeque min_dq;	/**< Positions of increasing values, front is the minimum */
+	int size;			/**< Size of the stream gyven by user */
+	int n_elements;		/**< Number of elements present in the stream */
+	int pos;			/**< Next position to insert the value in the stream */
+	long long sum;		/**< Sum of the values present in the stream */
+} MySAG;
 
-int MySAGFreq(int);
+/** Defines a stream handle called name, with static storage for N elements.
+ * The handle is ready to use (no need to call MySAGCreate())
+ * \def MYSAG_DEFINE
+*/
+#define MYSAG_DEFINE(name, N) \
+	static int name##_buf[MYSAG_BUF_SIZE(N)]; \
+	static MySAG name = { \
+		.stream = name##_buf, \
+		.freq_key = name##_buf + (N), \
+		.freq_cnt = name##_buf + 3 * (N), \
+		.max_dq = { .idx = name##_buf + 5 * (N) }, \
+		.min_dq = { .idx = name##_buf + 6 * (N) }, \
+		.size = (N) \
+	}
+
+int MySAGCreate(MySAG *, int *, int);
+void MySAGInsert(MySAG *, int);
+
+int MySAGMax(const MySAG *);
+int MySAGMin(const MySAG *);
+int MySAGAvg(const MySAG *);
+
+int MySAGFreq(const MySAG *, int);
+
+/* Reference implementations (full scan of the stream), used by the tests and benchmark */
+int MySAGMaxScan(const MySAG *);
+int MySAGMinScan(const MySAG *);
+int MySAGAvgScan(const MySAG *);
+int MySAGFreqScan(const MySAG *, int);
 
-#endif //_MYSAG_H
\ No newline at end of file
+#endif //_MYSAG_H
@@ -4,31 +4,221 @@
 /*    Simple example of command processor                */
 /*    Note that there are several simplifications        */
 /*    E.g. Kp, Ti and Td usually are not integer values  */
-/*    Code can (and should) be improved. E.g. error      */ 
+/*    Code can (and should) be improved. E.g. error      */
 /*        codes are "magic numbers" in the middle of the */
 /*        code instead of being (defined) text literals  */
+/*                                                       */
+/*    newCmdChar() only stores the chars in a circular   */
+/*    receive buffer, that can hold several frames.      */
+/*    cmdProcessor() drains it one char at a time into   */
+/*    a state machine driven by the command table        */
+/*    (payload size and handler per command char, see    */
+/*    registerCmd()), computing the checksum             */
+/*    as the chars arrive and executing each command as  */
+/*    soon as its EOF is parsed. A partial frame at the  */
+/*    end of the buffer is kept for the next call.       */
 /* ***************************************************** */
 
 #include <stdio.h>
 
 #include "cmdproc.h"
 
+/* Parser states */
+#define ST_IDLE 0	/* Waiting for SOF */
+#define ST_CMD  1	/* Waiting for the command byte */
+#define ST_DATA 2	/* Receiving the command payload */
+#define ST_CS   3	/* Waiting for the checksum */
+#define ST_EOF  4	/* Waiting for EOF */
+#define ST_SKIP 5	/* Unknown command, discarding chars until EOF */
+
+#if (CMD_RX_BUF_SIZE & (CMD_RX_BUF_SIZE - 1)) != 0
+#error "CMD_RX_BUF_SIZE must be a power of 2"
+#endif
+
+/* Command table entry */
+typedef struct {
+	unsigned char len;	/* Payload size (chars between command and checksum) */
+	cmdHandler handler;	/* Function that executes the command (NULL if unknown command) */
+} cmdEntry;
+
+/* Command table, indexed by the command char */
+static cmdEntry cmdTable[256];
+static int cmdTableReady = 0;	/* Built-in commands registered */
+
 /* PID parameters */
 /* Note that in a real application these vars would be extern */
 char Kp, Ti, Td;
 
-/* Process variables */ 
+/* Process variables */
 /* Note that in a real application these vars would be extern */
-int setpoint, output, error; 
+int setpoint, output, error;
+
+/* Receive buffer (free running indexes, wrapped with a mask) */
+static unsigned char rxBuf[CMD_RX_BUF_SIZE];	/* Chars not yet parsed */
+static unsigned int rxHead = 0;					/* Next position to write (newCmdChar()) */
+static unsigned int rxTail = 0;					/* Next position to read (cmdProcessor()) */
 
 /* Internal variables */
-static char cmdString[MAX_CMDSTRING_SIZE];
-static unsigned char cmdStringLen = 0; 
-char CS;
+static unsigned char cmdString[MAX_PAYLOAD_SIZE];	/* Payload of the current frame */
+static unsigned char cmdStringLen = 0;				/* Payload chars received */
+static unsigned char frameLen = 0;					/* Chars of the current frame (SOF included) */
+static unsigned char frameCmd = 0;					/* Command char of the current frame */
+static unsigned char state = ST_IDLE;				/* Parser state */
+static cmdEntry curCmd;								/* Command of the current frame, latched at its start */
+static int frameCheck = 0;							/* Result of the current frame, known at the checksum */
+static cmdCallback frameCallback = NULL;			/* Called at the end of every frame */
+unsigned char CS;									/* Running checksum of the current frame */
+
+/* *************************************** */
+/* P command - sets Kp, Ti and Td          */
+/* *************************************** */
+static int cmdSetPID(const unsigned char *payload, unsigned char len)
+{
+	(void)len;
+
+	Kp = payload[0];
+	Ti = payload[1];
+	Td = payload[2];
+	return 0;
+}
+
+/* *************************************** */
+/* S command - prints setpoint, output and */
+/* error                                   */
+/* *************************************** */
+static int cmdStatus(const unsigned char *payload, unsigned char len)
+{
+	(void)payload;
+	(void)len;
+
+	printf("Setpoint = %d, Output = %d, Error = %d", setpoint, output, error);
+	return 0;
+}
+
+/* *************************************** */
+/* W command - writes the setpoint         */
+/* (2 chars, most significant first)       */
+/* *************************************** */
+static int cmdWriteSetpoint(const unsigned char *payload, unsigned char len)
+{
+	(void)len;
+
+	setpoint = (payload[0] << 8) | payload[1];
+	return 0;
+}
+
+/* *************************************** */
+/* G command - prints all the parameters   */
+/* *************************************** */
+static int cmdReadParams(const unsigned char *payload, unsigned char len)
+{
+	(void)payload;
+	(void)len;
+
+	printf("Kp = %d, Ti = %d, Td = %d, Setpoint = %d", Kp, Ti, Td, setpoint);
+	return 0;
+}
+
+/* *************************************** */
+/* Registers the built-in commands         */
+/* *************************************** */
+static void initCmdTable(void)
+{
+	cmdTableReady = 1;
+	registerCmd('P', 3, cmdSetPID);
+	registerCmd('S', 0, cmdStatus);
+	registerCmd('W', 2, cmdWriteSetpoint);
+	registerCmd('G', 0, cmdReadParams);
+}
+
+/* ************************************************** */
+/* Ends the current frame, executing its command when */
+/* valid, and reports it to the frame callback        */
+/* Returns the frame result                           */
+/* ************************************************** */
+static int frameDone(int res)
+{
+	state = ST_IDLE;
+
+	if(res == 0)
+		res = curCmd.handler(cmdString, curCmd.len);
+
+	if(frameCallback != NULL)
+		frameCallback(frameCmd, res);
+
+	return res;
+}
+
+/* ************************************************ */
+/* Parses one char                                  */
+/* Returns:                                         */
+/*      -1: if no frame was completed               */
+/*      -4: if the char is outside of a frame       */
+/*      the frame result if the char ended a frame  */
+/* ************************************************ */
+static int parseChar(unsigned char newChar)
+{
+	/* Frame too long, drop it and wait for the next SOF */
+	if(state != ST_IDLE && ++frameLen > MAX_CMDSTRING_SIZE)
+		return frameDone(-4);
+
+	switch(state) {
+		case ST_IDLE:
+			if(newChar != SOF_SYM)
+				return -4;	/* Chars outside of a frame */
+			frameLen = 1;
+			state = ST_CMD;
+			break;
+
+		case ST_CMD:
+			if(!cmdTableReady)
+				initCmdTable();
+			frameCmd = newChar;
+			curCmd = cmdTable[newChar];	/* Copy, registerCmd() may change the table during the frame */
+			if(curCmd.handler == NULL) {
+				state = ST_SKIP;
+				break;
+			}
+			CS = newChar;
+			cmdStringLen = 0;
+			state = (curCmd.len > 0) ? ST_DATA : ST_CS;
+			break;
+
+		case ST_DATA:
+			if(cmdStringLen >= sizeof(cmdString))
+				return frameDone(-4);	/* Defensive, len is checked by registerCmd() */
+			cmdString[cmdStringLen++] = newChar;
+			CS += newChar;
+			if(cmdStringLen >= curCmd.len)
+				state = ST_CS;
+			break;
+
+		case ST_CS:
+			frameCheck = (newChar == CS) ? 0 : -3;
+			state = ST_EOF;
+			break;
+
+		case ST_EOF:
+			return frameDone((newChar == EOF_SYM) ? frameCheck : -4);
+
+		case ST_SKIP:
+			if(newChar == EOF_SYM)
+				return frameDone(-2);
+			break;
+
+		default:
+			state = ST_IDLE;
+			break;
+	}
+
+	return -1;
+}
 
 /* ************************************************************ */
 /* Processes the the chars received so far looking for commands */
-/* Returns:                                                     */
+/* Executes the commands of all complete frames in the buffer,  */
+/* calling the frame callback (if set) for each one             */
+/* Returns the result of the last frame:                        */
 /*  	 0: if a valid command was found and executed           */
 /* 	-1: if empty string or incomplete command found             */
 /* 	-2: if an invalid command was found                         */
@@ -37,67 +227,17 @@ char CS;
 /* ************************************************************ */
 int cmdProcessor(void)
 {
-	int i,j;
-	
-	/* Detect empty cmd string */
-	if(cmdStringLen == 0)
-		return -1; 
-	
-	/* Find index of SOF */
-	for(i=0; i < cmdStringLen; i++) {
-		if(cmdString[i] == SOF_SYM) {
-			break;
-		}
-	}
+	int res = -1, r;
 
-	/* Find index of EOF_SYM */
-	for(j=i; j < cmdStringLen; j++) {
-		if(cmdString[j] == EOF_SYM) {
-			break;
-		}
-	}
+	while(rxTail != rxHead) {
+		r = parseChar(rxBuf[rxTail & (CMD_RX_BUF_SIZE - 1)]);
+		rxTail++;
 
-	/* If EOF_SYM not found return  -4 */
-	if(j == cmdStringLen)
-		return -4;
-
-	/* If a SOF was found look for commands */
-	if(i < cmdStringLen) {
-		if(cmdString[i+1] == 'P') { /* P command detected */
-			
-			/* If checksum error return -3 */
-			CS = cmdString[i+1] + cmdString[i+2] + cmdString[i+3] + cmdString[i+4];
-			
-			if(CS != cmdString[i+5])
-				return -3;
-			
-			Kp = cmdString[i+2];
-			Ti = cmdString[i+3];
-			Td = cmdString[i+4];
-			resetCmdString();
-			return 0;
-		}
-		
-		if(cmdString[i+1] == 'S') { /* S command detected */
-
-			/* If checksum error return -3 */
-			CS = cmdString[i+1];
-			
-			if(CS != cmdString[i+2])
-				return -3;
-			
-			printf("Setpoint = %d, Output = %d, Error = %d", setpoint, output, error);
-			resetCmdString();
-			return 0;
-		}
-
-		/* Invalid Command */
-		return -2;	
+		if(r != -1)
+			res = r;
 	}
-	
-	/* cmd string not null and SOF not found */
-	return -4;
 
+	return res;
 }
 
 /* ******************************** */
@@ -105,25 +245,59 @@ int cmdProcessor(void)
 /* Returns: 				        */
 /*  	 0: if success 		        */
 /* 		-1: if cmd string full 	    */
+/*          (receive buffer full)   */
 /* ******************************** */
 int newCmdChar(unsigned char newChar)
 {
-	/* If cmd string not full add char to it */
-	if (cmdStringLen < MAX_CMDSTRING_SIZE) {
-		cmdString[cmdStringLen] = newChar;
-		cmdStringLen +=1;
-		return 0;		
+	/* If receive buffer not full add char to it */
+	if (rxHead - rxTail < CMD_RX_BUF_SIZE) {
+		rxBuf[rxHead & (CMD_RX_BUF_SIZE - 1)] = newChar;
+		rxHead++;
+		return 0;
 	}
-	
-	/* If cmd string full return error */
+
+	/* If receive buffer full return error */
 	return -1;
 }
 
-/* ************************** */
-/* Resets the commanbd string */  
-/* ************************** */
+/* ************************************************ */
+/* Resets the commanbd string                       */
+/* Discards the receive buffer and the current frame */
+/* ************************************************ */
 void resetCmdString(void)
 {
-	cmdStringLen = 0;		
+	rxTail = rxHead;
+	state = ST_IDLE;
+	frameLen = 0;
+	cmdStringLen = 0;
 	return;
 }
+
+/* ******************************************* */
+/* Sets the function called at the end of each */
+/* frame (NULL to disable)                     */
+/* ******************************************* */
+void setCmdCallback(cmdCallback cb)
+{
+	frameCallback = cb;
+}
+
+/* ************************************************ */
+/* Adds (or replaces) a command of the command table */
+/* A NULL handler removes the command               */
+/* Returns:                                         */
+/*       0: if success                              */
+/*      -1: if payload too big or cmd is SOF or EOF */
+/* ************************************************ */
+int registerCmd(unsigned char cmd, unsigned char len, cmdHandler handler)
+{
+	if(len > MAX_PAYLOAD_SIZE || cmd == SOF_SYM || cmd == EOF_SYM)
+		return -1;
+
+	if(!cmdTableReady)
+		initCmdTable();
+
+	cmdTable[cmd].len = len;
+	cmdTable[cmd].handler = handler;
+	return 0;
+}
@@ -4,13 +4,29 @@
 /* Some defines */
 /* Other defines should be return codes of the functions */
 /* E.g. #define CMD_EMPTY_STRING -1                      */
-#define MAX_CMDSTRING_SIZE 10 /* Maximum size of the command string */ 
+#define MAX_CMDSTRING_SIZE 10 /* Maximum size of a frame, from SOF to EOF */
 #define SOF_SYM '#'	          /* Start of Frame Symbol */
 #define EOF_SYM '!'           /* End of Frame Symbol */
+#define MAX_PAYLOAD_SIZE (MAX_CMDSTRING_SIZE - 4) /* Maximum payload of a command (frame without SOF, cmd, CS and EOF) */
+
+/* Size of the receive buffer (power of 2), holds several frames */
+#ifndef CMD_RX_BUF_SIZE
+#define CMD_RX_BUF_SIZE 128
+#endif
+
+/* Called by cmdProcessor() for every frame, with the command */
+/* char and the frame result (see cmdProcessor() return codes) */
+typedef void (*cmdCallback)(unsigned char cmd, int res);
+
+/* Executes a command, given its payload (len chars)   */
+/* Returns 0 if success or a cmdProcessor() error code */
+typedef int (*cmdHandler)(const unsigned char *payload, unsigned char len);
 
 /* Function prototypes */
 int cmdProcessor(void);
 int newCmdChar(unsigned char newChar);
 void resetCmdString(void);
+void setCmdCallback(cmdCallback cb);
+int registerCmd(unsigned char cmd, unsigned char len, cmdHandler handler);
 
 #endif
@@ -0,0 +1,105 @@
+/*
+* This is a throughput benchmark for cmdproc module
+*
+* Feeds a long stream of frames (with some garbage between them)
+* to newCmdChar(), calling cmdProcessor() after every char as
+* a UART polling loop would. The first run reports bytes and frames
+* per second, the second one times every char and reports the
+* average and worst-case per-byte latency.
+*
+* Author: Andre Brandao - 93021
+* Author: Emanuel Pereira - 93235
+*/
+
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdio.h>
+#include <time.h>
+#include "cmdproc.h"
+
+#define NFRAMES 2000000L	/* Number of frames sent on the throughput run */
+#define NFRAMES_LAT 200000L	/* Number of frames sent on the latency run */
+
+/* Builds frame i of the stream, returns its size */
+static int buildFrame(long i, unsigned char *frame)
+{
+	int len = 0;
+
+	if(i % 8 == 0)
+		frame[len++] = '\n';	/* Garbage between frames */
+	frame[len++] = SOF_SYM;
+	frame[len++] = 'P';
+	frame[len++] = (unsigned char)('0' + i % 10);
+	frame[len++] = (unsigned char)('0' + i % 7);
+	frame[len++] = (unsigned char)('0' + i % 3);
+	frame[len] = (unsigned char)(frame[len-4] + frame[len-3] + frame[len-2] + frame[len-1]);
+	len++;
+	frame[len++] = EOF_SYM;
+
+	return len;
+}
+
+/* Current time in nanoseconds */
+static double nowNs(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+int main(void)
+{
+	unsigned char frame[10];
+	long i, bytes = 0, frames = 0;
+	int j, len;
+	clock_t start;
+	double secs, t0, t, worst = 0, total = 0;
+
+	/* Throughput */
+	resetCmdString();
+	start = clock();
+
+	for(i = 0; i < NFRAMES; i++) {
+		len = buildFrame(i, frame);
+
+		for(j = 0; j < len; j++) {
+			newCmdChar(frame[j]);
+			if(cmdProcessor() == 0)
+				frames++;
+		}
+		bytes += len;
+	}
+
+	secs = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+	printf("%ld bytes, %ld/%ld frames in %.3f s\n", bytes, frames, NFRAMES, secs);
+	printf("%.1f MB/s, %.0f frames/s\n", bytes / secs / 1e6, frames / secs);
+
+	if(frames != NFRAMES)
+		return 1;
+
+	/* Per-byte latency (includes the timer overhead) */
+	resetCmdString();
+	bytes = 0;
+
+	for(i = 0; i < NFRAMES_LAT; i++) {
+		len = buildFrame(i, frame);
+
+		for(j = 0; j < len; j++) {
+			t0 = nowNs();
+			newCmdChar(frame[j]);
+			cmdProcessor();
+			t = nowNs() - t0;
+
+			total += t;
+			if(t > worst)
+				worst = t;
+		}
+		bytes += len;
+	}
+
+	printf("per-byte latency: avg %.1f ns, worst %.0f ns\n", total / bytes, worst);
+
+	return 0;
+}
@@ -0,0 +1,106 @@
+/* 
+* This is a fuzz target for cmdproc module
+*
+* LLVMFuzzerTestOneInput() is the libFuzzer entry point. The first
+* input char sets how many chars are given to newCmdChar() between
+* cmdProcessor() calls (0 - only when the receive buffer is full), the
+* remaining chars are the received stream. Any out of range return
+* code aborts, so the fuzzer reports it together with the sanitizers.
+*
+* When built with FUZZ_STANDALONE (AFL or corpus replay) main() runs
+* it once for each file in the command line, or for stdin if none.
+*
+* Author: Andre Brandao - 93021
+* Author: Emanuel Pereira - 93235 
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "cmdproc.h"
+
+#define MAX_INPUT_SIZE 65536	/* Biggest input read in standalone mode */
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size);
+
+/* Frame callback, frames can only end with these results */
+static void checkFrame(unsigned char cmd, int res)
+{
+	(void)cmd;
+
+	if(res != 0 && res != -2 && res != -3 && res != -4)
+		abort();
+}
+
+/* Checks a cmdProcessor() return code */
+static void checkResult(int res)
+{
+	if(res > 0 || res < -4)
+		abort();
+}
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+	size_t i;
+	unsigned char period;
+
+	if(size == 0)
+		return 0;
+
+	period = data[0];
+	resetCmdString();
+	setCmdCallback(checkFrame);
+
+	for(i = 1; i < size; i++) {
+		if(newCmdChar(data[i]) == -1) {
+			checkResult(cmdProcessor());
+
+			/* After draining the buffer the char must fit */
+			if(newCmdChar(data[i]) != 0)
+				abort();
+		}
+
+		if(period != 0 && i % period == 0)
+			checkResult(cmdProcessor());
+	}
+
+	checkResult(cmdProcessor());
+	setCmdCallback(NULL);
+
+	return 0;
+}
+
+#ifdef FUZZ_STANDALONE
+/* Runs the fuzz target over one input file */
+static int runFile(FILE *f)
+{
+	static uint8_t buf[MAX_INPUT_SIZE];
+	size_t len;
+
+	len = fread(buf, 1, sizeof(buf), f);
+	return LLVMFuzzerTestOneInput(buf, len);
+}
+
+int main(int argc, char **argv)
+{
+	FILE *f;
+	int i;
+
+	if(argc < 2)
+		return runFile(stdin);
+
+	for(i = 1; i < argc; i++) {
+		f = fopen(argv[i], "rb");
+		if(f == NULL) {
+			printf("Can't open %s\n", argv[i]);
+			return 1;
+		}
+		runFile(f);
+		fclose(f);
+	}
+
+	printf("\n%d inputs OK\n", argc - 1);
+	return 0;
+}
+#endif
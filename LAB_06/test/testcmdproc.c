@@ -8,6 +8,9 @@
 #include <unity.h>
 #include "cmdproc.h"
 
+extern char Kp, Ti, Td;
+extern int setpoint;
+
 void setUp(void)
 {
 	return;
@@ -43,19 +46,19 @@ void test_1(void)
 /* Check cmd string full return error */
 void test_2(void)
 {
+	int i;
+
 	resetCmdString();
 	newCmdChar('#');
 	newCmdChar('R');
-	newCmdChar('1');
-	newCmdChar('2');
-	newCmdChar('3');
-	newCmdChar('3');
-	newCmdChar('3');
-	newCmdChar('3');
-	newCmdChar('3');
-	newCmdChar('3');
+	for(i = 2; i < CMD_RX_BUF_SIZE; i++)
+		TEST_ASSERT_EQUAL_INT(0, newCmdChar('3'));
 
 	TEST_ASSERT_EQUAL_INT(-1, newCmdChar('3'));
+
+	/* Frame longer than MAX_CMDSTRING_SIZE is dropped */
+	TEST_ASSERT_EQUAL_INT(-4, cmdProcessor());
+	TEST_ASSERT_EQUAL_INT(0, newCmdChar('3'));
 }
 
 void test_3(void)
@@ -124,6 +127,227 @@ void test_5(void)
 	TEST_ASSERT_EQUAL_INT(-3, cmdProcessor());
 }
 
+void test_6(void)
+{
+	/* Check garbage before the frame is skipped */
+	resetCmdString();
+	newCmdChar('x');
+	newCmdChar('y');
+	newCmdChar('#');
+	newCmdChar('P');
+	newCmdChar('4');
+	newCmdChar('5');
+	newCmdChar('6');
+	newCmdChar((unsigned char)('P'+'4'+'5'+'6'));
+	newCmdChar('!');
+
+	TEST_ASSERT_EQUAL_INT(0, cmdProcessor());
+
+	/* Check frame received across several calls */
+	newCmdChar('#');
+	newCmdChar('P');
+	newCmdChar('1');
+	TEST_ASSERT_EQUAL_INT(-1, cmdProcessor());
+
+	newCmdChar('2');
+	newCmdChar('3');
+	TEST_ASSERT_EQUAL_INT(-1, cmdProcessor());
+
+	newCmdChar((unsigned char)('P'+'1'+'2'+'3'));
+	newCmdChar('!');
+	TEST_ASSERT_EQUAL_INT(0, cmdProcessor());
+	TEST_ASSERT_EQUAL_INT(-1, cmdProcessor());
+}
+
+/* Frame results reported by the callback */
+static int cbOk, cbInvalid, cbCs, cbFormat;
+
+static void countFrame(unsigned char cmd, int res)
+{
+	(void)cmd;
+
+	switch(res) {
+		case 0: cbOk++; break;
+		case -2: cbInvalid++; break;
+		case -3: cbCs++; break;
+		case -4: cbFormat++; break;
+		default: break;
+	}
+}
+
+/* Sends one P frame, returns -1 if the receive buffer got full */
+static int sendP(unsigned char a, unsigned char b, unsigned char c, unsigned char cs)
+{
+	unsigned char frame[7];
+	int i;
+
+	frame[0] = '#';
+	frame[1] = 'P';
+	frame[2] = a;
+	frame[3] = b;
+	frame[4] = c;
+	frame[5] = cs;
+	frame[6] = '!';
+
+	for(i = 0; i < 7; i++) {
+		/* Drain the buffer when full, as the main loop would */
+		if(newCmdChar(frame[i]) == -1) {
+			cmdProcessor();
+			if(newCmdChar(frame[i]) == -1)
+				return -1;
+		}
+	}
+
+	return 0;
+}
+
+void test_7(void)
+{
+	int i;
+
+	/* Check several frames executed in one call */
+	resetCmdString();
+	setCmdCallback(countFrame);
+	cbOk = cbInvalid = cbCs = cbFormat = 0;
+
+	for(i = 0; i < 10; i++)
+		sendP('1', '2', '3', (unsigned char)('P'+'1'+'2'+'3'));
+
+	/* Partial next frame is kept */
+	newCmdChar('#');
+	newCmdChar('P');
+
+	TEST_ASSERT_EQUAL_INT(0, cmdProcessor());
+	TEST_ASSERT_EQUAL_INT(10, cbOk);
+
+	newCmdChar('4');
+	newCmdChar('5');
+	newCmdChar('6');
+	newCmdChar((unsigned char)('P'+'4'+'5'+'6'));
+	newCmdChar('!');
+
+	TEST_ASSERT_EQUAL_INT(0, cmdProcessor());
+	TEST_ASSERT_EQUAL_INT(11, cbOk);
+	setCmdCallback(NULL);
+}
+
+void test_8(void)
+{
+	int i;
+
+	/* Check burst of frames with garbage and errors in between */
+	resetCmdString();
+	setCmdCallback(countFrame);
+	cbOk = cbInvalid = cbCs = cbFormat = 0;
+
+	for(i = 0; i < 1200; i++) {
+		if(i % 10 == 0) {	/* Garbage, parser must resync on next SOF */
+			newCmdChar('\r');
+			newCmdChar('\n');
+		}
+
+		if(i % 100 == 0)
+			TEST_ASSERT_EQUAL_INT(0, sendP('1', '2', '3', 0));	/* Checksum error */
+		else
+			TEST_ASSERT_EQUAL_INT(0, sendP('1', '2', '3', (unsigned char)('P'+'1'+'2'+'3')));
+	}
+
+	cmdProcessor();
+	TEST_ASSERT_EQUAL_INT(1188, cbOk);
+	TEST_ASSERT_EQUAL_INT(12, cbCs);
+	TEST_ASSERT_EQUAL_INT(0, cbInvalid);
+	TEST_ASSERT_EQUAL_INT(0, cbFormat);
+	setCmdCallback(NULL);
+}
+
+/* Custom command used to check the registration */
+static unsigned char customPayload[MAX_PAYLOAD_SIZE];
+
+static int cmdCustom(const unsigned char *payload, unsigned char len)
+{
+	unsigned char i;
+
+	for(i = 0; i < len; i++)
+		customPayload[i] = payload[i];
+
+	return 0;
+}
+
+void test_9(void)
+{
+	/* Check command registration */
+	TEST_ASSERT_EQUAL_INT(-1, registerCmd('X', MAX_PAYLOAD_SIZE + 1, cmdCustom));
+	TEST_ASSERT_EQUAL_INT(-1, registerCmd(SOF_SYM, 1, cmdCustom));
+	TEST_ASSERT_EQUAL_INT(0, registerCmd('X', MAX_PAYLOAD_SIZE, cmdCustom));
+
+	resetCmdString();
+	newCmdChar('#');
+	newCmdChar('X');
+	newCmdChar('a');
+	newCmdChar('b');
+	newCmdChar('c');
+	newCmdChar('d');
+	newCmdChar('e');
+	newCmdChar('f');
+	newCmdChar((unsigned char)('X'+'a'+'b'+'c'+'d'+'e'+'f'));
+	newCmdChar('!');
+
+	TEST_ASSERT_EQUAL_INT(0, cmdProcessor());
+	TEST_ASSERT_EQUAL_INT('a', customPayload[0]);
+	TEST_ASSERT_EQUAL_INT('f', customPayload[5]);
+
+	/* Command changed in the middle of a frame, the frame keeps the old length */
+	newCmdChar('#');
+	newCmdChar('X');
+	newCmdChar('a');
+	newCmdChar('b');
+	newCmdChar('c');
+	TEST_ASSERT_EQUAL_INT(-1, cmdProcessor());
+	TEST_ASSERT_EQUAL_INT(0, registerCmd('X', 1, cmdCustom));
+	newCmdChar('d');
+	newCmdChar('e');
+	newCmdChar('g');
+	newCmdChar((unsigned char)('X'+'a'+'b'+'c'+'d'+'e'+'g'));
+	newCmdChar('!');
+
+	TEST_ASSERT_EQUAL_INT(0, cmdProcessor());
+	TEST_ASSERT_EQUAL_INT('g', customPayload[5]);
+
+	/* Removed command is invalid */
+	registerCmd('X', 0, NULL);
+	newCmdChar('#');
+	newCmdChar('X');
+	newCmdChar((unsigned char)('X'));
+	newCmdChar('!');
+
+	TEST_ASSERT_EQUAL_INT(-2, cmdProcessor());
+
+	/* Check built-in setpoint write */
+	newCmdChar('#');
+	newCmdChar('W');
+	newCmdChar(0x01);
+	newCmdChar(0x2C);
+	newCmdChar((unsigned char)('W'+0x01+0x2C));
+	newCmdChar('!');
+
+	TEST_ASSERT_EQUAL_INT(0, cmdProcessor());
+	TEST_ASSERT_EQUAL_INT(300, setpoint);
+
+	/* Check P command sets the parameters */
+	newCmdChar('#');
+	newCmdChar('P');
+	newCmdChar(7);
+	newCmdChar(8);
+	newCmdChar(9);
+	newCmdChar((unsigned char)('P'+7+8+9));
+	newCmdChar('!');
+
+	TEST_ASSERT_EQUAL_INT(0, cmdProcessor());
+	TEST_ASSERT_EQUAL_INT(7, Kp);
+	TEST_ASSERT_EQUAL_INT(8, Ti);
+	TEST_ASSERT_EQUAL_INT(9, Td);
+}
+
 int main(void)
 {
 	UNITY_BEGIN();
@@ -133,6 +357,10 @@ int main(void)
 	RUN_TEST(test_3);
 	RUN_TEST(test_4);
 	RUN_TEST(test_5);
+	RUN_TEST(test_6);
+	RUN_TEST(test_7);
+	RUN_TEST(test_8);
+	RUN_TEST(test_9);
 			
 	return UNITY_END();
 }
\ No newline at end of file
@@ -0,0 +1,106 @@
+/** \file buttons.c
+ * 	\brief Module implementing debounced push-buttons that post events to an event queue
+ *
+ *  The interrupt only stamps, masks and schedules (the GPIO sense of the pin detects the
+ * edge, there is no polling), the check runs on the system work queue. The semaphore is
+ * given after each put, so the consumer can sleep on it and drain the queue.
+ *
+ *  \author André Brandão
+ *  \author Emanuel Pereira
+ *  \date 10/05/2022
+ */
+
+#include <buttons.h>
+
+static const struct device *gpio_dev;   /**< GPIO port of the buttons */
+static struct button *button_table;     /**< Buttons */
+static int nbuttons;                    /**< Number of buttons */
+static struct event_queue *event_q;     /**< Queue of the events */
+static struct k_sem *event_ready;       /**< Given after each event put */
+static struct gpio_callback buttons_cb_data;    /**< Callback of the buttons pins */
+static uint32_t glitches;               /**< Edges shorter than the debounce time */
+
+/** \brief Callback function of the interrupt from the buttons
+ *
+ *  Masks the pins that interrupted and schedules their debounce check.
+*/
+static void buttons_cbfunction(const struct device *dev, struct gpio_callback *cb, uint32_t pins)
+{
+    uint32_t now = k_cycle_get_32();
+
+    for(int i = 0; i < nbuttons; i++)
+    {
+        if(BIT(button_table[i].pin) & pins)
+        {
+            gpio_pin_interrupt_configure(dev, button_table[i].pin, GPIO_INT_DISABLE);
+            button_table[i].stamp = now;
+            k_work_schedule(&button_table[i].debounce, K_MSEC(BUTTONS_DEBOUNCE_MS));
+        }
+    }
+}
+
+/** \brief Debounce check of a button, posts the event if the pin held the level of the edge */
+static void buttons_debounce(struct k_work *work)
+{
+    struct button *b = CONTAINER_OF(k_work_delayable_from_work(work), struct button, debounce);
+    int active = (b->irq == GPIO_INT_EDGE_TO_ACTIVE);
+    struct vm_event ev = { .type = b->type, .pin = b->pin, .value = b->value, .stamp = b->stamp };
+
+    if(gpio_pin_get(gpio_dev, b->pin) == active)
+    {
+        if(event_queue_put(event_q, &ev) == 0)
+            k_sem_give(event_ready);
+    }
+    else
+        glitches++;
+
+    gpio_pin_interrupt_configure(gpio_dev, b->pin, b->irq);    // Unmask
+}
+
+/** \brief Function to configure the buttons
+ *
+ *  Configures the pins as inputs with pull-up and their interrupts.
+ *
+ *  \param[in] dev GPIO port of the buttons
+ *  \param[in] buttons buttons (pin, irq, type and value set, kept by the module)
+ *  \param[in] n number of buttons
+ *  \param[in] queue queue of the events (initialized)
+ *  \param[in] ready semaphore given after each event put
+ *
+ *  \returns 0 on success, -1 on a bad argument or GPIO error
+ */
+int buttons_init(const struct device *dev, struct button *buttons, int n, struct event_queue *queue, struct k_sem *ready)
+{
+    gpio_port_pins_t mask = 0;
+
+    if(dev == NULL || n < 1 || n > BUTTONS_MAX)
+        return -1;
+
+    gpio_dev = dev;
+    button_table = buttons;
+    nbuttons = n;
+    event_q = queue;
+    event_ready = ready;
+    glitches = 0;
+
+    for(int i = 0; i < n; i++)
+    {
+        k_work_init_delayable(&buttons[i].debounce, buttons_debounce);
+        if(gpio_pin_configure(dev, buttons[i].pin, GPIO_INPUT | GPIO_PULL_UP) != 0 ||
+           gpio_pin_interrupt_configure(dev, buttons[i].pin, buttons[i].irq) != 0)
+            return -1;
+        mask |= BIT(buttons[i].pin);
+    }
+
+    gpio_init_callback(&buttons_cb_data, buttons_cbfunction, mask);
+    if(gpio_add_callback(dev, &buttons_cb_data) != 0)
+        return -1;
+
+    return 0;
+}
+
+/** \brief Function to get the number of edges shorter than the debounce time */
+uint32_t buttons_glitches_get(void)
+{
+    return glitches;
+}
@@ -0,0 +1,38 @@
+/** \file buttons.h
+ * 	\brief Module implementing debounced push-buttons that post events to an event queue
+ *
+ *  Each button is described by a struct button (pin, interrupt edge and event posted).
+ * The first edge of a press interrupts, the interrupt stamps the time, masks the pin and
+ * schedules a check at the end of the debounce time (k_work_delayable, no busy wait): if the
+ * pin is still at the level of the edge the event is put on the queue with the time of the
+ * edge, otherwise it was a glitch. The pin is unmasked after the check, so the bounces of a
+ * press never interrupt.
+ *
+ * \author André Brandão
+ * \author Emanuel Pereira
+ * \date 10/05/2022
+ */
+#ifndef _BUTTONS_H
+#define _BUTTONS_H
+
+#include <zephyr.h>
+#include <drivers/gpio.h>
+#include <event_queue.h>
+
+#define BUTTONS_DEBOUNCE_MS 5   /**< Time a press must hold its level (ms) */
+#define BUTTONS_MAX 32          /**< Most buttons (pins of a GPIO port) */
+
+/** Push-button */
+struct button {
+    gpio_pin_t pin;             /**< GPIO pin */
+    gpio_flags_t irq;           /**< Edge of the event (GPIO_INT_EDGE_TO_ACTIVE or GPIO_INT_EDGE_TO_INACTIVE) */
+    uint8_t type;               /**< Event type posted */
+    uint16_t value;             /**< Event value posted */
+    uint32_t stamp;             /**< Time of the last edge (hardware cycles) */
+    struct k_work_delayable debounce;   /**< Check at the end of the debounce time */
+};
+
+int buttons_init(const struct device *dev, struct button *buttons, int n, struct event_queue *queue, struct k_sem *ready);
+uint32_t buttons_glitches_get(void);
+
+#endif // _BUTTONS_H
@@ -0,0 +1,305 @@
+/** \file catalog.c
+ * 	\brief Module implementing the product catalog of the vending machine
+ *
+ *  The items are an array indexed by the slot id, plus the list of the used slots in
+ * ascending order (to browse the products). A mutex protects them from the concurrent
+ * updates of the console. A changed slot is marked dirty and a delayed work item on the
+ * catalog work queue saves the dirty slots, so several changes share the flash writes.
+ *  The settings key is parsed only at boot (settings_load_subtree()).
+ *
+ *  \author André Brandão
+ *  \author Emanuel Pereira
+ *  \date 10/05/2022
+ */
+
+#include <zephyr.h>
+#include <settings/settings.h>
+#include <sys/printk.h>
+#include <string.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <catalog.h>
+#include <display.h>
+
+#define CATALOG_KEY "vm/slot"       /**< Settings subtree of the slots */
+#define CATALOG_STACK_SIZE 1024     /**< Stack of the work queue that writes the flash */
+#define CATALOG_WORKQ_PRIO 10       /**< Priority of the work queue (lowest of the application) */
+
+/** Catalog when the flash has none */
+static const struct catalog_item catalog_default[] = {
+    { "Beer", MONEY_CENTS(1, 50), 10, 0 },
+    { "Tuna Sandwich", MONEY_CENTS(1, 0), 10, 1 },
+    { "Coffee", MONEY_CENTS(0, 50), 10, 2 },
+};
+
+static struct catalog_item items[CATALOG_MAX_SLOTS];    /**< Items, indexed by the slot id */
+static uint8_t order[CATALOG_MAX_SLOTS];    /**< Used slots, ascending */
+static int nused;                           /**< Number of used slots */
+static uint64_t dirty;                      /**< Slots to save (bit per slot) */
+static K_MUTEX_DEFINE(catalog_mutex);       /**< Mutual exclusion on the catalog */
+
+K_THREAD_STACK_DEFINE(catalog_stack, CATALOG_STACK_SIZE);
+static struct k_work_q catalog_workq;       /**< Work queue of the flash writes */
+static struct k_work_delayable save_work;   /**< Save of the dirty slots */
+
+BUILD_ASSERT(CATALOG_MAX_SLOTS <= 64, "dirty has a bit per slot");
+
+/** \brief Adds a slot to the used slots list (catalog locked) */
+static void order_add(int slot)
+{
+    int i;
+
+    for(i = nused; i > 0 && order[i - 1] > slot; i--)
+        order[i] = order[i - 1];
+    order[i] = slot;
+    nused++;
+}
+
+/** \brief Marks a slot to save and schedules the save (catalog locked) */
+static void mark_dirty(int slot)
+{
+    dirty |= (uint64_t)1 << slot;
+    k_work_schedule_for_queue(&catalog_workq, &save_work, K_MSEC(CATALOG_SAVE_DELAY_MS));
+}
+
+/** \brief Saves the dirty slots in flash (catalog work queue) */
+static void catalog_save(struct k_work *work)
+{
+    struct catalog_item item;
+    char key[sizeof(CATALOG_KEY) + 4];
+    uint64_t todo;
+
+    k_mutex_lock(&catalog_mutex, K_FOREVER);
+    todo = dirty;
+    dirty = 0;
+    k_mutex_unlock(&catalog_mutex);
+
+    for(int slot = 0; todo != 0; slot++, todo >>= 1)
+    {
+        if(!(todo & 1))
+            continue;
+
+        k_mutex_lock(&catalog_mutex, K_FOREVER);
+        item = items[slot];
+        k_mutex_unlock(&catalog_mutex);
+
+        snprintk(key, sizeof(key), CATALOG_KEY "/%d", slot);
+        if(settings_save_one(key, &item, sizeof(item)) != 0)
+            display_printk("\nError saving slot %d of the catalog\n", slot);
+    }
+}
+
+/** \brief Settings handler, loads the record of a slot ("vm/slot/<id>") */
+static int catalog_settings_set(const char *key, size_t len, settings_read_cb read_cb, void *cb_arg)
+{
+    struct catalog_item item;
+    int slot = atoi(key);
+
+    if(len != sizeof(item) || slot < 0 || slot >= CATALOG_MAX_SLOTS)
+        return -EINVAL;     // Record of another version, ignored
+
+    if(read_cb(cb_arg, &item, sizeof(item)) != sizeof(item))
+        return -EIO;
+
+    item.name[CATALOG_NAME_SIZE - 1] = '\0';
+    item.slot = slot;
+    if(items[slot].name[0] == '\0' && item.name[0] != '\0')
+        order_add(slot);
+    items[slot] = item;
+
+    return 0;
+}
+
+SETTINGS_STATIC_HANDLER_DEFINE(catalog, CATALOG_KEY, NULL, catalog_settings_set, NULL, NULL);
+
+/** \brief Function to initialize the catalog
+ *
+ *  Loads the catalog from flash, or the default catalog (saved) if the flash has none,
+ * and starts the work queue of the flash writes.
+ *
+ *  \returns 0 on success, -1 if the settings storage failed (the default catalog is used, not saved)
+ */
+int catalog_init(void)
+{
+    int err;
+
+    k_work_queue_start(&catalog_workq, catalog_stack, K_THREAD_STACK_SIZEOF(catalog_stack),
+                       CATALOG_WORKQ_PRIO, NULL);
+    k_work_init_delayable(&save_work, catalog_save);
+
+    err = settings_subsys_init();
+    if(err == 0)
+        err = settings_load_subtree(CATALOG_KEY);
+
+    if(nused == 0)
+    {
+        for(int i = 0; i < (int)ARRAY_SIZE(catalog_default); i++)
+            catalog_set(catalog_default[i].slot, catalog_default[i].name, catalog_default[i].price,
+                        catalog_default[i].stock);
+    }
+
+    return err == 0 ? 0 : -1;
+}
+
+/** \brief Function to get the number of used slots */
+int catalog_count(void)
+{
+    return nused;
+}
+
+/** \brief Function to get the slot id of a position of the used slots list
+ *
+ *  \param[in] pos position, 0 to catalog_count() - 1
+ *
+ *  \returns slot id, -1 if pos is out of the list
+ */
+int catalog_slot(int pos)
+{
+    int slot = -1;
+
+    k_mutex_lock(&catalog_mutex, K_FOREVER);
+    if(pos >= 0 && pos < nused)
+        slot = order[pos];
+    k_mutex_unlock(&catalog_mutex);
+
+    return slot;
+}
+
+/** \brief Function to get the product of a slot
+ *
+ *  \param[in] slot slot id
+ *  \param[out] item copy of the product
+ *
+ *  \returns 0 on success, -1 if the slot is not used
+ */
+int catalog_get(int slot, struct catalog_item *item)
+{
+    int err = -1;
+
+    if(slot < 0 || slot >= CATALOG_MAX_SLOTS)
+        return -1;
+
+    k_mutex_lock(&catalog_mutex, K_FOREVER);
+    if(items[slot].name[0] != '\0')
+    {
+        *item = items[slot];
+        err = 0;
+    }
+    k_mutex_unlock(&catalog_mutex);
+
+    return err;
+}
+
+/** \brief Function to add a product to a slot, or replace it
+ *
+ *  \param[in] slot slot id
+ *  \param[in] name product name (truncated to CATALOG_NAME_SIZE - 1 characters)
+ *  \param[in] price price (cents)
+ *  \param[in] stock number of products
+ *
+ *  \returns 0 on success, -1 on a bad argument
+ */
+int catalog_set(int slot, const char *name, money_t price, uint16_t stock)
+{
+    if(slot < 0 || slot >= CATALOG_MAX_SLOTS || name == NULL || name[0] == '\0' || price < 0)
+        return -1;
+
+    k_mutex_lock(&catalog_mutex, K_FOREVER);
+    if(items[slot].name[0] == '\0')
+        order_add(slot);
+    strncpy(items[slot].name, name, CATALOG_NAME_SIZE - 1);
+    items[slot].name[CATALOG_NAME_SIZE - 1] = '\0';
+    items[slot].price = price;
+    items[slot].stock = stock;
+    items[slot].slot = slot;
+    mark_dirty(slot);
+    k_mutex_unlock(&catalog_mutex);
+
+    return 0;
+}
+
+/** \brief Function to change the price of a product
+ *
+ *  \returns 0 on success, -1 if the slot is not used or the price is negative
+ */
+int catalog_price_set(int slot, money_t price)
+{
+    int err = -1;
+
+    if(slot < 0 || slot >= CATALOG_MAX_SLOTS || price < 0)
+        return -1;
+
+    k_mutex_lock(&catalog_mutex, K_FOREVER);
+    if(items[slot].name[0] != '\0')
+    {
+        items[slot].price = price;
+        mark_dirty(slot);
+        err = 0;
+    }
+    k_mutex_unlock(&catalog_mutex);
+
+    return err;
+}
+
+/** \brief Function to change the stock of a product
+ *
+ *  \returns 0 on success, -1 if the slot is not used
+ */
+int catalog_stock_set(int slot, uint16_t stock)
+{
+    int err = -1;
+
+    if(slot < 0 || slot >= CATALOG_MAX_SLOTS)
+        return -1;
+
+    k_mutex_lock(&catalog_mutex, K_FOREVER);
+    if(items[slot].name[0] != '\0')
+    {
+        items[slot].stock = stock;
+        mark_dirty(slot);
+        err = 0;
+    }
+    k_mutex_unlock(&catalog_mutex);
+
+    return err;
+}
+
+/** \brief Function to take one product out of the stock of a slot
+ *
+ *  \param[in] slot slot id
+ *
+ *  \returns 0 on success, -1 if the slot is not used or is out of stock
+ */
+int catalog_sell(int slot)
+{
+    int err = -1;
+
+    if(slot < 0 || slot >= CATALOG_MAX_SLOTS)
+        return -1;
+
+    k_mutex_lock(&catalog_mutex, K_FOREVER);
+    if(items[slot].name[0] != '\0' && items[slot].stock > 0)
+    {
+        items[slot].stock--;
+        mark_dirty(slot);
+        err = 0;
+    }
+    k_mutex_unlock(&catalog_mutex);
+
+    return err;
+}
+
+/** \brief Function to print the catalog */
+void catalog_print(void)
+{
+    struct catalog_item item;
+    char price[MONEY_STR_SIZE];
+
+    display_printk("\nSlot  Product              Price      Stock");
+    for(int pos = 0; pos < nused; pos++)
+    {
+        if(catalog_get(catalog_slot(pos), &item) == 0)
+            display_printk("\n%4u  %-19s  %7s €  %5u", item.slot, item.name, money_format(item.price, price), item.stock);
+    }
+    display_printk("\n");
+}
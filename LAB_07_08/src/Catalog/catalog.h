@@ -0,0 +1,43 @@
+/** \file catalog.h
+ * 	\brief Module implementing the product catalog of the vending machine
+ *
+ *  The catalog has up to CATALOG_MAX_SLOTS slots, each with the name, the price (cents) and
+ * the stock of its product. The items are kept in RAM indexed by the slot id, so a lookup is
+ * a copy of one item, and are persisted in flash with the settings subsystem (NVS backend),
+ * one binary record per slot ("vm/slot/<id>"), loaded at boot.
+ *  Changes (console updates, sales) are written to flash by a low priority work queue a
+ * moment later, so the state machine never waits for the flash.
+ *
+ * \author André Brandão
+ * \author Emanuel Pereira
+ * \date 10/05/2022
+ */
+#ifndef _CATALOG_H
+#define _CATALOG_H
+
+#include <stdint.h>
+#include <money.h>
+
+#define CATALOG_MAX_SLOTS 64    /**< Number of slots of the machine */
+#define CATALOG_NAME_SIZE 20    /**< Size of a product name, with the terminator */
+#define CATALOG_SAVE_DELAY_MS 100   /**< Delay of the flash write after a change (ms) */
+
+/** Product of a slot, also the record saved in flash */
+struct catalog_item {
+    char name[CATALOG_NAME_SIZE];   /**< Product name, empty if the slot is not used */
+    money_t price;                  /**< Price (cents) */
+    uint16_t stock;                 /**< Number of products in the slot */
+    uint8_t slot;                   /**< Slot id */
+};
+
+int catalog_init(void);
+int catalog_count(void);
+int catalog_slot(int pos);
+int catalog_get(int slot, struct catalog_item *item);
+int catalog_set(int slot, const char *name, money_t price, uint16_t stock);
+int catalog_price_set(int slot, money_t price);
+int catalog_stock_set(int slot, uint16_t stock);
+int catalog_sell(int slot);
+void catalog_print(void);
+
+#endif // _CATALOG_H
@@ -0,0 +1,252 @@
+/** \file display.c
+ * 	\brief Module implementing the terminal display of the vending machine
+ *
+ *  The update of the status line finds the first byte that changed, moves the cursor to its
+ * column (carriage return and ANSI cursor forward) and writes the rest of the line, clearing
+ * the end of the old one if the new one is shorter. The columns are counted in characters,
+ * the UTF-8 continuation bytes (the euro sign) take none.
+ *  A message ends the status line, the next update draws it whole on a new line, as after
+ * display_printk() or display_invalidate() (other output moved the cursor).
+ *
+ *  \author André Brandão
+ *  \author Emanuel Pereira
+ *  \date 10/05/2022
+ */
+
+#include <zephyr.h>
+#include <sys/printk.h>
+#include <console/console.h>
+#include <timing/timing.h>
+#include <string.h>
+#include <stdarg.h>
+#include <display.h>
+
+#define DISPLAY_BUF_SIZE (DISPLAY_COLS + 18)    /**< Output of one update (line and escape sequences) */
+
+static char shown[DISPLAY_COLS + 1];    /**< Status line on the terminal */
+static int shown_len;                   /**< Length of shown, 0 on a new line, -1 if the cursor is not on it */
+static K_MUTEX_DEFINE(display_mutex);   /**< Mutual exclusion on the terminal */
+
+/** Output statistics */
+static struct {
+    uint32_t updates;       /**< Status line updates written */
+    uint32_t unchanged;     /**< Status line updates with nothing to write */
+    uint32_t messages;      /**< Messages written */
+    uint32_t bytes;         /**< Bytes written */
+    uint64_t cycles;        /**< Time spent in the display (timing cycles) */
+    int64_t start_ms;       /**< Uptime of the start of the statistics (ms) */
+} stats;
+
+/** \brief Writes bytes to the terminal, not counted (display_mutex held) */
+static void display_out(const char *buf, int n)
+{
+#if DISPLAY_ASYNC
+    console_write(NULL, buf, n);    // Copy to the transmit ring, waits only if the ring is full
+#else
+    printk("%.*s", n, buf);
+#endif
+}
+
+/** \brief Writes bytes of the status line or a message to the terminal (display_mutex held) */
+static void display_write(const char *buf, int n)
+{
+    display_out(buf, n);
+    stats.bytes += n;
+}
+
+/** \brief Column of a byte of a UTF-8 string */
+static int display_column(const char *s, int i)
+{
+    int col = 0;
+
+    for(int k = 0; k < i; k++)
+        if((s[k] & 0xc0) != 0x80)
+            col++;
+
+    return col;
+}
+
+/** \brief Function to initialize the display
+ *
+ *  Initializes the console (also used to read the operator commands) and the timing
+ * functions of the statistics.
+ *
+ *  \returns 0 on success, error of console_init() otherwise
+ */
+int display_init(void)
+{
+    timing_init();
+    timing_start();
+    display_stats_reset();
+    shown_len = 0;
+
+    return console_init();
+}
+
+/** \brief Function to show the status line
+ *
+ *  \param[in] fmt format of the line (printk), truncated to DISPLAY_COLS bytes
+ */
+void display_status(const char *fmt, ...)
+{
+    char line[DISPLAY_COLS + 1];
+    char out[DISPLAY_BUF_SIZE];
+    int len, i = 0, n = 0;
+    timing_t start, end;
+    va_list ap;
+
+    k_mutex_lock(&display_mutex, K_FOREVER);
+    start = timing_counter_get();
+
+    va_start(ap, fmt);
+    vsnprintk(line, sizeof(line), fmt, ap);
+    va_end(ap);
+    len = strlen(line);
+
+    if(shown_len < 0)
+    {
+        memcpy(out, "\r\n", 2);      // Draw the line whole on a new line
+        n = 2;
+        shown_len = 0;
+    }
+
+#if DISPLAY_DIFF
+    while(i < len && i < shown_len && line[i] == shown[i])
+        i++;
+    while(i > 0 && (line[i] & 0xc0) == 0x80)
+        i--;    // Start of the character that changed
+
+    if(i == len && len == shown_len)
+    {
+        stats.unchanged++;
+    }
+    else
+    {
+        if(i == 0)
+            n += snprintk(out + n, sizeof(out) - n, "\r");
+        else
+            n += snprintk(out + n, sizeof(out) - n, "\r\33[%dC", display_column(line, i));   // Cursor on the first change
+        memcpy(out + n, line + i, len - i);
+        n += len - i;
+        if(len < shown_len)
+        {
+            memcpy(out + n, "\33[K", 3);    // Clear the end of the old line
+            n += 3;
+        }
+    }
+#else
+    n += snprintk(out + n, sizeof(out) - n, "\r\33[2K%s", line);
+#endif
+
+    if(n > 0)
+    {
+        display_write(out, n);
+        memcpy(shown, line, len + 1);
+        shown_len = len;
+        stats.updates++;
+    }
+
+    end = timing_counter_get();
+    stats.cycles += timing_cycles_get(&start, &end);
+    k_mutex_unlock(&display_mutex);
+}
+
+/** \brief Function to show a message, on its own line below the status line
+ *
+ *  \param[in] fmt format of the message (printk), truncated to DISPLAY_COLS bytes
+ */
+void display_message(const char *fmt, ...)
+{
+    char out[DISPLAY_BUF_SIZE];
+    int n;
+    timing_t start, end;
+    va_list ap;
+
+    k_mutex_lock(&display_mutex, K_FOREVER);
+    start = timing_counter_get();
+
+    n = snprintk(out, sizeof(out), "\r\n");
+    va_start(ap, fmt);
+    n += vsnprintk(out + n, DISPLAY_COLS + 1, fmt, ap);
+    va_end(ap);
+    if(n > DISPLAY_COLS + 2)
+        n = DISPLAY_COLS + 2;   // Truncated
+    out[n++] = '\r';
+    out[n++] = '\n';
+
+    display_write(out, n);
+    shown_len = 0;      // Status line on a new line
+    stats.messages++;
+
+    end = timing_counter_get();
+    stats.cycles += timing_cycles_get(&start, &end);
+    k_mutex_unlock(&display_mutex);
+}
+
+/** \brief Function to print other output of the application (in place of printk)
+ *
+ *  The output leaves the status line, the next update draws it on a new line. Each new line
+ * is sent as carriage return and new line (as printk on the UART console). Not counted in
+ * the statistics.
+ *
+ *  \param[in] fmt format (printk), truncated to DISPLAY_PRINT_SIZE - 1 bytes
+ */
+void display_printk(const char *fmt, ...)
+{
+    static char text[DISPLAY_PRINT_SIZE];       // Static, used under display_mutex
+    static char out[2 * DISPLAY_PRINT_SIZE];
+    int len, n = 0;
+    va_list ap;
+
+    k_mutex_lock(&display_mutex, K_FOREVER);
+
+    va_start(ap, fmt);
+    len = vsnprintk(text, sizeof(text), fmt, ap);
+    va_end(ap);
+    if(len > (int)sizeof(text) - 1)
+        len = sizeof(text) - 1;     // Truncated
+
+    for(int i = 0; i < len; i++)
+    {
+        if(text[i] == '\n')
+            out[n++] = '\r';
+        out[n++] = text[i];
+    }
+
+    display_out(out, n);
+    shown_len = -1;     // The cursor left the status line
+
+    k_mutex_unlock(&display_mutex);
+}
+
+/** \brief Function to tell the display that other output moved the cursor off the status line */
+void display_invalidate(void)
+{
+    k_mutex_lock(&display_mutex, K_FOREVER);
+    shown_len = -1;
+    k_mutex_unlock(&display_mutex);
+}
+
+/** \brief Function to print the output statistics
+ *
+ *  Bytes written per minute and time spent in the display since the last reset.
+ */
+void display_stats_print(void)
+{
+    int64_t ms = k_uptime_get() - stats.start_ms;
+    uint64_t us = timing_cycles_to_ns(stats.cycles) / 1000;
+
+    display_printk("\nDisplay: %u updates (%u unchanged), %u messages, %u bytes in %u s, %u bytes/min, %u us in output (%s, %s)\n",
+           stats.updates, stats.unchanged, stats.messages, stats.bytes, (uint32_t)(ms / 1000),
+           ms > 0 ? (uint32_t)((uint64_t)stats.bytes * 60000 / ms) : 0, (uint32_t)us,
+           DISPLAY_DIFF ? "diff" : "redraw", DISPLAY_ASYNC ? "tx ring" : "printk");
+}
+
+/** \brief Function to reset the output statistics */
+void display_stats_reset(void)
+{
+    k_mutex_lock(&display_mutex, K_FOREVER);
+    memset(&stats, 0, sizeof(stats));
+    stats.start_ms = k_uptime_get();
+    k_mutex_unlock(&display_mutex);
+}
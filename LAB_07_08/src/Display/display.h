@@ -0,0 +1,37 @@
+/** \file display.h
+ * 	\brief Module implementing the terminal display of the vending machine
+ *
+ *  The display has a status line (product, cost, stock, credit) and messages (products
+ * dispensed, credit returned, ...). The module keeps the status line shown on the terminal
+ * and writes only the characters that changed since (moving the cursor over the equal ones),
+ * nothing if the line is the same. The output goes to the transmit ring of the console,
+ * emptied by the UART interrupt, so a write only copies the bytes.
+ *  All the output of the application (operator menu, echo, lists and statistics) goes
+ * through the module, display_printk() in place of printk(), under one mutex, so its bytes
+ * are never mixed with the ones of an update of the status line.
+ *  The bytes written and the time spent in the display are counted, DISPLAY_DIFF and
+ * DISPLAY_ASYNC set to 0 give the old output (whole line by polled printk) to compare.
+ *
+ * \author André Brandão
+ * \author Emanuel Pereira
+ * \date 10/05/2022
+ */
+#ifndef _DISPLAY_H
+#define _DISPLAY_H
+
+#include <stdint.h>
+
+#define DISPLAY_COLS 80     /**< Longest status line (bytes) */
+#define DISPLAY_DIFF 1      /**< 1 to write only the changes of the status line, 0 to redraw it */
+#define DISPLAY_ASYNC 1     /**< 1 to write to the console transmit ring (interrupt driven), 0 by printk */
+#define DISPLAY_PRINT_SIZE 160  /**< Longest output of display_printk() (bytes), the rest is truncated */
+
+int display_init(void);
+void display_status(const char *fmt, ...);
+void display_message(const char *fmt, ...);
+void display_printk(const char *fmt, ...);
+void display_invalidate(void);
+void display_stats_print(void);
+void display_stats_reset(void);
+
+#endif // _DISPLAY_H
@@ -0,0 +1,129 @@
+/** \file event_queue.c
+ * 	\brief Module implementing a lock-free multi-producer single-consumer queue of input events
+ *
+ *  Bounded queue with a sequence number per slot (D. Vyukov): slot i starts with the sequence
+ * number i, the producer of event n waits for the sequence number n (the slot is free), claims
+ * n moving the head with a compare-and-swap, writes the event and stores n + 1 (release).
+ * The consumer of event n waits for n + 1 (acquire), reads the event and stores n + size,
+ * the number the producer of event n + size waits for. The head and tail are free running
+ * counters, the index is the counter modulo the size (a power of 2).
+ *  The event put by an interrupt that preempted a producer between the claim and the publish
+ * is only seen by the consumer after that producer finishes, the consumer reads it as empty
+ * meanwhile, so the producers must signal the consumer after each put (not before).
+ *
+ *  \author André Brandão
+ *  \author Emanuel Pereira
+ *  \date 10/05/2022
+ */
+
+#include <stddef.h>
+#include <event_queue.h>
+
+/** \brief Function to initialize a queue
+ *
+ *  \param[in] q queue (storage from EVENT_QUEUE_DEFINE())
+ *
+ *  \returns 0 on success, -1 if the size is not a power of 2
+ */
+int event_queue_init(struct event_queue *q)
+{
+    if(q->size == 0 || (q->size & (q->size - 1)) != 0)
+        return -1;
+
+    for(uint32_t i = 0; i < q->size; i++)
+        __atomic_store_n(&q->seq[i], i, __ATOMIC_RELAXED);
+
+    __atomic_store_n(&q->overflows, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&q->high_water, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&q->tail, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&q->head, 0, __ATOMIC_RELEASE);
+
+    return 0;
+}
+
+/** \brief Function to put an event on the queue (any thread or interrupt)
+ *
+ *  \param[in] q queue
+ *  \param[in] ev event
+ *
+ *  \returns 0 on success, -1 if the queue is full (the event is dropped)
+ */
+int event_queue_put(struct event_queue *q, const struct vm_event *ev)
+{
+    uint32_t pos = __atomic_load_n(&q->head, __ATOMIC_RELAXED);
+    uint32_t seq, used, max;
+    int32_t diff;
+
+    for(;;)
+    {
+        seq = __atomic_load_n(&q->seq[pos & (q->size - 1)], __ATOMIC_ACQUIRE);
+        diff = (int32_t)(seq - pos);
+
+        if(diff == 0)   // Slot free, claim it (pos is reloaded if another producer did it first)
+        {
+            if(__atomic_compare_exchange_n(&q->head, &pos, pos + 1, 0, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+                break;
+        }
+        else if(diff < 0)   // Slot still holds the event put size events ago, full
+        {
+            __atomic_fetch_add(&q->overflows, 1, __ATOMIC_RELAXED);
+            return -1;
+        }
+        else    // Another producer claimed this slot
+            pos = __atomic_load_n(&q->head, __ATOMIC_RELAXED);
+    }
+
+    q->events[pos & (q->size - 1)] = *ev;
+    __atomic_store_n(&q->seq[pos & (q->size - 1)], pos + 1, __ATOMIC_RELEASE);  // Publish the event
+
+    used = pos + 1 - __atomic_load_n(&q->tail, __ATOMIC_RELAXED);
+    max = __atomic_load_n(&q->high_water, __ATOMIC_RELAXED);
+    while(used > max && used <= q->size &&
+          !__atomic_compare_exchange_n(&q->high_water, &max, used, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+        ;
+
+    return 0;
+}
+
+/** \brief Function to get the oldest event of the queue (consumer only)
+ *
+ *  \param[in] q queue
+ *  \param[out] ev event
+ *
+ *  \returns 0 on success, -1 if the queue is empty
+ */
+int event_queue_get(struct event_queue *q, struct vm_event *ev)
+{
+    uint32_t pos = __atomic_load_n(&q->tail, __ATOMIC_RELAXED);
+    uint32_t seq = __atomic_load_n(&q->seq[pos & (q->size - 1)], __ATOMIC_ACQUIRE);
+
+    if(seq != pos + 1)  // Not published yet
+        return -1;
+
+    *ev = q->events[pos & (q->size - 1)];
+    __atomic_store_n(&q->seq[pos & (q->size - 1)], pos + q->size, __ATOMIC_RELEASE);  // Give the slot back to the producers
+    __atomic_store_n(&q->tail, pos + 1, __ATOMIC_RELAXED);
+
+    return 0;
+}
+
+/** \brief Function to get the number of events on the queue (claimed, maybe not published yet) */
+uint32_t event_queue_count(const struct event_queue *q)
+{
+    uint32_t tail = __atomic_load_n(&q->tail, __ATOMIC_ACQUIRE);
+    uint32_t head = __atomic_load_n(&q->head, __ATOMIC_ACQUIRE);
+
+    return head - tail;
+}
+
+/** \brief Function to get the number of events dropped because the queue was full */
+uint32_t event_queue_overflows_get(const struct event_queue *q)
+{
+    return __atomic_load_n(&q->overflows, __ATOMIC_RELAXED);
+}
+
+/** \brief Function to get the highest number of events in the queue */
+uint32_t event_queue_high_water_get(const struct event_queue *q)
+{
+    return __atomic_load_n(&q->high_water, __ATOMIC_RELAXED);
+}
@@ -0,0 +1,52 @@
+/** \file event_queue.h
+ * 	\brief Module implementing a lock-free multi-producer single-consumer queue of input events
+ *
+ *  Any number of interrupts and threads put events, one thread gets them, without locks:
+ * a producer claims a slot with a compare-and-swap on the head and publishes it with the
+ * sequence number of the slot, so a producer preempted in the middle does not block the others.
+ * A full queue drops the new event, the drops are counted (overflows), as the highest
+ * number of events waiting in the queue (high water mark).
+ *  The storage is given by the user (EVENT_QUEUE_DEFINE()), there is no dynamic memory.
+ *
+ * \author André Brandão
+ * \author Emanuel Pereira
+ * \date 10/05/2022
+ */
+#ifndef _EVENT_QUEUE_H
+#define _EVENT_QUEUE_H
+
+#include <stdint.h>
+
+/** Input event */
+struct vm_event {
+    uint8_t type;       /**< Event type (defined by the application) */
+    uint8_t pin;        /**< Pin of the input */
+    uint16_t value;     /**< Value of the event (the coin value in cents) */
+    uint32_t stamp;     /**< Time of the input (hardware cycles) */
+};
+
+/** Multi-producer single-consumer queue of events */
+struct event_queue {
+    struct vm_event *events;    /**< Events, event n is at events[n % size] */
+    uint32_t *seq;              /**< Sequence number of each slot (n + 1 when event n is published) */
+    uint32_t size;              /**< Number of events (power of 2) */
+    uint32_t head;              /**< Events claimed by the producers */
+    uint32_t tail;              /**< Events got (written by the consumer) */
+    uint32_t overflows;         /**< Events dropped because the queue was full */
+    uint32_t high_water;        /**< Highest number of events in the queue */
+};
+
+/** Declares the storage of a queue of N events, N a power of 2 (call event_queue_init() before use) */
+#define EVENT_QUEUE_DEFINE(name, N) \
+    static struct vm_event name##_events[N]; \
+    static uint32_t name##_seq[N]; \
+    static struct event_queue name = { .events = name##_events, .seq = name##_seq, .size = (N) }
+
+int event_queue_init(struct event_queue *q);
+int event_queue_put(struct event_queue *q, const struct vm_event *ev);
+int event_queue_get(struct event_queue *q, struct vm_event *ev);
+uint32_t event_queue_count(const struct event_queue *q);
+uint32_t event_queue_overflows_get(const struct event_queue *q);
+uint32_t event_queue_high_water_get(const struct event_queue *q);
+
+#endif // _EVENT_QUEUE_H
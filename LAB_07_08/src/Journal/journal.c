@@ -0,0 +1,339 @@
+/** \file journal.c
+ * 	\brief Module implementing the transaction journal of the vending machine
+ *
+ *  A flash entry is a batch: a header (sequence number of the first record, number of
+ * records, CRC32 of the sequence number, the number and the records) and the records.
+ * The records go from journal_append() to the journal thread by a message queue, a copy
+ * with no wait, so the state machine never waits for the flash (a page erase takes
+ * tens of ms). A record not yet written when the power fails is lost, at most
+ * JOURNAL_BATCH_MS after the transaction.
+ *
+ *  \author André Brandão
+ *  \author Emanuel Pereira
+ *  \date 10/05/2022
+ */
+
+#include <zephyr.h>
+#include <storage/flash_map.h>
+#include <fs/fcb.h>
+#include <sys/crc.h>
+#include <sys/printk.h>
+#include <timing/timing.h>
+#include <errno.h>
+#include <journal.h>
+#include <display.h>
+
+#define JOURNAL_MAGIC 0x314a4d56    /**< Magic of the FCB sectors ("VMJ1") */
+#define JOURNAL_STACK_SIZE 1024     /**< Stack of the journal thread */
+#define JOURNAL_PRIO 10             /**< Priority of the journal thread (lowest of the application) */
+#define JOURNAL_PRINT_MAX 32        /**< Most records printed by journal_print() */
+
+/* An erase of the journal must never reach the settings of the catalog (NVS on the storage partition) */
+BUILD_ASSERT(FLASH_AREA_OFFSET(journal) + FLASH_AREA_SIZE(journal) <= FLASH_AREA_OFFSET(storage) ||
+             FLASH_AREA_OFFSET(storage) + FLASH_AREA_SIZE(storage) <= FLASH_AREA_OFFSET(journal),
+             "journal partition overlaps the storage partition");
+
+/** Header of a batch */
+struct journal_hdr {
+    uint32_t seq;       /**< Sequence number of the first record */
+    uint16_t count;     /**< Number of records */
+    uint16_t reserved;  /**< Zero */
+    uint32_t crc;       /**< CRC32 of seq, count, reserved and the records */
+};
+
+/** Batch, as written in flash */
+struct journal_batch {
+    struct journal_hdr hdr;                 /**< Header */
+    struct journal_rec rec[JOURNAL_BATCH];  /**< Records (hdr.count) */
+};
+
+K_MSGQ_DEFINE(journal_queue, sizeof(struct journal_rec), JOURNAL_QUEUE_SIZE, 4);    /**< Records to write */
+K_THREAD_STACK_DEFINE(journal_stack, JOURNAL_STACK_SIZE);
+static struct k_thread journal_thread_data;
+
+static struct fcb journal_fcb;          /**< Flash circular buffer of the journal */
+static struct flash_sector journal_sectors[JOURNAL_MAX_SECTORS];
+static uint32_t next_seq;               /**< Sequence number of the next record */
+static int ready;                       /**< FCB initialized */
+
+/** Statistics */
+static struct {
+    uint32_t appended;      /**< Records appended */
+    uint32_t lost;          /**< Records lost, queue full */
+    uint32_t written;       /**< Records written */
+    uint32_t batches;       /**< Batches written */
+    uint32_t rotations;     /**< Sectors erased to free space */
+    uint32_t errors;        /**< Batches not written (flash error) */
+    uint32_t replayed;      /**< Records read at boot */
+    uint32_t bad;           /**< Batches with a bad CRC or size at boot */
+    uint32_t mismatches;    /**< Records not following the one before (credit or sequence) at boot */
+    uint64_t append_max;    /**< Longest journal_append() (timing cycles) */
+} stats;
+
+/** Last records read by journal_print() */
+struct journal_last {
+    struct journal_rec rec[JOURNAL_PRINT_MAX];  /**< Records, record n at n % JOURNAL_PRINT_MAX */
+    uint32_t seq[JOURNAL_PRINT_MAX];            /**< Sequence numbers of the records */
+    uint32_t n;                                 /**< Records read */
+};
+
+/** State of the boot replay */
+struct journal_replay {
+    money_t credit;     /**< Credit after the last record */
+    uint32_t next;      /**< Sequence number after the last record */
+    int any;            /**< Some record was read */
+};
+
+/** \brief CRC32 of a batch */
+static uint32_t journal_crc(const struct journal_batch *b)
+{
+    uint32_t crc = crc32_ieee((const uint8_t *)&b->hdr, offsetof(struct journal_hdr, crc));
+
+    return crc32_ieee_update(crc, (const uint8_t *)b->rec, b->hdr.count * sizeof(struct journal_rec));
+}
+
+/** \brief Credit after a record applied to a credit */
+static money_t journal_apply(money_t credit, const struct journal_rec *r)
+{
+    switch(r->type)
+    {
+        case JOURNAL_COIN:
+            return credit + r->amount;
+        case JOURNAL_SALE:
+            return credit - r->amount;
+        default:
+            return 0;   // Returned
+    }
+}
+
+/** \brief Reads a batch of the FCB, returns 0 if it is valid */
+static int journal_read(struct fcb_entry_ctx *ctx, struct journal_batch *b)
+{
+    uint16_t len = ctx->loc.fe_data_len;
+
+    if(len < sizeof(b->hdr) || len > sizeof(*b) ||
+       flash_area_read(ctx->fap, FCB_ENTRY_FA_DATA_OFF(ctx->loc), b, len) != 0 ||
+       b->hdr.count == 0 || len != sizeof(b->hdr) + b->hdr.count * sizeof(struct journal_rec) ||
+       journal_crc(b) != b->hdr.crc)
+        return -1;
+
+    return 0;
+}
+
+/** \brief FCB walk callback of the boot replay */
+static int journal_replay_cb(struct fcb_entry_ctx *ctx, void *arg)
+{
+    struct journal_replay *rp = arg;
+    struct journal_batch b;
+
+    if(journal_read(ctx, &b) != 0)
+    {
+        stats.bad++;
+        return 0;
+    }
+
+    for(int i = 0; i < b.hdr.count; i++)
+    {
+        if(rp->any && (b.hdr.seq + i != rp->next || journal_apply(rp->credit, &b.rec[i]) != b.rec[i].credit))
+            stats.mismatches++;
+
+        rp->credit = b.rec[i].credit;
+        rp->next = b.hdr.seq + i + 1;
+        rp->any = 1;
+        stats.replayed++;
+    }
+
+    return 0;
+}
+
+/** \brief Writes a batch, erasing the oldest sector if the FCB is full */
+static int journal_write(struct journal_batch *b)
+{
+    struct fcb_entry loc;
+    uint16_t len = sizeof(b->hdr) + b->hdr.count * sizeof(struct journal_rec);
+    int err;
+
+    b->hdr.crc = journal_crc(b);
+
+    err = fcb_append(&journal_fcb, len, &loc);
+    if(err == -ENOSPC)
+    {
+        stats.rotations++;
+        err = fcb_rotate(&journal_fcb);
+        if(err == 0)
+            err = fcb_append(&journal_fcb, len, &loc);
+    }
+    if(err == 0)
+        err = flash_area_write(journal_fcb.fap, FCB_ENTRY_FA_DATA_OFF(loc), b, len);
+    if(err == 0)
+        err = fcb_append_finish(&journal_fcb, &loc);
+
+    return err;
+}
+
+/** \brief Journal thread, writes the records in batches */
+static void journal_thread(void *argA, void *argB, void *argC)
+{
+    struct journal_batch b;
+    int64_t deadline;
+
+    while(1)
+    {
+        // Wait for a record, then for more until the batch is full or its time is over
+        k_msgq_get(&journal_queue, &b.rec[0], K_FOREVER);
+        deadline = k_uptime_get() + JOURNAL_BATCH_MS;
+        b.hdr.count = 1;
+        while(b.hdr.count < JOURNAL_BATCH && k_uptime_get() < deadline &&
+              k_msgq_get(&journal_queue, &b.rec[b.hdr.count], K_MSEC(deadline - k_uptime_get())) == 0)
+            b.hdr.count++;
+
+        b.hdr.seq = next_seq;
+        b.hdr.reserved = 0;
+        next_seq += b.hdr.count;
+
+        if(journal_write(&b) == 0)
+        {
+            stats.batches++;
+            stats.written += b.hdr.count;
+        }
+        else
+            stats.errors++;
+    }
+}
+
+/** \brief Function to initialize the journal
+ *
+ *  Opens the FCB of the journal partition, reads it back and starts the journal thread.
+ *
+ *  \param[out] credit credit of the last record, 0 if the journal is empty or unreadable
+ *
+ *  \returns number of records read, -1 if the journal partition is not usable
+ *  (the transactions are then not saved)
+ */
+int journal_init(money_t *credit)
+{
+    struct journal_replay rp = { 0 };
+    uint32_t cnt = JOURNAL_MAX_SECTORS;
+
+    *credit = 0;
+
+    if(flash_area_get_sectors(FLASH_AREA_ID(journal), &cnt, journal_sectors) != 0)
+        return -1;
+
+    journal_fcb.f_magic = JOURNAL_MAGIC;
+    journal_fcb.f_version = 1;
+    journal_fcb.f_sector_cnt = cnt;
+    journal_fcb.f_scratch_cnt = 0;
+    journal_fcb.f_sectors = journal_sectors;
+
+    if(fcb_init(FLASH_AREA_ID(journal), &journal_fcb) != 0)
+        return -1;
+
+    fcb_walk(&journal_fcb, NULL, journal_replay_cb, &rp);
+    *credit = rp.credit;
+    next_seq = rp.next;
+    ready = 1;
+
+    k_thread_create(&journal_thread_data, journal_stack, K_THREAD_STACK_SIZEOF(journal_stack),
+                    journal_thread, NULL, NULL, NULL, JOURNAL_PRIO, 0, K_NO_WAIT);
+
+    return stats.replayed;
+}
+
+/** \brief Function to append a transaction to the journal
+ *
+ *  Copies the record to the queue of the journal thread, does not wait.
+ *
+ *  \param[in] type transaction type
+ *  \param[in] slot slot of the product sold (JOURNAL_NO_SLOT if not a sale)
+ *  \param[in] amount amount of the transaction (cents)
+ *  \param[in] credit credit after the transaction (cents)
+ *
+ *  \returns 0 on success, -1 if the journal is not initialized or its queue is full (record lost)
+ */
+int journal_append(enum journal_type type, uint8_t slot, money_t amount, money_t credit)
+{
+    struct journal_rec r = { .type = type, .slot = slot, .amount = amount, .credit = credit };
+    timing_t start, end;
+    uint64_t cycles;
+    int err = -1;
+
+    if(!ready)
+        return -1;
+
+    start = timing_counter_get();
+    if(k_msgq_put(&journal_queue, &r, K_NO_WAIT) == 0)
+    {
+        stats.appended++;
+        err = 0;
+    }
+    else
+        stats.lost++;
+    end = timing_counter_get();
+
+    cycles = timing_cycles_get(&start, &end);
+    if(cycles > stats.append_max)
+        stats.append_max = cycles;
+
+    return err;
+}
+
+/** \brief FCB walk callback of journal_print(), keeps the last records */
+static int journal_print_cb(struct fcb_entry_ctx *ctx, void *arg)
+{
+    struct journal_last *last = arg;
+    struct journal_batch b;
+
+    if(journal_read(ctx, &b) != 0)
+        return 0;
+
+    for(int i = 0; i < b.hdr.count; i++, last->n++)
+    {
+        last->rec[last->n % JOURNAL_PRINT_MAX] = b.rec[i];
+        last->seq[last->n % JOURNAL_PRINT_MAX] = b.hdr.seq + i;
+    }
+
+    return 0;
+}
+
+/** \brief Function to print the last records of the journal (in flash)
+ *
+ *  \param[in] last number of records, up to JOURNAL_PRINT_MAX
+ */
+void journal_print(int last)
+{
+    static const char *type_name[] = { "?", "coin", "sale", "return" };
+    static struct journal_last recs;
+    char amount[MONEY_STR_SIZE], credit[MONEY_STR_SIZE];
+    struct journal_rec *r;
+
+    if(!ready)
+        return;
+
+    if(last > JOURNAL_PRINT_MAX)
+        last = JOURNAL_PRINT_MAX;
+
+    recs.n = 0;
+    fcb_walk(&journal_fcb, NULL, journal_print_cb, &recs);
+
+    display_printk("\n   Seq  Type    Slot     Amount     Credit");
+    for(uint32_t i = recs.n > last ? recs.n - last : 0; i < recs.n; i++)
+    {
+        r = &recs.rec[i % JOURNAL_PRINT_MAX];
+        display_printk("\n%6u  %-6s  %4d  %9s  %9s", recs.seq[i % JOURNAL_PRINT_MAX],
+               type_name[r->type <= JOURNAL_RETURN ? r->type : 0],
+               r->slot == JOURNAL_NO_SLOT ? -1 : r->slot,
+               money_format(r->amount, amount), money_format(r->credit, credit));
+    }
+    display_printk("\n");
+}
+
+/** \brief Function to print the journal statistics */
+void journal_stats_print(void)
+{
+    display_printk("\nJournal: %u records appended (%u lost), %u written in %u batches (%u errors), %u sectors erased, "
+           "longest append %u ns\n", stats.appended, stats.lost, stats.written, stats.batches, stats.errors,
+           stats.rotations, (uint32_t)timing_cycles_to_ns(stats.append_max));
+    display_printk("Boot: %u records read, %u bad batches, %u records not following the previous one\n",
+           stats.replayed, stats.bad, stats.mismatches);
+}
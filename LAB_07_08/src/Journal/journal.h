@@ -0,0 +1,50 @@
+/** \file journal.h
+ * 	\brief Module implementing the transaction journal of the vending machine
+ *
+ *  Every transaction (coin inserted, product sold, credit returned) is appended to a journal
+ * in flash, with the credit after it, so the credit survives a power loss and there is an
+ * audit trail. An append only copies the record to a queue in RAM; the journal thread takes
+ * the records waiting (a batch), and writes them as one entry, with the sequence number of the
+ * first record and a CRC32, to a flash circular buffer (FCB) on the journal partition. The
+ * FCB writes the sectors in turn and erases the oldest when full, spreading the wear.
+ *  At boot the journal is read back: batches with a bad CRC are skipped, the credit is the
+ * credit of the last record, and each record is checked against the one before it.
+ *
+ * \author André Brandão
+ * \author Emanuel Pereira
+ * \date 10/05/2022
+ */
+#ifndef _JOURNAL_H
+#define _JOURNAL_H
+
+#include <stdint.h>
+#include <money.h>
+
+#define JOURNAL_QUEUE_SIZE 32   /**< Records waiting to be written */
+#define JOURNAL_BATCH 8         /**< Most records of a batch (flash entry) */
+#define JOURNAL_BATCH_MS 20     /**< Time a batch waits for more records after the first (ms) */
+#define JOURNAL_MAX_SECTORS 16  /**< Most sectors of the journal partition */
+#define JOURNAL_NO_SLOT 0xff    /**< Slot of the records that are not sales */
+
+/** Transaction types */
+enum journal_type {
+    JOURNAL_COIN = 1,   /**< Coin inserted, amount is the coin */
+    JOURNAL_SALE,       /**< Product sold, amount is the price */
+    JOURNAL_RETURN,     /**< Credit returned, amount is the credit */
+};
+
+/** Transaction record */
+struct journal_rec {
+    uint8_t type;       /**< Transaction type (enum journal_type) */
+    uint8_t slot;       /**< Slot of the product sold, JOURNAL_NO_SLOT otherwise */
+    uint16_t reserved;  /**< Zero */
+    money_t amount;     /**< Amount of the transaction (cents) */
+    money_t credit;     /**< Credit after the transaction (cents) */
+};
+
+int journal_init(money_t *credit);
+int journal_append(enum journal_type type, uint8_t slot, money_t amount, money_t credit);
+void journal_print(int last);
+void journal_stats_print(void);
+
+#endif // _JOURNAL_H
@@ -0,0 +1,44 @@
+/** \file money.c
+ * 	\brief Module implementing the money of the vending machine in integer cents
+ *
+ *  \author André Brandão
+ *  \author Emanuel Pereira
+ *  \date 10/05/2022
+ */
+
+#include <money.h>
+
+/** \brief Function to format an amount of money
+ *
+ *  Writes the amount as euros with two decimals: optional sign, at least one digit of euros,
+ * a dot and the two digits of the cents.
+ *
+ *  \param[in] amount amount (cents)
+ *  \param[out] buf string (MONEY_STR_SIZE characters)
+ *
+ *  \returns buf, so the call can be an argument of printk("%s")
+ */
+char *money_format(money_t amount, char *buf)
+{
+    char digits[MONEY_STR_SIZE];    // Digits, least significant first
+    uint32_t mag = amount < 0 ? 0u - (uint32_t)amount : (uint32_t)amount;   // Also right for INT32_MIN
+    int n = 0, i = 0;
+
+    do {
+        digits[n++] = '0' + mag % 10;
+        mag /= 10;
+    } while(mag > 0 || n < 3);      // At least "0.00"
+
+    if(amount < 0)
+        buf[i++] = '-';
+
+    while(n > 2)
+        buf[i++] = digits[--n];     // Euros
+
+    buf[i++] = '.';
+    buf[i++] = digits[1];           // Cents
+    buf[i++] = digits[0];
+    buf[i] = '\0';
+
+    return buf;
+}
@@ -0,0 +1,25 @@
+/** \file money.h
+ * 	\brief Module implementing the money of the vending machine in integer cents
+ *
+ *  Credit, coins and prices are integer cents (money_t), so adding coins and paying
+ * products is exact, and no floating point is used, in the interrupts or elsewhere.
+ * money_format() writes an amount as euros with two decimals ("1.50", "0.15", "-0.05"),
+ * without printf and without dynamic memory.
+ *
+ * \author André Brandão
+ * \author Emanuel Pereira
+ * \date 10/05/2022
+ */
+#ifndef _MONEY_H
+#define _MONEY_H
+
+#include <stdint.h>
+
+typedef int32_t money_t;    /**< Amount of money (cents) */
+
+#define MONEY_CENTS(euros, cents) ((money_t)(euros) * 100 + (cents))    /**< Amount of euros and cents */
+#define MONEY_STR_SIZE 13   /**< Size of the longest formatted amount ("-21474836.48") with the terminator */
+
+char *money_format(money_t amount, char *buf);
+
+#endif // _MONEY_H
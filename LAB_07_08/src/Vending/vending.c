@@ -0,0 +1,120 @@
+/** \file vending.c
+ * 	\brief Module implementing the state machine of the vending machine
+ *
+ *  The states are the ones of the Statechart. WAIT shows the status line when the machine
+ * enters it and takes the next event, the other states run without events and go back to WAIT.
+ *
+ *  \author André Brandão
+ *  \author Emanuel Pereira
+ *  \date 10/05/2022
+ */
+
+#include <stddef.h>
+#include <vending.h>
+
+/** \brief Enters WAIT: selects a product of the catalog (it may have changed) and shows the status line */
+static void vending_wait(struct vending *vm)
+{
+    const struct vending_env *env = vm->env;
+
+    vm->state = WAIT;
+    vm->product = vm->product % env->count();
+    vm->slot = env->slot(vm->product);
+    env->get(vm->slot, &vm->item);
+    env->output(VM_STATUS, &vm->item, 0, vm->credit);
+}
+
+/** \brief Function to initialize the state machine
+ *
+ *  Starts in WAIT with the first product selected.
+ *
+ *  \param[in] vm state machine
+ *  \param[in] env environment (catalog and output), the catalog must have a product
+ *  \param[in] credit credit available (cents), restored from the journal
+ */
+void vending_init(struct vending *vm, const struct vending_env *env, money_t credit)
+{
+    vm->env = env;
+    vm->credit = credit;
+    vm->product = 0;
+    vm->transitions = 0;
+    vending_wait(vm);
+}
+
+/** \brief Function to run the state machine on an event
+ *
+ *  Runs the states from WAIT until it is back in WAIT.
+ *
+ *  \param[in] vm state machine
+ *  \param[in] ev event (UP, DOWN, SELECT, RETURN, COIN with the value in cents, or REFRESH)
+ */
+void vending_step(struct vending *vm, const struct vm_event *ev)
+{
+    const struct vending_env *env = vm->env;
+    struct catalog_item item;
+
+    do
+    {
+        switch(vm->state)
+        {
+            case WAIT:
+                if(ev->type == COIN)  // Change state to update credit
+                    vm->state = UPDATE_CREDIT;
+
+                else if(ev->type == UP || ev->type == DOWN)     // Change state to update selected product
+                    vm->state = UPDATE_PRODUCT;
+
+                else if(ev->type == RETURN)   // Return credit to user
+                {
+                    env->output(VM_RETURNED, NULL, vm->credit, 0);
+                    vm->credit = 0;
+                }
+                else if(ev->type == SELECT)   // Change state to deliver product
+                    vm->state = CHECK_CREDIT;
+
+                break;
+
+            case UPDATE_CREDIT:     // Update credit based on inserted coin
+                vm->credit += ev->value;
+                env->output(VM_COIN, NULL, ev->value, vm->credit);
+                vm->state = WAIT;
+
+                break;
+
+            case UPDATE_PRODUCT:
+                if(ev->type == UP)
+                    vm->product = (vm->product + 1 + env->count()) % env->count();  // Next Product
+
+                else if(ev->type == DOWN)
+                    vm->product = (vm->product - 1 + env->count()) % env->count();  // Previous Product
+
+                vm->state = WAIT;
+
+                break;
+
+            case CHECK_CREDIT:
+                if(env->get(vm->slot, &item) != 0 || item.stock == 0)    // Slot emptied
+                    env->output(VM_SOLD_OUT, &vm->item, 0, vm->credit);
+
+                else if(vm->credit < item.price)    // Not enough credit
+                    env->output(VM_NO_CREDIT, &item, 0, vm->credit);
+
+                else if(env->sell(vm->slot) == 0)    // Enough credit deliver product and update credit
+                {
+                    vm->credit = vm->credit - item.price;
+                    env->output(VM_DISPENSED, &item, item.price, vm->credit);
+                }
+
+                else    // Sold out between the check and the sale
+                    env->output(VM_SOLD_OUT, &item, 0, vm->credit);
+
+                vm->state = WAIT;
+
+                break;
+        }
+
+        vm->transitions++;
+    } while(vm->state != WAIT);
+
+    vending_wait(vm);
+}
@@ -0,0 +1,70 @@
+/** \file vending.h
+ * 	\brief Module implementing the state machine of the vending machine
+ *
+ *  The state machine is a step function: vending_step() takes one event and runs the states
+ * until the machine is back in WAIT. It has no hardware or kernel dependency: the products
+ * come from the catalog functions and the results (status line, coin, sale, return, ...)
+ * go to an output function, both given in a struct vending_env. On the board they are the
+ * catalog module and the display and journal, on the host a simulated catalog, so the same
+ * code runs in the application, the event replayer and the benchmark.
+ *
+ * \author André Brandão
+ * \author Emanuel Pereira
+ * \date 10/05/2022
+ */
+#ifndef _VENDING_H
+#define _VENDING_H
+
+#include <stdint.h>
+#include <money.h>
+#include <catalog.h>
+#include <event_queue.h>
+
+// States of State Machine
+#define WAIT 0              /**< State Wait definition */
+#define UPDATE_CREDIT 1     /**< State Update Credit definition */
+#define UPDATE_PRODUCT 2    /**< State Update Product definition */
+#define CHECK_CREDIT 3      /**< State Check Credit definition */
+
+// Events of the State Machine
+#define UP 1        /**< Event of the Up button pressed */
+#define DOWN 2      /**< Event of the Down button pressed */
+#define SELECT 3    /**< Event of the Select button pressed */
+#define RETURN 4    /**< Event of the Return button pressed */
+#define COIN 5      /**< Event of a coin inserted */
+#define REFRESH 6   /**< Event of an operator command (redraws the status line) */
+
+/** Results of the state machine, given to the output function */
+enum vending_output {
+    VM_STATUS,          /**< Status line: selected product and credit */
+    VM_COIN,            /**< Coin inserted (amount) */
+    VM_RETURNED,        /**< Credit returned (amount) */
+    VM_DISPENSED,       /**< Product dispensed (amount is the price) */
+    VM_NO_CREDIT,       /**< Not enough credit for the product */
+    VM_SOLD_OUT,        /**< Product out of stock */
+};
+
+/** Environment of the state machine */
+struct vending_env {
+    int (*count)(void);                                 /**< Number of products (catalog_count()) */
+    int (*slot)(int pos);                               /**< Slot of a product (catalog_slot()) */
+    int (*get)(int slot, struct catalog_item *item);    /**< Product of a slot (catalog_get()) */
+    int (*sell)(int slot);                              /**< Takes a product from the stock (catalog_sell()) */
+    void (*output)(enum vending_output out, const struct catalog_item *item, money_t amount, money_t credit); /**< Shows or records a result */
+};
+
+/** State machine */
+struct vending {
+    const struct vending_env *env;  /**< Environment */
+    int state;                      /**< State */
+    money_t credit;                 /**< Credit available (cents) */
+    int product;                    /**< Position of the product selected (in the used slots of the catalog) */
+    int slot;                       /**< Slot of the product selected */
+    struct catalog_item item;       /**< Product selected */
+    uint32_t transitions;           /**< State transitions */
+};
+
+void vending_init(struct vending *vm, const struct vending_env *env, money_t credit);
+void vending_step(struct vending *vm, const struct vm_event *ev);
+
+#endif // _VENDING_H
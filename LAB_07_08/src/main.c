@@ -6,6 +6,19 @@
  * via UART/Terminal. It was implemented using the board Nordic nrf52840-dk. The state machine is on the
  * next Statechart.
  * 
+ *  The state machine is driven by events: the debounced buttons post one event per coin or panel button,
+ * stamped with the time of the press, on a lock-free queue and the main thread sleeps until the queue
+ * has events, so an input is handled as soon as it happens, no coin is lost while the state machine is
+ * busy, and the CPU stays in idle (tickless kernel) while nobody uses the machine.
+ * 
+ *  The output goes through the display, which writes only what changed on the status line to the
+ * interrupt driven transmit ring of the console.
+ * 
+ *  Every transaction is appended to the journal in flash, read back at boot to restore the credit.
+ * 
+ *  The products (name, price and stock of each slot) are in the catalog, saved in flash. The interface
+ * thread lets the operator list the products and change prices, stocks and products on the console.
+ * 
  * \image html UML_Statechart.png
  * 
  * \author André Brandão
@@ -17,28 +30,24 @@
 #include <device.h>
 #include <devicetree.h>
 #include <drivers/gpio.h>
-#include <sys/printk.h>
 #include <sys/__assert.h>
 #include <string.h>
 #include <timing/timing.h>
 #include <stdio.h>
-#include <float.h>
-
-#define NPRODUCTS 3 /**< Number of products available */
-#define SLEEP_MS 250  /**< Sleep period (ms) */
+#include <stdlib.h>
+#include <console/console.h>
+#include <event_queue.h>
+#include <money.h>
+#include <buttons.h>
+#include <catalog.h>
+#include <display.h>
+#include <journal.h>
+#include <vending.h>
 
-// States of State Machine
-#define WAIT 0              /**< State Wait definition */
-#define UPDATE_CREDIT 1     /**< State Update Credit definition */
-#define UPDATE_PRODUCT 2    /**< State Update Product definition */
-#define CHECK_CREDIT 3      /**< State Check Credit definition */
+#define EVENT_QUEUE_SIZE 32 /**< Number of events the queue holds while the state machine is busy (power of 2) */
 
-// Panel Buttons Flags
-#define NONE 0      /**< Flag that indicates no button was pressed */ 
-#define UP 1        /**< Flag to signal Up button was pressed */
-#define DOWN 2      /**< Flag to signal Down button was pressed */
-#define SELECT 3    /**< Flag to signal Select button was pressed */
-#define RETURN 4    /**< Flag to signal Return button was pressed */
+#define STACK_SIZE 1024             /**< Size of stack area used by the interface thread */
+#define thread_interface_prio 5     /**< Scheduling priority of interface thread (lower than main) */
 
 /** GPIO 0 Node Label from device tree (refer to dts file) */
 #define GPIO0_NID DT_NODELABEL(gpio0) 
@@ -55,230 +64,293 @@
 #define BUTSELECT 0x1c  /**< Address of GPIO where button SELECT is connected */
 #define BUTRETURN 0x1d  /**< Address of GPIO where button RETURN is connected */
 
-// Buttons callback structures
-static struct gpio_callback butcoin_cb_data;
-static struct gpio_callback butpanel_cb_data;
 
+EVENT_QUEUE_DEFINE(event_queue, EVENT_QUEUE_SIZE);  /**< Queue of events to the state machine */
+K_SEM_DEFINE(event_sem, 0, K_SEM_MAX_LIMIT);      /**< Given after each event put on the queue */
 
-static char *products[NPRODUCTS] = {"Beer", "Tuna Sandwich", "Coffee"}; /**< Array to store the available products */
-static float price[NPRODUCTS] = {1.5, 1.0, 0.5};    /**< Array to store price of the products, the order of the prices are on same order as the products on the products array */
+/** Buttons of the machine and their events */
+static struct button buttons[] = {
+    { .pin = BOARDBUT1, .irq = GPIO_INT_EDGE_TO_ACTIVE, .type = COIN, .value = 10 },     // 10 cents
+    { .pin = BOARDBUT2, .irq = GPIO_INT_EDGE_TO_ACTIVE, .type = COIN, .value = 20 },     // 20 cents
+    { .pin = BOARDBUT3, .irq = GPIO_INT_EDGE_TO_ACTIVE, .type = COIN, .value = 50 },     // 50 cents
+    { .pin = BOARDBUT4, .irq = GPIO_INT_EDGE_TO_ACTIVE, .type = COIN, .value = 100 },    // 1 euro
+    { .pin = BUTUP, .irq = GPIO_INT_EDGE_TO_INACTIVE, .type = UP },          // Up arrow button
+    { .pin = BUTDOWN, .irq = GPIO_INT_EDGE_TO_INACTIVE, .type = DOWN },      // Down arrow button
+    { .pin = BUTSELECT, .irq = GPIO_INT_EDGE_TO_INACTIVE, .type = SELECT },  // Select button
+    { .pin = BUTRETURN, .irq = GPIO_INT_EDGE_TO_INACTIVE, .type = RETURN },  // Return button
+};
 
-volatile float coin = 0;            /**< Value of coin inserted */
-volatile int coin_detected = 0;     /**< Flag to signal that a coin was inserted */
-volatile int button_pressed = NONE; /**< Flag which indicates which panel button was pressed */
+K_THREAD_STACK_DEFINE(thread_interface_stack, STACK_SIZE);  /**< Create interface thread stack space */
+struct k_thread thread_interface_data;  /**< Interface thread data */
+k_tid_t thread_interface_tid;           /**< Interface thread task ID */
 
 void input_output_config(void);
-void float2int(float,int*,int*);
+void vending_output(enum vending_output out, const struct catalog_item *item, money_t amount, money_t credit);
+void thread_interface(void *argA, void *argB, void *argC);
+int read_int(void);
+void read_str(char *str, int size);
+
+/** Environment of the state machine: products from the catalog, results to the display and the journal */
+static const struct vending_env vending_board = {
+    .count = catalog_count,
+    .slot = catalog_slot,
+    .get = catalog_get,
+    .sell = catalog_sell,
+    .output = vending_output,
+};
 
-/** \brief Callback function of the interrupt from the four board buttons
+/** \brief Main function of program
+ * 
+ * The main function runs the state machine of the vending machine (vending module) on the
+ * events of the buttons, sleeping until the next event.
  * 
- *  Interrupt function of four buttons that emulates the insertion of coins,
- * whose values are: 10 cents, 20 cents, 50 cents and 1 EUR.
- * This function executes when a board button is pressed and signals that a coin
- * was inserted and returns the value of the inserted coin  
- *
- * \param[out] coin value of coin
- * \param[out] coin_detected flag to signal the insertion of a coin
 */
-void butcoinpress_cbfunction(const struct device *dev, struct gpio_callback *cb, uint32_t pins)
+void main(void)
 {
-    coin_detected = 1;
-    
-    if(BIT(BOARDBUT1) & pins)
-        coin = 0.10;  // 10 cents
+    struct vending vm;  // State machine
+    money_t credit;     // Credit restored from the journal (cents)
+    struct vm_event ev; // Last event received
+    uint32_t overflows = 0; // Events lost with the queue full, reported
+    char amount[MONEY_STR_SIZE];    // Auxiliar string for printing amounts of money
+    int nrecords;       // Records read from the journal
+
+    // Console output and input
+    display_init();
+
+    // Load the products
+    if(catalog_init() != 0)
+        display_message("Error loading the catalog from flash, changes are not saved");
+
+    // Restore the credit
+    nrecords = journal_init(&credit);
+    if(nrecords < 0)
+        display_message("Error opening the journal, transactions are not saved");
+    else if(credit != 0)
+        display_message("Credit %s € restored (%d transactions in the journal)", money_format(credit, amount), nrecords);
 
-    if(BIT(BOARDBUT2) & pins)
-        coin = 0.20;  // 20 cents
+    // Config input pins and interruptions
+    input_output_config();
 
-    if(BIT(BOARDBUT3) & pins)
-        coin = 0.50;  // 50 cents
+    thread_interface_tid = k_thread_create(&thread_interface_data, thread_interface_stack,
+        K_THREAD_STACK_SIZEOF(thread_interface_stack), thread_interface,
+        NULL, NULL, NULL, thread_interface_prio, 0, K_NO_WAIT);
 
-    if(BIT(BOARDBUT4) & pins)
-        coin = 1.00;  // 1 euro
+    vending_init(&vm, &vending_board, credit);
+
+    while(1)
+    {
+        /* Sleep until the next event */ 
+        while(event_queue_get(&event_queue, &ev) != 0)
+            k_sem_take(&event_sem, K_FOREVER);
+
+        if(event_queue_overflows_get(&event_queue) != overflows)
+        {
+            overflows = event_queue_overflows_get(&event_queue);
+            display_message("WARNING: %u input events lost (queue full)", overflows);
+        }
+
+        vending_step(&vm, &ev);
+    }
+      
+    return;
 }
 
-/** \brief Callback function of the interrupt from the four panel control buttons.
- * 
- *  This function executes when a panel button is pressed and updates which button was pressed.  
+/** \brief Output function of the state machine
  *
- * \param[out] button_pressed which button was pressed
-*/
-void butpanelpress_cbfunction(const struct device *dev, struct gpio_callback *cb, uint32_t pins)
+ *  Shows the results on the display and appends the transactions to the journal.
+ *
+ * \param[in] out result
+ * \param[in] item product (status line, sales), NULL otherwise
+ * \param[in] amount amount of the transaction (cents)
+ * \param[in] credit credit after the result (cents)
+ */
+void vending_output(enum vending_output out, const struct catalog_item *item, money_t amount, money_t credit)
 {
-    if(BIT(BUTUP) & pins)
-        button_pressed = UP;    // Up arrow button
-
-    if(BIT(BUTDOWN) & pins)
-        button_pressed = DOWN;  // Down arrow button
+    char amount1[MONEY_STR_SIZE];   // Auxiliar strings for printing amounts of money
+    char amount2[MONEY_STR_SIZE];
 
-    if(BIT(BUTSELECT) & pins)
-        button_pressed = SELECT;  // Select button
-
-    if(BIT(BUTRETURN) & pins)
-        button_pressed = RETURN;  // Return button
+    switch(out)
+    {
+        case VM_STATUS:
+            display_status("Product: %s, Cost: %s €, Stock: %u, Credit: %s €", item->name,
+                           money_format(item->price, amount1), item->stock, money_format(credit, amount2));
+            break;
+
+        case VM_COIN:
+            journal_append(JOURNAL_COIN, JOURNAL_NO_SLOT, amount, credit);
+            break;
+
+        case VM_RETURNED:
+            display_message("%s EUR return", money_format(amount, amount1));
+            journal_append(JOURNAL_RETURN, JOURNAL_NO_SLOT, amount, credit);
+            break;
+
+        case VM_DISPENSED:
+            journal_append(JOURNAL_SALE, item->slot, amount, credit);
+            display_message("Product %s dispensed, remaining credit %s €", item->name, money_format(credit, amount1));
+            break;
+
+        case VM_NO_CREDIT:
+            display_message("Not enough credit, Product %s costs %s €, credit is %s €", item->name,
+                            money_format(item->price, amount1), money_format(credit, amount2));
+            break;
+
+        case VM_SOLD_OUT:
+            display_message("Product %s sold out", item->name);
+            break;
+    }
 }
 
-/** \brief Main function of program
+/** \brief Configuration Function.
  * 
- * The main function has the implementation of the state machine of the vending machine.
+ *  This function makes all the hardware configuration. Configures the input pins and the interruptions of the microcontroller.
+ *  Board buttons (coins) post their event on the rising-edge, Control Panel buttons on the falling-edge.
  * 
 */
-void main(void)
+void input_output_config(void)
 {
-    int state = WAIT;   // Stores state of the machine
-    float credit = 0;   // Stores the credit available
-    int product = 0;    // Stores the index of the price and product to be selected.
-    
-    int whole = 0;      // Auxiliar variable for printing a float (integer part)
-    int remainder = 0;  // Auxiliar variable for printing a float (decimal part)
+    const struct device *gpio0_dev;         /* Pointer to GPIO device structure */
 
-    // Config input pins and interruptions
-    input_output_config();
+    /* Bind to GPIO 0 */
+    gpio0_dev = device_get_binding(DT_LABEL(GPIO0_NID));
+
+    event_queue_init(&event_queue);
+
+    if(buttons_init(gpio0_dev, buttons, ARRAY_SIZE(buttons), &event_queue, &event_sem) != 0)
+        display_message("Error configuring the buttons");
+}
+
+/** \brief Interface thread, implements the console commands of the operator
+ *
+ *  Lists the catalog and changes the prices, the stocks and the products of the slots,
+ * prints and resets the display statistics, prints the journal statistics and transactions.
+ * The changes are saved in flash by the catalog, and after each command the state machine
+ * is told to redraw the status line (REFRESH event).
+ *
+ */
+void thread_interface(void *argA , void *argB, void *argC)
+{
+    struct vm_event ev = { .type = REFRESH };
+    char command;
+    char name[CATALOG_NAME_SIZE];
+    int slot, price, stock, err;
+
+    display_printk("\nPress 1 to list the products");
+    display_printk("\nPress 2 to change the price of a product");
+    display_printk("\nPress 3 to change the stock of a product");
+    display_printk("\nPress 4 to add or replace the product of a slot");
+    display_printk("\nPress 5 to check the display output statistics");
+    display_printk("\nPress 6 to reset the display output statistics");
+    display_printk("\nPress 7 to check the journal statistics");
+    display_printk("\nPress 8 to list the last transactions of the journal\n");
 
     while(1)
     {
-        switch(state)
+        command = console_getchar();    // Get operator command
+        err = 0;
+
+        switch(command)
         {
-            case WAIT:
-                
-                // print information
-                float2int(price[product], &whole, &remainder);
-                printk("\rProduct: %s, Cost: %d.%d €,", products[product], whole, remainder);
-                
-                float2int(credit, &whole, &remainder);
-                printk(" Credit: %d.%d €", whole, remainder);
-                
-                /* Pause  */ 
-                k_msleep(SLEEP_MS);  
-
-                if(coin_detected == 1)  // Change state to update credit
-                    state = UPDATE_CREDIT;
-                
-                else if(button_pressed == UP || button_pressed == DOWN)     // Change state to update selected product
-                    state = UPDATE_PRODUCT;
-
-                else if(button_pressed == RETURN)   // Return credit to user
-                {
-                    float2int(credit, &whole, &remainder);
-                    printk("\n%d.%d EUR return\n", whole, remainder);
-                    credit = 0;
-                    button_pressed = NONE;
-                    
-                }
-                else if(button_pressed == SELECT)   // Change state to deliver product
-                    state = CHECK_CREDIT;
+            case '1':   // List the products
+                catalog_print();
+                break;
 
+            case '2':   // Change a price
+                display_printk("\nSlot: ");
+                slot = read_int();
+                display_printk("\nPrice (cents): ");
+                price = read_int();
+                err = catalog_price_set(slot, price);
                 break;
-            
-            case UPDATE_CREDIT:     // Update credit based on inserted coin
-                coin_detected = 0;
-                credit += coin;
-                coin = 0;
-                state = WAIT;
-                       
+
+            case '3':   // Change a stock
+                display_printk("\nSlot: ");
+                slot = read_int();
+                display_printk("\nStock: ");
+                stock = read_int();
+                err = (stock < 0 || stock > UINT16_MAX) ? -1 : catalog_stock_set(slot, stock);
                 break;
 
-            case UPDATE_PRODUCT:
-                if(button_pressed == UP)
-                {
-                    product = (product + 1 + NPRODUCTS) % NPRODUCTS;  // Next Product
-                    button_pressed = NONE;
-                }
-                else if(button_pressed == DOWN)
-                {
-                    product = (product - 1 + NPRODUCTS) % NPRODUCTS;  // Previous Product
-                    button_pressed = NONE;
-                }
-                
-                printk("\33[2K");   // clear line
-
-                state = WAIT;
-                
+            case '4':   // Add or replace a product
+                display_printk("\nSlot (0 to %d): ", CATALOG_MAX_SLOTS - 1);
+                slot = read_int();
+                display_printk("\nName: ");
+                read_str(name, sizeof(name));
+                display_printk("\nPrice (cents): ");
+                price = read_int();
+                display_printk("\nStock: ");
+                stock = read_int();
+                err = (stock < 0 || stock > UINT16_MAX) ? -1 : catalog_set(slot, name, price, stock);
                 break;
 
-            case CHECK_CREDIT:
-                if(credit >= price[product])    // Enough credit deliver product and update credit
-                {
-                    credit = credit - price[product];
-                    float2int(credit, &whole, &remainder);
-                    printk("\nProduct %s dispensed, remaining credit %d.%d €\n", products[product], whole, remainder);
-                }
-
-                else    // Not enough credit
-                {
-                    float2int(price[product], &whole, &remainder);
-                    printk("\nNot enough credit, Product %s costs %d.%d €, ", products[product], whole, remainder);
-                    float2int(credit, &whole, &remainder);
-                    printk("credit is %d.%d €\n", whole, remainder);
-                }
-                
-                button_pressed = NONE;
-                state = WAIT;
+            case '5':   // Display statistics
+                display_stats_print();
+                break;
 
+            case '6':   // Reset the display statistics
+                display_stats_reset();
+                display_printk("\nDisplay statistics reset\n");
                 break;
+
+            case '7':   // Journal statistics
+                journal_stats_print();
+                break;
+
+            case '8':   // Last transactions
+                journal_print(10);
+                break;
+
+            default:
+                continue;
         }
+
+        if(err != 0)
+            display_printk("\nInvalid slot or value\n");
+
+        // The status line is redrawn below the output of the command
+        if(event_queue_put(&event_queue, &ev) == 0)
+            k_sem_give(&event_sem);
     }
-      
-    return;
 }
 
-/** \brief Function to transform float number in two integer numbers
- * 
- *  This function converts a float number to two integral numbers, one of them being the integer part and the other the decimal part of the float number.
- * The variables to store the integer and decimal part of the float number must be passed as pointers on the arguments of the function. 
+/** \brief Function to read integer values from the operator
+ *  \pre Initialize console with display_init()
  *
- * \param[in] arg Value of float number to convert
- * \param[in,out] whole Pointer to variable to store integer part of float number
- * \param[in,out] remainder Pointer to variable to store decimal part of float number
-*/
-void float2int(float arg, int* whole, int* remainder)
+ *  Reads characters until the enter key is pressed (carriage return - \\r), with echo,
+ * and returns their integer value. Limited to 10 characters, the rest are ignored.
+ *
+ * \see console_getchar()
+ */
+int read_int(void)
 {
-    *whole = arg;
-    *remainder = (arg - *whole) * 10;
+    char c[12];
+
+    read_str(c, sizeof(c));
+
+    return atoi(c);
 }
 
-/** \brief Configuration Function.
- * 
- *  This function makes all the hardware configuration. Configures the input pins and the interruptions of the microcontroller.
- * 
-*/
-void input_output_config(void)
+/** \brief Function to read a string from the operator
+ *  \pre Initialize console with display_init()
+ *
+ *  Reads characters until the enter key is pressed (carriage return - \\r), with echo.
+ * The characters after the first size - 1 are ignored.
+ *
+ * \param[out] str string read
+ * \param[in] size size of str
+ */
+void read_str(char *str, int size)
 {
-    const struct device *gpio0_dev;         /* Pointer to GPIO device structure */
+    char c;
+    int i = 0;
 
-    /* Bind to GPIO 0 */
-    gpio0_dev = device_get_binding(DT_LABEL(GPIO0_NID));
-    
-    /* Configure BOARD BUTTON PINS */
-    gpio_pin_configure(gpio0_dev, BOARDBUT1, GPIO_INPUT | GPIO_PULL_UP);
-    gpio_pin_configure(gpio0_dev, BOARDBUT2, GPIO_INPUT | GPIO_PULL_UP);
-    gpio_pin_configure(gpio0_dev, BOARDBUT3, GPIO_INPUT | GPIO_PULL_UP);
-    gpio_pin_configure(gpio0_dev, BOARDBUT4, GPIO_INPUT | GPIO_PULL_UP);
-    
-    /* Configure GPIO to external buttons */
-    gpio_pin_configure(gpio0_dev, BUTUP, GPIO_INPUT | GPIO_PULL_UP);
-    gpio_pin_configure(gpio0_dev, BUTDOWN, GPIO_INPUT | GPIO_PULL_UP);
-    gpio_pin_configure(gpio0_dev, BUTSELECT, GPIO_INPUT | GPIO_PULL_UP);
-    gpio_pin_configure(gpio0_dev, BUTRETURN, GPIO_INPUT | GPIO_PULL_UP);
-
-    /* Set interrupt HW - which pin and event generate interrupt
-    Board buttons configured to generate interrupt on rising-edge
-    Control Panel buttons configured to generate interrupt on falling-edge */
-
-    gpio_pin_interrupt_configure(gpio0_dev, BOARDBUT1, GPIO_INT_EDGE_TO_ACTIVE);
-    gpio_pin_interrupt_configure(gpio0_dev, BOARDBUT2, GPIO_INT_EDGE_TO_ACTIVE);
-    gpio_pin_interrupt_configure(gpio0_dev, BOARDBUT3, GPIO_INT_EDGE_TO_ACTIVE);
-    gpio_pin_interrupt_configure(gpio0_dev, BOARDBUT4, GPIO_INT_EDGE_TO_ACTIVE);
-
-    gpio_pin_interrupt_configure(gpio0_dev, BUTUP, GPIO_INT_EDGE_TO_INACTIVE);
-    gpio_pin_interrupt_configure(gpio0_dev, BUTDOWN, GPIO_INT_EDGE_TO_INACTIVE);
-    gpio_pin_interrupt_configure(gpio0_dev, BUTSELECT, GPIO_INT_EDGE_TO_INACTIVE);
-    gpio_pin_interrupt_configure(gpio0_dev, BUTRETURN, GPIO_INT_EDGE_TO_INACTIVE);
-    
-    /* Set callbacks */
-    gpio_init_callback(&butcoin_cb_data, butcoinpress_cbfunction, BIT(BOARDBUT1)| BIT(BOARDBUT2)| BIT(BOARDBUT3) | BIT(BOARDBUT4));
-    gpio_add_callback(gpio0_dev, &butcoin_cb_data);
-
-    gpio_init_callback(&butpanel_cb_data, butpanelpress_cbfunction, BIT(BUTUP)| BIT(BUTDOWN)| BIT(BUTSELECT) | BIT(BUTRETURN));
-    gpio_add_callback(gpio0_dev, &butpanel_cb_data);
+    while((c = console_getchar()) != '\r')
+    {
+        if(i < size - 1)
+        {
+            str[i++] = c;
+            display_printk("%c", c);
+        }
+    }
+    str[i] = '\0';
 }
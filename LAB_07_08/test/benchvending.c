@@ -0,0 +1,164 @@
+/** \file benchvending.c
+ * 	\brief Host benchmark and invariant check of the vending machine state machine
+ *
+ *  Millions of random events (coins, buttons, purchases, returns and restocks) run through
+ * the state machine of the application (vending.c) on the simulated catalog. After each
+ * event the credit must equal the coins inserted minus the products dispensed and the credit
+ * returned, counted apart from the outputs, it must never be negative, and the stock taken
+ * from the catalog must equal the products dispensed. Prints the events and state
+ * transitions per second (with the checks and the random events).
+ *
+ * \author André Brandão
+ * \author Emanuel Pereira
+ * \date 10/05/2022
+ */
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "vending.h"
+#include "simcatalog.h"
+
+#define NEVENTS 20000000    /**< Random events */
+#define NPRODUCTS 16        /**< Products of the simulated catalog */
+
+static const uint16_t coins[] = { 10, 20, 50, 100, 200 };
+
+static long long inserted, paid, returned, dispensed;  /**< Totals of the outputs (cents, products) */
+
+/** \brief Current time in nanoseconds */
+static double now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+/** \brief Random number from xorshift32 */
+static uint32_t rnd(void)
+{
+    static uint32_t x = 1;
+
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return x;
+}
+
+/** \brief Output function, adds up the money and the products */
+static void bench_output(enum vending_output out, const struct catalog_item *item, money_t amount, money_t credit)
+{
+    (void)item;
+    (void)credit;
+
+    if(out == VM_COIN)
+        inserted += amount;
+    else if(out == VM_RETURNED)
+        returned += amount;
+    else if(out == VM_DISPENSED)
+    {
+        paid += amount;
+        dispensed++;
+    }
+}
+
+static const struct vending_env bench_env = {
+    .count = sim_catalog_count,
+    .slot = sim_catalog_slot,
+    .get = sim_catalog_get,
+    .sell = sim_catalog_sell,
+    .output = bench_output,
+};
+
+/** \brief Stock of the whole catalog */
+static long long stock_total(void)
+{
+    struct catalog_item item;
+    long long total = 0;
+
+    for(int i = 0; i < sim_catalog_count(); i++)
+    {
+        sim_catalog_get(sim_catalog_slot(i), &item);
+        total += item.stock;
+    }
+    return total;
+}
+
+int main(void)
+{
+    struct vending vm;
+    struct vm_event ev = { 0 };
+    struct catalog_item item;
+    char name[CATALOG_NAME_SIZE];
+    long long restocked, stock0;
+    uint32_t r;
+    double start, ns;
+    int slot, fails = 0;
+
+    sim_catalog_clear();
+    for(int i = 0; i < NPRODUCTS; i++)
+    {
+        snprintf(name, sizeof(name), "Product %d", i);
+        sim_catalog_set(i * 3, name, MONEY_CENTS(0, 50) + 10 * (int)(rnd() % 20), rnd() % 10);
+    }
+    stock0 = stock_total();
+    restocked = 0;
+
+    vending_init(&vm, &bench_env, 0);
+
+    start = now_ns();
+    for(long i = 0; i < NEVENTS; i++)
+    {
+        r = rnd();
+        switch(r % 16)
+        {
+            case 0: case 1: case 2: case 3: case 4: case 5:
+                ev.type = COIN;
+                ev.value = coins[(r >> 8) % (sizeof(coins) / sizeof(coins[0]))];
+                break;
+            case 6: case 7: case 8:
+                ev.type = UP;
+                break;
+            case 9: case 10:
+                ev.type = DOWN;
+                break;
+            case 11: case 12: case 13:
+                ev.type = SELECT;
+                break;
+            case 14:
+                ev.type = RETURN;
+                break;
+            default:    // Operator restocks an empty slot
+                slot = sim_catalog_slot((r >> 8) % NPRODUCTS);
+                sim_catalog_get(slot, &item);
+                if(item.stock == 0)
+                {
+                    restocked += 5;
+                    sim_catalog_set(slot, item.name, item.price, 5);
+                }
+                ev.type = REFRESH;
+                break;
+        }
+
+        vending_step(&vm, &ev);
+
+        if((vm.credit != inserted - paid - returned || vm.credit < 0 || vm.state != WAIT) && fails++ < 10)
+            printf("FAIL: event %ld, credit %d, expected %lld, state %d\n", i, vm.credit,
+                   inserted - paid - returned, vm.state);
+    }
+
+    ns = now_ns() - start;
+
+    if(stock_total() != stock0 + restocked - dispensed && fails++ < 10)
+        printf("FAIL: stock %lld, expected %lld\n", stock_total(), stock0 + restocked - dispensed);
+
+    printf("%d events, %u transitions, %lld products dispensed, %lld cents inserted\n",
+           NEVENTS, vm.transitions, dispensed, inserted);
+    printf("%.1f ns/event, %.1f M events/s, %.1f M transitions/s\n", ns / NEVENTS,
+           NEVENTS / ns * 1e3, vm.transitions / ns * 1e3);
+    printf(fails ? "FAILED\n" : "OK\n");
+
+    return fails != 0;
+}
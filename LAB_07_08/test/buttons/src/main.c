@@ -0,0 +1,174 @@
+/** \file main.c
+ * 	\brief Test of the debounced buttons and the event queue with the GPIO emulator (native_posix)
+ *
+ *  The test drives the pins of the emulated GPIO port as the vending machine buttons would be
+ * pressed: bursts of presses on all the buttons at once, with bounces on every edge, at hundreds
+ * of events per second. Every press must give exactly one event, in order and stamped, the
+ * bounces of the other edge one glitch, and presses shorter than the debounce time no event.
+ * A queue left full must count the drops.
+ *
+ * \author André Brandão
+ * \author Emanuel Pereira
+ * \date 10/05/2022
+ */
+
+#include <ztest.h>
+#include <drivers/gpio.h>
+#include <drivers/gpio/gpio_emul.h>
+#include <event_queue.h>
+#include <buttons.h>
+
+#define GPIO0_NID DT_NODELABEL(gpio0)   /**< Emulated GPIO port */
+
+#define QUEUE_SIZE 64   /**< Queue size */
+#define ROUNDS 100      /**< Presses of each button in the burst */
+#define COIN 5          /**< Coin event */
+#define PANEL 1         /**< Panel button event */
+
+EVENT_QUEUE_DEFINE(queue, QUEUE_SIZE);
+K_SEM_DEFINE(ready, 0, K_SEM_MAX_LIMIT);
+
+/** Buttons: coins post on the release (rising edge), the panel on the press (falling edge) */
+static struct button buttons[] = {
+    { .pin = 0x0b, .irq = GPIO_INT_EDGE_TO_ACTIVE, .type = COIN, .value = 10 },
+    { .pin = 0x0c, .irq = GPIO_INT_EDGE_TO_ACTIVE, .type = COIN, .value = 20 },
+    { .pin = 0x18, .irq = GPIO_INT_EDGE_TO_ACTIVE, .type = COIN, .value = 50 },
+    { .pin = 0x19, .irq = GPIO_INT_EDGE_TO_ACTIVE, .type = COIN, .value = 100 },
+    { .pin = 0x03, .irq = GPIO_INT_EDGE_TO_INACTIVE, .type = PANEL, .value = 1 },
+    { .pin = 0x04, .irq = GPIO_INT_EDGE_TO_INACTIVE, .type = PANEL, .value = 2 },
+    { .pin = 0x1c, .irq = GPIO_INT_EDGE_TO_INACTIVE, .type = PANEL, .value = 3 },
+    { .pin = 0x1d, .irq = GPIO_INT_EDGE_TO_INACTIVE, .type = PANEL, .value = 4 },
+};
+
+#define NBUTTONS ((int)ARRAY_SIZE(buttons))   /**< Number of buttons */
+
+static const struct device *gpio_dev;
+
+/** \brief Sets the level of all buttons pins, with two bounces before it settles */
+static void set_all(int level)
+{
+    for(int bounce = 0; bounce < 2; bounce++)
+    {
+        for(int i = 0; i < NBUTTONS; i++)
+            gpio_emul_input_set(gpio_dev, buttons[i].pin, level);
+        k_usleep(100);
+        for(int i = 0; i < NBUTTONS; i++)
+            gpio_emul_input_set(gpio_dev, buttons[i].pin, !level);
+        k_usleep(100);
+    }
+
+    for(int i = 0; i < NBUTTONS; i++)
+        gpio_emul_input_set(gpio_dev, buttons[i].pin, level);
+}
+
+/** \brief Presses and releases all the buttons, holding each level past the debounce time */
+static void press_all(void)
+{
+    set_all(0);
+    k_msleep(BUTTONS_DEBOUNCE_MS + 1);
+    set_all(1);
+    k_msleep(BUTTONS_DEBOUNCE_MS + 1);
+}
+
+/** \brief Gets the events on the queue, counting them per button */
+static int drain(uint32_t *count, uint32_t *last_stamp)
+{
+    struct vm_event ev;
+    int n = 0;
+
+    while(event_queue_get(&queue, &ev) == 0)
+    {
+        int i;
+
+        for(i = 0; i < NBUTTONS && buttons[i].pin != ev.pin; i++)
+            ;
+        zassert_true(i < NBUTTONS, "event of pin %u", ev.pin);
+        zassert_equal(ev.type, buttons[i].type, "type of pin %u", ev.pin);
+        zassert_equal(ev.value, buttons[i].value, "value of pin %u", ev.pin);
+        zassert_true((int32_t)(ev.stamp - *last_stamp) >= 0, "stamp out of order");
+
+        *last_stamp = ev.stamp;
+        count[i]++;
+        n++;
+        k_sem_take(&ready, K_NO_WAIT);
+    }
+
+    return n;
+}
+
+static void setup(void)
+{
+    gpio_dev = device_get_binding(DT_LABEL(GPIO0_NID));
+    zassert_not_null(gpio_dev, "no GPIO emulator");
+
+    for(int i = 0; i < NBUTTONS; i++)
+        gpio_emul_input_set(gpio_dev, buttons[i].pin, 1);   // Released (pull-up)
+
+    zassert_equal(event_queue_init(&queue), 0, NULL);
+    k_sem_reset(&ready);
+    zassert_equal(buttons_init(gpio_dev, buttons, NBUTTONS, &queue, &ready), 0, NULL);
+}
+
+/** \brief Burst of presses on all the buttons, one event per press, none lost */
+static void test_burst(void)
+{
+    uint32_t count[NBUTTONS] = {0}, stamp = 0;
+    int64_t start = k_uptime_get();
+    int total = 0;
+
+    setup();
+
+    for(int r = 0; r < ROUNDS; r++)
+    {
+        press_all();
+        total += drain(count, &stamp);
+    }
+
+    TC_PRINT("%d events in %lld ms\n", total, (long long)(k_uptime_get() - start));
+
+    for(int i = 0; i < NBUTTONS; i++)
+        zassert_equal(count[i], ROUNDS, "pin %u: %u events", buttons[i].pin, count[i]);
+    zassert_equal(event_queue_overflows_get(&queue), 0, NULL);
+    zassert_equal(buttons_glitches_get(), ROUNDS * NBUTTONS, "one glitch per bouncing edge that is not an event");
+}
+
+/** \brief Presses shorter than the debounce time give no event */
+static void test_glitch(void)
+{
+    uint32_t count[NBUTTONS] = {0}, stamp = 0;
+
+    setup();
+
+    set_all(0);
+    k_msleep(1);
+    set_all(1);
+    k_msleep(2 * BUTTONS_DEBOUNCE_MS);
+
+    zassert_equal(drain(count, &stamp), 4, "only the coin releases are events");
+    zassert_equal(buttons_glitches_get(), 4, "the panel presses are glitches");
+}
+
+/** \brief Presses with the queue full are dropped and counted */
+static void test_overflow(void)
+{
+    uint32_t count[NBUTTONS] = {0}, stamp = 0;
+    int rounds = QUEUE_SIZE / NBUTTONS + 2;
+
+    setup();
+
+    for(int r = 0; r < rounds; r++)
+        press_all();
+
+    zassert_equal(event_queue_high_water_get(&queue), QUEUE_SIZE, NULL);
+    zassert_equal(event_queue_overflows_get(&queue), rounds * NBUTTONS - QUEUE_SIZE, NULL);
+    zassert_equal(drain(count, &stamp), QUEUE_SIZE, NULL);
+}
+
+void test_main(void)
+{
+    ztest_test_suite(buttons,
+                     ztest_unit_test(test_burst),
+                     ztest_unit_test(test_glitch),
+                     ztest_unit_test(test_overflow));
+    ztest_run_test_suite(buttons);
+}
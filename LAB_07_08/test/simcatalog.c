@@ -0,0 +1,76 @@
+/** \file simcatalog.c
+ * 	\brief Catalog of the host simulation of the vending machine
+ *
+ * \author André Brandão
+ * \author Emanuel Pereira
+ * \date 10/05/2022
+ */
+#include <string.h>
+#include "simcatalog.h"
+
+static struct catalog_item items[CATALOG_MAX_SLOTS];    /**< Items, indexed by the slot id */
+static int order[CATALOG_MAX_SLOTS];                    /**< Used slots, ascending */
+static int nused;                                       /**< Number of used slots */
+
+/** \brief Empties the catalog */
+void sim_catalog_clear(void)
+{
+    memset(items, 0, sizeof(items));
+    nused = 0;
+}
+
+/** \brief Adds or replaces the product of a slot, as catalog_set() */
+int sim_catalog_set(int slot, const char *name, money_t price, uint16_t stock)
+{
+    int i;
+
+    if(slot < 0 || slot >= CATALOG_MAX_SLOTS || name[0] == '\0' || price < 0)
+        return -1;
+
+    if(items[slot].name[0] == '\0')
+    {
+        for(i = nused; i > 0 && order[i - 1] > slot; i--)
+            order[i] = order[i - 1];
+        order[i] = slot;
+        nused++;
+    }
+
+    strncpy(items[slot].name, name, CATALOG_NAME_SIZE - 1);
+    items[slot].price = price;
+    items[slot].stock = stock;
+    items[slot].slot = slot;
+
+    return 0;
+}
+
+/** \brief Number of used slots, as catalog_count() */
+int sim_catalog_count(void)
+{
+    return nused;
+}
+
+/** \brief Slot of a position, as catalog_slot() */
+int sim_catalog_slot(int pos)
+{
+    return pos >= 0 && pos < nused ? order[pos] : -1;
+}
+
+/** \brief Product of a slot, as catalog_get() */
+int sim_catalog_get(int slot, struct catalog_item *item)
+{
+    if(slot < 0 || slot >= CATALOG_MAX_SLOTS || items[slot].name[0] == '\0')
+        return -1;
+
+    *item = items[slot];
+    return 0;
+}
+
+/** \brief Takes a product from a slot, as catalog_sell() */
+int sim_catalog_sell(int slot)
+{
+    if(slot < 0 || slot >= CATALOG_MAX_SLOTS || items[slot].name[0] == '\0' || items[slot].stock == 0)
+        return -1;
+
+    items[slot].stock--;
+    return 0;
+}
@@ -0,0 +1,23 @@
+/** \file simcatalog.h
+ * 	\brief Catalog of the host simulation of the vending machine
+ *
+ *  Same functions as the catalog module, on an array in memory, for the environment
+ * of the state machine on the host.
+ *
+ * \author André Brandão
+ * \author Emanuel Pereira
+ * \date 10/05/2022
+ */
+#ifndef _SIMCATALOG_H
+#define _SIMCATALOG_H
+
+#include "catalog.h"
+
+void sim_catalog_clear(void);
+int sim_catalog_set(int slot, const char *name, money_t price, uint16_t stock);
+int sim_catalog_count(void);
+int sim_catalog_slot(int pos);
+int sim_catalog_get(int slot, struct catalog_item *item);
+int sim_catalog_sell(int slot);
+
+#endif // _SIMCATALOG_H
@@ -0,0 +1,190 @@
+/** \file simvending.c
+ * 	\brief Scripted event replayer of the vending machine state machine (host)
+ *
+ *  Runs the state machine of the application (vending.c) on the events of a script and
+ * prints its output as the board would. A script has one command per line ('#' starts a
+ * comment):
+ *  - coin <cents>, up, down, select, return, refresh: events
+ *  - product <slot> <price> <stock> <name>: adds or replaces a product
+ *  - expect credit <cents>, expect slot <slot>, expect stock <slot> <n>,
+ *    expect output <status|coin|returned|dispensed|no_credit|sold_out>: checks
+ *    the credit, the slot selected, a stock or the result of the last event
+ *    (status if it only redrew the status line)
+ *  A failed expectation or a bad line is reported with its line number.
+ *
+ *      ./simvending script.txt ...     (or the script on stdin)
+ *
+ * \author André Brandão
+ * \author Emanuel Pereira
+ * \date 10/05/2022
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "vending.h"
+#include "simcatalog.h"
+
+static const char *output_names[] = { "status", "coin", "returned", "dispensed", "no_credit", "sold_out" };
+
+static enum vending_output last_output;     /**< Result of the last event (VM_STATUS if none) */
+
+/** \brief Output function, prints the results as the board */
+static void sim_output(enum vending_output out, const struct catalog_item *item, money_t amount, money_t credit)
+{
+    char a1[MONEY_STR_SIZE], a2[MONEY_STR_SIZE];
+
+    if(out != VM_STATUS)
+        last_output = out;
+
+    switch(out)
+    {
+        case VM_STATUS:
+            printf("  Product: %s, Cost: %s €, Stock: %u, Credit: %s €\n", item->name,
+                   money_format(item->price, a1), item->stock, money_format(credit, a2));
+            break;
+        case VM_COIN:
+            printf("  [coin %s, credit %s]\n", money_format(amount, a1), money_format(credit, a2));
+            break;
+        case VM_RETURNED:
+            printf("  %s EUR return\n", money_format(amount, a1));
+            break;
+        case VM_DISPENSED:
+            printf("  Product %s dispensed, remaining credit %s €\n", item->name, money_format(credit, a1));
+            break;
+        case VM_NO_CREDIT:
+            printf("  Not enough credit, Product %s costs %s €, credit is %s €\n", item->name,
+                   money_format(item->price, a1), money_format(credit, a2));
+            break;
+        case VM_SOLD_OUT:
+            printf("  Product %s sold out\n", item->name);
+            break;
+    }
+}
+
+static const struct vending_env sim_env = {
+    .count = sim_catalog_count,
+    .slot = sim_catalog_slot,
+    .get = sim_catalog_get,
+    .sell = sim_catalog_sell,
+    .output = sim_output,
+};
+
+/** \brief Runs a script, returns the number of failures */
+static int run(FILE *f, const char *name)
+{
+    static const struct { const char *cmd; uint8_t type; } events[] = {
+        { "up", UP }, { "down", DOWN }, { "select", SELECT }, { "return", RETURN }, { "refresh", REFRESH },
+    };
+    struct vending vm;
+    struct vm_event ev;
+    struct catalog_item item;
+    char line[128], cmd[16], what[16], pname[CATALOG_NAME_SIZE];
+    int a, b, c, n, fails = 0, lineno = 0, started = 0;
+
+    sim_catalog_clear();
+
+    while(fgets(line, sizeof(line), f) != NULL)
+    {
+        lineno++;
+        line[strcspn(line, "#\r\n")] = '\0';
+        if(sscanf(line, "%15s", cmd) != 1)
+            continue;   // Empty line or comment
+
+        printf("%s\n", line);
+        memset(&ev, 0, sizeof(ev));
+        if(strcmp(cmd, "expect") != 0)
+            last_output = VM_STATUS;
+
+        if(strcmp(cmd, "product") == 0)
+        {
+            if(sscanf(line, "%*s %d %d %d %19[^\n]", &a, &b, &c, pname) != 4 || sim_catalog_set(a, pname, b, c) != 0)
+                goto bad;
+            continue;
+        }
+
+        if(!started)    // First event or check, the catalog is set
+        {
+            if(sim_catalog_count() == 0)
+                sim_catalog_set(0, "Beer", MONEY_CENTS(1, 50), 10);
+            vending_init(&vm, &sim_env, 0);
+            started = 1;
+        }
+
+        if(strcmp(cmd, "coin") == 0)
+        {
+            if(sscanf(line, "%*s %d", &a) != 1 || a <= 0 || a > UINT16_MAX)
+                goto bad;
+            ev.type = COIN;
+            ev.value = a;
+            vending_step(&vm, &ev);
+        }
+        else if(strcmp(cmd, "expect") == 0)
+        {
+            n = sscanf(line, "%*s %15s %d %d", what, &a, &b);
+            if(n >= 2 && strcmp(what, "credit") == 0)
+                c = vm.credit == a;
+            else if(n >= 2 && strcmp(what, "slot") == 0)
+                c = vm.slot == a;
+            else if(n == 3 && strcmp(what, "stock") == 0)
+                c = sim_catalog_get(a, &item) == 0 && item.stock == b;
+            else if(sscanf(line, "%*s %15s %15s", what, cmd) == 2 && strcmp(what, "output") == 0)
+            {
+                for(a = 0; a <= VM_SOLD_OUT && strcmp(output_names[a], cmd) != 0; a++)
+                    ;
+                if(a > VM_SOLD_OUT)
+                    goto bad;
+                c = last_output == (enum vending_output)a;
+            }
+            else
+                goto bad;
+
+            if(!c)
+            {
+                printf("%s:%d: FAIL (credit %d, slot %d, last output %s)\n", name, lineno, vm.credit, vm.slot,
+                       output_names[last_output]);
+                fails++;
+            }
+        }
+        else
+        {
+            for(a = 0; a < (int)(sizeof(events) / sizeof(events[0])) && strcmp(events[a].cmd, cmd) != 0; a++)
+                ;
+            if(a == sizeof(events) / sizeof(events[0]))
+                goto bad;
+            ev.type = events[a].type;
+            vending_step(&vm, &ev);
+        }
+        continue;
+
+bad:
+        printf("%s:%d: bad line\n", name, lineno);
+        fails++;
+    }
+
+    return fails;
+}
+
+int main(int argc, char *argv[])
+{
+    int fails = 0;
+    FILE *f;
+
+    if(argc < 2)
+        fails = run(stdin, "stdin");
+
+    for(int i = 1; i < argc; i++)
+    {
+        if((f = fopen(argv[i], "r")) == NULL)
+        {
+            printf("%s: cannot open\n", argv[i]);
+            fails++;
+            continue;
+        }
+        fails += run(f, argv[i]);
+        fclose(f);
+    }
+
+    printf(fails ? "FAILED\n" : "OK\n");
+
+    return fails != 0;
+}
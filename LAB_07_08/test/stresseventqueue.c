@@ -0,0 +1,117 @@
+/** \file stresseventqueue.c
+ * 	\brief Stress test of the lock-free event queue
+ *
+ *  Several producer threads (the interrupts and the debounce work) and a consumer thread run
+ * flat out on a small queue, with random pauses to mix full and empty queues. Each producer
+ * puts its number on the pin and the count of the events it put on the stamp, so the consumer
+ * must get 0, 1, 2, ... from every producer: a lost, repeated or torn event breaks the sequence.
+ * At the end the events got plus the overflows must add up to the puts.
+ *
+ * \author André Brandão
+ * \author Emanuel Pereira
+ * \date 10/05/2022
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <sched.h>
+#include "event_queue.h"
+
+#define QUEUE_SIZE 8        /**< Queue size */
+#define NPRODUCERS 4        /**< Producer threads */
+#define NPUTS 200000u       /**< Events put by each producer */
+
+EVENT_QUEUE_DEFINE(queue, QUEUE_SIZE);
+
+static uint32_t puts_ok[NPRODUCERS];    /**< Events put by each producer */
+static uint32_t attempts[NPRODUCERS];   /**< Calls of event_queue_put() of each producer */
+static int finished;                    /**< Producers finished */
+
+/** \brief Producer thread, puts NPUTS events */
+static void *producer(void *arg)
+{
+    int id = (int)(long)arg;
+    unsigned int seed = id + 1;
+    struct vm_event ev = { .type = 1, .pin = id, .value = 0x5a5a };
+
+    while(puts_ok[id] < NPUTS)
+    {
+        attempts[id]++;
+        ev.stamp = puts_ok[id];
+        if(event_queue_put(&queue, &ev) == 0)
+            puts_ok[id]++;
+        else if(rand_r(&seed) % 16 == 0)
+            sched_yield();  // Full, let the consumer run
+
+        if(rand_r(&seed) % 4096 == 0)
+            sched_yield();  // Let the queue empty
+    }
+
+    __atomic_fetch_add(&finished, 1, __ATOMIC_RELEASE);
+    return NULL;
+}
+
+int main(void)
+{
+    pthread_t tid[NPRODUCERS];
+    uint32_t next[NPRODUCERS] = {0};
+    uint32_t gets = 0, fails = 0, total = 0, tries = 0;
+    struct vm_event ev;
+
+    if(event_queue_init(&queue) != 0 || event_queue_get(&queue, &ev) == 0)
+    {
+        printf("FAIL: init\n");
+        return 1;
+    }
+
+    for(long i = 0; i < NPRODUCERS; i++)
+        pthread_create(&tid[i], NULL, producer, (void *)i);
+
+    for(;;)
+    {
+        int done = __atomic_load_n(&finished, __ATOMIC_ACQUIRE) == NPRODUCERS;
+
+        if(event_queue_get(&queue, &ev) != 0)
+        {
+            if(done)
+                break;  // Empty after the last put
+            sched_yield();
+            continue;
+        }
+
+        gets++;
+        if(ev.pin >= NPRODUCERS || ev.type != 1 || ev.value != 0x5a5a || ev.stamp != next[ev.pin])
+        {
+            if(fails++ < 10)
+                printf("FAIL: event %u of producer %u, expected %u\n", ev.stamp, ev.pin,
+                       ev.pin < NPRODUCERS ? next[ev.pin] : 0);
+        }
+        else
+            next[ev.pin]++;
+    }
+
+    for(int i = 0; i < NPRODUCERS; i++)
+    {
+        pthread_join(tid[i], NULL);
+        total += puts_ok[i];
+        tries += attempts[i];
+    }
+
+    if(gets != total || tries - total != event_queue_overflows_get(&queue))
+    {
+        printf("FAIL: %u puts, %u gets, %u attempts, %u overflows\n", total, gets, tries,
+               event_queue_overflows_get(&queue));
+        fails++;
+    }
+    if(event_queue_high_water_get(&queue) > QUEUE_SIZE || event_queue_count(&queue) != 0)
+    {
+        printf("FAIL: high water %u, count %u\n", event_queue_high_water_get(&queue), event_queue_count(&queue));
+        fails++;
+    }
+
+    printf("%u events, %u overflows, high water %u\n", gets, event_queue_overflows_get(&queue),
+           event_queue_high_water_get(&queue));
+    printf(fails ? "FAILED\n" : "OK\n");
+
+    return fails != 0;
+}
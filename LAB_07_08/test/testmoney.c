@@ -0,0 +1,164 @@
+/** \file testmoney.c
+ * 	\brief Property tests of the money module
+ *
+ *  The formatter is checked against snprintf() on every amount up to +-10000 euros, the
+ * limits and millions of random amounts. Then millions of random events (coins, product
+ * selection, purchases and returns) run through the state machine of the application
+ * (vending.c, on the simulated catalog), and after each one the credit must equal the coins
+ * inserted minus the products paid and the credit returned, counted apart by the test,
+ * and the status line must show it formatted as the reference: there is no drift, ten coins
+ * of 10 cents are 1.00. A purchase must succeed exactly when the credit covers the price.
+ *
+ * \author André Brandão
+ * \author Emanuel Pereira
+ * \date 10/05/2022
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "money.h"
+#include "vending.h"
+#include "simcatalog.h"
+
+#define NRANDOM 5000000     /**< Random amounts formatted */
+#define NTRANSACTIONS 5000000   /**< Random events of the state machine */
+
+static int fails;
+
+static const money_t prices[] = {MONEY_CENTS(1, 50), MONEY_CENTS(1, 0), MONEY_CENTS(0, 50), MONEY_CENTS(0, 15)};
+
+static long long sold[4], returned;         /**< Products dispensed per slot, credit returned */
+static char status_credit[MONEY_STR_SIZE];  /**< Credit of the last status line */
+static int dispensed;                       /**< The last event dispensed a product */
+
+/** \brief Output function of the state machine, counts the sales and the returns */
+static void test_output(enum vending_output out, const struct catalog_item *item, money_t amount, money_t credit)
+{
+    if(out == VM_STATUS)
+        money_format(credit, status_credit);
+    else if(out == VM_DISPENSED)
+    {
+        sold[item->slot]++;
+        dispensed = 1;
+    }
+    else if(out == VM_RETURNED)
+        returned += amount;
+}
+
+static const struct vending_env test_env = {
+    .count = sim_catalog_count,
+    .slot = sim_catalog_slot,
+    .get = sim_catalog_get,
+    .sell = sim_catalog_sell,
+    .output = test_output,
+};
+
+/** \brief Checks the format of an amount against snprintf() */
+static void check_format(money_t amount)
+{
+    char buf[MONEY_STR_SIZE], ref[32];
+    long long a = amount;
+
+    snprintf(ref, sizeof(ref), "%s%lld.%02lld", a < 0 ? "-" : "", llabs(a) / 100, llabs(a) % 100);
+    if(strcmp(money_format(amount, buf), ref) != 0 && fails++ < 10)
+        printf("FAIL: %d formatted \"%s\", expected \"%s\"\n", amount, buf, ref);
+}
+
+/** \brief Random number from xorshift32 */
+static uint32_t rnd(void)
+{
+    static uint32_t x = 1;
+
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return x;
+}
+
+int main(void)
+{
+    static const money_t coins[] = {10, 20, 50, 100};
+    static const char *names[] = {"Beer", "Tuna Sandwich", "Coffee", "Gum"};
+    long long inserted[4] = {0}, ref;
+    money_t credit = 0;
+    char buf[MONEY_STR_SIZE], refbuf[32];
+    struct vending vm;
+    struct vm_event ev = {0};
+    struct catalog_item item;
+    int paid;
+
+    /* Formatter */
+    for(money_t a = -1000000; a <= 1000000; a++)
+        check_format(a);
+    check_format(INT32_MAX);
+    check_format(INT32_MIN);
+    check_format(INT32_MIN + 1);
+    for(int i = 0; i < NRANDOM; i++)
+        check_format((money_t)rnd());
+
+    /* Ten coins of 10 cents */
+    for(int i = 0; i < 10; i++)
+        credit += coins[0];
+    if(strcmp(money_format(credit, buf), "1.00") != 0 || strcmp(money_format(15, buf), "0.15") != 0)
+    {
+        printf("FAIL: 10 x 0.10 = %s\n", money_format(credit, buf));
+        fails++;
+    }
+    credit = 0;
+
+    /* Transactions */
+    sim_catalog_clear();
+    for(int i = 0; i < 4; i++)
+        sim_catalog_set(i, names[i], prices[i], UINT16_MAX);
+    vending_init(&vm, &test_env, 0);
+
+    for(int t = 0; t < NTRANSACTIONS; t++)
+    {
+        uint32_t r = rnd();
+        int i = (r >> 8) % 4;
+
+        switch(r % 8)
+        {
+            case 0: case 1: case 2:             // Coin
+                ev.type = COIN;
+                ev.value = coins[i];
+                inserted[i]++;
+                break;
+            case 3:                             // Other product
+                ev.type = (r & 0x10000) ? UP : DOWN;
+                break;
+            case 4: case 5: case 6:             // Purchase
+                ev.type = SELECT;
+                break;
+            default:                            // Return, now and then
+                ev.type = (r % 64 == 7) ? RETURN : UP;
+                break;
+        }
+
+        sim_catalog_get(vm.slot, &item);
+        if(item.stock < 2)
+            sim_catalog_set(vm.slot, item.name, item.price, UINT16_MAX);   // Restock
+        paid = ev.type == SELECT && vm.credit >= prices[vm.slot];
+        dispensed = 0;
+
+        vending_step(&vm, &ev);
+        credit = vm.credit;
+
+        ref = 0;
+        for(i = 0; i < 4; i++)
+            ref += inserted[i] * coins[i] - sold[i] * prices[i];
+        ref -= returned;
+
+        snprintf(refbuf, sizeof(refbuf), "%lld.%02lld", ref / 100, ref % 100);
+        if((ref != credit || credit < 0 || paid != dispensed || strcmp(status_credit, refbuf) != 0) && fails++ < 10)
+            printf("FAIL: event %d, credit %s (shown %s), expected %s, %s\n", t, money_format(credit, buf),
+                   status_credit, refbuf, paid != dispensed ? "wrong purchase result" : "");
+    }
+
+    printf("%lld coins, %lld products, %lld.%02lld returned, credit %s\n",
+           inserted[0] + inserted[1] + inserted[2] + inserted[3], sold[0] + sold[1] + sold[2] + sold[3],
+           returned / 100, returned % 100, money_format(credit, buf));
+    printf(fails ? "FAILED\n" : "OK\n");
+
+    return fails != 0;
+}
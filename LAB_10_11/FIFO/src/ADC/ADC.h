@@ -1,6 +1,24 @@
 /** \file ADC.h
  * 	\brief Module that implements ADC operations in nRF52840DK_nRF52840 board
  *
+ *  Besides single conversions (adc_sample()) the module has a continuous acquisition
+ * mode, started with adc_continuous_start(), that delivers blocks of ADC_BLOCK_SIZE
+ * samples (adc_block_get() / adc_block_release()), so the consumer wakes once per block.
+ *  When built with CONFIG_NRFX_SAADC (and the Zephyr ADC driver disabled, see
+ * continuous.conf) the SAADC is driven directly: a TIMER triggers each conversion
+ * through PPI and EasyDMA fills the blocks in ping-pong, with no CPU work per sample.
+ * Otherwise the Zephyr ADC API is used (timed sequence of ADC_BLOCK_SIZE samplings
+ * per block, read by an acquisition thread, not by DMA), which also runs on native_posix
+ * with the ADC emulator. In both cases a late consumer loses the oldest full block
+ * (adc_overruns_get()).
+ *  Several sensors can be read in a single conversion sequence with the scan mode:
+ * adc_scan_config() sets up the channels of a table (each with its own gain, reference
+ * and oversampling) and adc_scan() converts them all into an interleaved buffer,
+ * reporting each result to the callback of its channel.
+ *  Samples are converted to millivolts with integer arithmetic (ADC_conv.h), optionally
+ * through a linearization table given by the board (adc_board_lut()), and out of range
+ * samples are reported by adc_convert() instead of being silently mapped to 0.
+ *
  * \author André Brandão
  * \author Emanuel Pereira
  * \date 29/05/2022
@@ -9,34 +27,94 @@
 #define _ADC_H
 
 #include <drivers/adc.h> //Import ADC Drivers definitions
+#include "ADC_conv.h"
 
 /*ADC definitions and includes*/
+#ifdef CONFIG_SOC_FAMILY_NRF
 #include <hal/nrf_saadc.h>
+#endif
 
 #define ADC_NID DT_NODELABEL(adc) /**<  ADC Node Label from device tree (refer to dts file)*/
-#define ADC_RESOLUTION 10 /**< ADC Resolution */
-#define ADC_GAIN ADC_GAIN_1_4 /**< ADC Gain */
-#define ADC_REFERENCE ADC_REF_VDD_1_4 /**< ADC Reference Tension */
-#define ADC_ACQUISITION_TIME ADC_ACQ_TIME(ADC_ACQ_TIME_MICROSECONDS, 40) /**< ADC Acquisition Time */
+#define ADC_GAIN ADC_GAIN_1_4 /**< ADC Gain (ADC_GAIN_INV in ADC_conv.h must match) */
+#define ADC_REFERENCE ADC_REF_VDD_1_4 /**< ADC Reference Tension (ADC_REF_MV in ADC_conv.h must match) */
+
+/** Inverse of a gain of the Zephyr ADC API (reductions only), 0 otherwise */
+#define ADC_GAIN_INV_OF(g) ((g) == ADC_GAIN_1_6 ? 6 : (g) == ADC_GAIN_1_5 ? 5 : (g) == ADC_GAIN_1_4 ? 4 : \
+                            (g) == ADC_GAIN_1_3 ? 3 : (g) == ADC_GAIN_1_2 ? 2 : (g) == ADC_GAIN_1 ? 1 : 0)
+/** Tension (mV) of a VDD reference of the Zephyr ADC API, 0 otherwise */
+#define ADC_REF_MV_OF(r) ((r) == ADC_REF_VDD_1 ? ADC_VDD_MV : (r) == ADC_REF_VDD_1_2 ? ADC_VDD_MV / 2 : \
+                          (r) == ADC_REF_VDD_1_3 ? ADC_VDD_MV / 3 : (r) == ADC_REF_VDD_1_4 ? ADC_VDD_MV / 4 : 0)
+#define ADC_ACQ_TIME_US 40 /**< ADC Acquisition Time (us), the SAADC needs 40 us for sources up to 800 kΩ */
+#define ADC_ACQUISITION_TIME ADC_ACQ_TIME(ADC_ACQ_TIME_MICROSECONDS, ADC_ACQ_TIME_US) /**< ADC Acquisition Time */
+#define ADC_CONV_TIME_US 2 /**< Conversion time of the SAADC (us), added to the acquisition time of each sample */
+/** Maximum sampling rate (Hz) with an acquisition time of acq_us (one sample per acquisition plus conversion) */
+#define ADC_MAX_RATE_OF(acq_us) (1000000 / ((acq_us) + ADC_CONV_TIME_US))
 #define ADC_CHANNEL_ID 1 /**< ADC Channel ID */
 
 /* This is the actual nRF ANx input to use. Note that a channel can be assigned to any ANx. In fact a channel can */
-/*    be assigned to two ANx, when differential reading is set (one ANx for the positive signal and the other one for the negative signal) */  
+/*    be assigned to two ANx, when differential reading is set (one ANx for the positive signal and the other one for the negative signal) */
 /* Note also that the configuration of differnt channels is completely independent (gain, resolution, ref voltage, ...) */
 #define ADC_CHANNEL_INPUT NRF_SAADC_INPUT_AIN1 /**< ADC INPUT PIN */
 
 #define BUFFER_SIZE 1 /**< ADC sampling Buffer Size */
 
+#define ADC_BLOCK_SIZE 64 /**< Number of samples of each block (continuous mode) */
+#define ADC_NUM_BLOCKS 4  /**< Number of blocks (continuous mode), DMA uses two, the others are queued or in use */
+
+#define ADC_SCAN_MAX_CHANNELS 8 /**< Maximum number of channels of a scan (SAADC channels) */
+
 /**< ADC channel configuration */
 static const struct adc_channel_cfg my_channel_cfg = {
 	.gain = ADC_GAIN,
 	.reference = ADC_REFERENCE,
 	.acquisition_time = ADC_ACQUISITION_TIME,
 	.channel_id = ADC_CHANNEL_ID,
+#ifdef CONFIG_ADC_CONFIGURABLE_INPUTS
 	.input_positive = ADC_CHANNEL_INPUT
+#endif
+};
+
+/** Block of samples of the continuous mode */
+struct adc_block {
+	void *fifo_reserved;                /**< 1st word reserved for use by FIFO */
+	int16_t samples[ADC_BLOCK_SIZE];    /**< Raw ADC samples */
+};
+
+/** Function called with the result of each channel of a scan
+ *
+ * \param channel_id channel of the result
+ * \param raw ADC sample
+ * \param mv sample converted to millivolts (gain and reference of the channel), -1 if unknown
+ * \param user_data pointer given in the channel table
+ */
+typedef void (*adc_channel_callback)(uint8_t channel_id, int16_t raw, int32_t mv, void *user_data);
+
+/** Channel of a scan (entry of the table given to adc_scan_config()) */
+struct adc_scan_channel {
+	uint8_t channel_id;             /**< ADC channel, unique in the table (0 to ADC_SCAN_MAX_CHANNELS-1) */
+	uint8_t input;                  /**< nRF ANx input (NRF_SAADC_INPUT_AINx) */
+	enum adc_gain gain;             /**< Gain */
+	enum adc_reference reference;   /**< Reference tension */
+	uint16_t acquisition_time;      /**< Acquisition time (ADC_ACQ_TIME()) */
+	uint8_t oversampling;           /**< Samples averaged per result (log2), 0 for none */
+	adc_channel_callback callback;  /**< Called with the result of the channel (can be NULL) */
+	void *user_data;                /**< Given to the callback */
 };
 
 void adc_config(void);
 uint16_t adc_sample(void);
+uint16_t adc_to_mv(int16_t raw);
+int adc_convert(int16_t raw, uint16_t *mv);
+uint32_t adc_saturations_get(void);
+const uint16_t *adc_board_lut(void);
+
+int adc_continuous_start(uint32_t rate_hz);
+void adc_continuous_stop(void);
+struct adc_block *adc_block_get(k_timeout_t timeout);
+void adc_block_release(struct adc_block *block);
+uint32_t adc_overruns_get(void);
+
+int adc_scan_config(const struct adc_scan_channel *table, uint8_t n);
+int adc_scan(int16_t *samples);
 
-#endif // _ADC_H
\ No newline at end of file
+#endif // _ADC_H
@@ -0,0 +1,102 @@
+/** \file dsp_filter.h
+ * 	\brief Module implementing a library of fixed-point digital filters
+ *
+ *  Every filter is used through the same interface (dsp_filter_step(), dsp_filter_block(),
+ * dsp_filter_reset()), the type is chosen by the init function, so a pipeline can select
+ * its filter at build time or change it at runtime:
+ *  - running median of a window of samples
+ *  - exponential moving average
+ *  - FIR with Q15 taps
+ *  - cascade of IIR biquads, Q15 or Q31 coefficients (direct form I)
+ *
+ *  Samples are Q15 (the millivolts of the ADC fit as they are). The kernels follow the
+ * CMSIS-DSP conventions (coefficient layout, 64-bit accumulators, truncation and
+ * saturation of the result), so they map onto the Cortex-M4 multiply-accumulate
+ * instructions (SMLALD / SMLAL), and can be swapped for the CMSIS-DSP functions.
+ *  The storage is given by the user, there is no dynamic memory.
+ *
+ * \author André Brandão
+ * \author Emanuel Pereira
+ * \date 29/05/2022
+ */
+#ifndef _DSP_FILTER_H
+#define _DSP_FILTER_H
+
+#include <stdint.h>
+
+typedef int16_t q15_t; /**< Q15 fixed point (1.15) */
+typedef int32_t q31_t; /**< Q31 fixed point (1.31) */
+
+/** Filter types */
+enum dsp_filter_type {
+    DSP_MEDIAN = 1,     /**< Running median */
+    DSP_EMA,            /**< Exponential moving average */
+    DSP_FIR,            /**< FIR, Q15 taps */
+    DSP_BIQUAD_Q15,     /**< Biquad cascade, Q15 coefficients */
+    DSP_BIQUAD_Q31,     /**< Biquad cascade, Q31 coefficients */
+};
+
+struct dsp_filter;
+
+/** Operations of a filter type */
+struct dsp_filter_ops {
+    enum dsp_filter_type type;                          /**< Filter type */
+    q15_t (*step)(struct dsp_filter *f, q15_t x);       /**< Filters one sample */
+    void (*block)(struct dsp_filter *f, const q15_t *in, q15_t *out, uint32_t n); /**< Filters a block of samples */
+    void (*reset)(struct dsp_filter *f);                /**< Clears the filter state */
+};
+
+/** Filter, initialized by one of the dsp_*_init() functions */
+struct dsp_filter {
+    const struct dsp_filter_ops *ops;   /**< Operations of the filter type */
+    union {
+        struct {
+            q15_t *ring;        /**< Window, in arrival order */
+            q15_t *sorted;      /**< Window, sorted */
+            uint16_t size;      /**< Window size */
+            uint16_t pos;       /**< Position of the oldest sample in ring */
+        } median;               /**< DSP_MEDIAN */
+        struct {
+            q15_t alpha;        /**< Weight of the new sample */
+            q31_t acc;          /**< Output, Q15.16 */
+        } ema;                  /**< DSP_EMA */
+        struct {
+            const q15_t *taps;  /**< Coefficients, taps[0] weights the newest sample */
+            q15_t *state;       /**< Last samples (2 * ntaps, duplicated to avoid the wrap) */
+            uint16_t ntaps;     /**< Number of taps */
+            uint16_t pos;       /**< Position of the newest sample in state */
+        } fir;                  /**< DSP_FIR */
+        struct {
+            const void *coeffs; /**< Coefficients of each stage (q15_t or q31_t) */
+            void *state;        /**< x[n-1], x[n-2], y[n-1], y[n-2] of each stage (q15_t or q31_t) */
+            uint8_t nstages;    /**< Number of stages */
+            int8_t post_shift;  /**< Left shift of each stage output (coefficients scaled down by 2^post_shift) */
+        } biquad;               /**< DSP_BIQUAD_Q15 and DSP_BIQUAD_Q31 */
+    } s;                        /**< State of the filter type */
+};
+
+#define DSP_MEDIAN_MAX 255 /**< Biggest median window */
+
+/** Storage of the window of a median of N samples (q15_t) */
+#define DSP_MEDIAN_BUF_SIZE(N) (2*(N))
+/** Storage of the state of a FIR of N taps (q15_t) */
+#define DSP_FIR_STATE_SIZE(N) (2*(N))
+/** Coefficients of a Q15 biquad cascade of N stages {b0, 0, b1, b2, a1, a2} (q15_t) */
+#define DSP_BIQUAD_Q15_COEFFS_SIZE(N) (6*(N))
+/** Coefficients of a Q31 biquad cascade of N stages {b0, b1, b2, a1, a2} (q31_t) */
+#define DSP_BIQUAD_Q31_COEFFS_SIZE(N) (5*(N))
+/** Storage of the state of a biquad cascade of N stages (q15_t or q31_t) */
+#define DSP_BIQUAD_STATE_SIZE(N) (4*(N))
+
+int dsp_median_init(struct dsp_filter *f, q15_t *buf, uint16_t size);
+int dsp_ema_init(struct dsp_filter *f, q15_t alpha);
+int dsp_fir_init(struct dsp_filter *f, const q15_t *taps, uint16_t ntaps, q15_t *state);
+int dsp_biquad_q15_init(struct dsp_filter *f, const q15_t *coeffs, uint8_t nstages, int8_t post_shift, q15_t *state);
+int dsp_biquad_q31_init(struct dsp_filter *f, const q31_t *coeffs, uint8_t nstages, int8_t post_shift, q31_t *state);
+
+q15_t dsp_filter_step(struct dsp_filter *f, q15_t x);
+void dsp_filter_block(struct dsp_filter *f, const q15_t *in, q15_t *out, uint32_t n);
+void dsp_filter_reset(struct dsp_filter *f);
+enum dsp_filter_type dsp_filter_type_get(const struct dsp_filter *f);
+
+#endif // _DSP_FILTER_H
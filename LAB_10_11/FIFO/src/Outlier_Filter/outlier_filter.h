@@ -0,0 +1,52 @@
+/** \file outlier_filter.h
+ * 	\brief Module implementing an incremental outlier-rejecting moving average
+ *
+ *  Keeps a window of the last N samples and outputs the average of the samples within
+ * ±10% of the window average, the same result as the filter() of the applications.
+ * The samples are kept in a treap (randomized binary search tree) with the count and
+ * sum of each subtree, so a new sample and the output cost O(log N) instead of O(N).
+ * The storage is given by the user (OFILTER_DEFINE()), there is no dynamic memory.
+ *
+ * \author André Brandão
+ * \author Emanuel Pereira
+ * \date 29/05/2022
+ */
+#ifndef _OUTLIER_FILTER_H
+#define _OUTLIER_FILTER_H
+
+#include <stdint.h>
+
+#define OFILTER_MAX_SIZE 65534 /**< Biggest window */
+
+/** Sample of the window (node of the treap) */
+struct ofilter_node {
+    int64_t sum;        /**< Sum of the samples of the subtree */
+    int val;            /**< Sample */
+    uint32_t prio;      /**< Random priority (heap order of the treap) */
+    uint16_t left;      /**< Left child */
+    uint16_t right;     /**< Right child */
+    uint16_t cnt;       /**< Number of samples of the subtree */
+};
+
+/** Outlier filter */
+struct ofilter {
+    struct ofilter_node *nodes; /**< Window, node i holds sample i of the ring */
+    int size;                   /**< Window size */
+    int pos;                    /**< Next position of the ring */
+    uint16_t root;              /**< Root of the treap */
+    int64_t sum;                /**< Sum of the window */
+    uint32_t seed;              /**< Random generator state */
+};
+
+/** Declares the storage of a filter with a window of N samples (call ofilter_init() before use) */
+#define OFILTER_DEFINE(name, N) \
+    static struct ofilter_node name##_nodes[N]; \
+    static struct ofilter name = { .nodes = name##_nodes, .size = (N) }
+
+int ofilter_init(struct ofilter *f);
+void ofilter_insert(struct ofilter *f, int val);
+void ofilter_insert_block(struct ofilter *f, const uint16_t *vals, int n);
+int ofilter_output(const struct ofilter *f);
+int ofilter_scan(const struct ofilter *f);
+
+#endif // _OUTLIER_FILTER_H
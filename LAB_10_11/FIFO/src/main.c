@@ -6,6 +6,17 @@
  * The Digital filter consists in a moving average filter that removes the outliers (10% or high deviation from average)
  * and outputs the average of the remaining samples. This average is computed into a pulse width of a pwm signal that is 
  * applied to one of the DevKit leds. It was implemented recuuring to threads and fifo.
+ *  The fifo items are blocks of static memory slabs, the producer allocates a block and gives
+ * its ownership to the consumer through the fifo, which frees it after use (zero-copy, no heap).
+ * When a slab runs dry the item is dropped and counted, the statistics are printed periodically.
+ *  The samples are handed over in blocks of BLOCK_SIZE, the processing thread wakes once per block
+ * and outputs one average every DECIMATION samples. In continuous mode (ACQ_RATE_HZ) the blocks of
+ * ADC_BLOCK_SIZE samples of the ADC are handed over as they are and filtered in place. The latency and processing time of each block
+ * are measured to choose BLOCK_SIZE.
+ *  Every sample gets a sequence number and its acquisition instant, the averages carry the ones of
+ * their newest sample up to the actuation, which measures the sample to PWM latency and counts the
+ * sequence numbers lost on the way. With TRACE_ENABLE each average is printed as trace events
+ * (Chrome trace JSON, opened by Perfetto), see tools/trace_capture.py.
  *  It was implemented using the board Nordic nrf52840-dk.
  * 
  * \author André Brandão
@@ -26,9 +37,37 @@
 /* import ADC file */
 #include <ADC.h>
 
-#define SAMP_PERIOD_MS  1000 /**< Sample period (ms) */
+/* import outlier filter file */
+#include <outlier_filter.h>
+
+/* import DSP filter library */
+#include <dsp_filter.h>
+
+/* import periodic task file */
+#include <periodic_task.h>
+
+#define SAMP_PERIOD_US  1000000 /**< Sample period (us), can be set below 1 ms */
+#define SAMP_POLICY PERIODIC_SKIP   /**< Releases of the sampling thread missed by a late sample are dropped */
+#define ACQ_RATE_HZ 0   /**< Continuous acquisition rate (Hz), 0 to sample once every SAMP_PERIOD_US */
+
+#define NBLOCKS 8   /**< Number of blocks of each memory slab (items in flight on each fifo) */
+#define STATS_PERIOD 10 /**< Number of samples between pipeline statistics reports */
+
+#define BLOCK_SIZE 1    /**< Number of samples of each sample fifo item (1 to process every sample) */
+#define DECIMATION 1    /**< Number of filtered samples per average given to the actuation */
+#define TRACE_ENABLE 0  /**< 1 to print the trace events of each average on the console */
+
+BUILD_ASSERT(BLOCK_SIZE >= 1 && DECIMATION >= 1, "Block size and decimation must be positive");
+
+#define PROC_BLOCK_MAX MAX(BLOCK_SIZE, ADC_BLOCK_SIZE) /**< Biggest block given to the processing */
 
 #define SIZE 10 /**< Window Size of samples (digital filter) */
+#define FILTER_INCREMENTAL 1 /**< 1 to filter with the O(log SIZE) outlier filter, 0 with filter() */
+#define DSP_FILTER 0 /**< 0 for the outlier filter, or the DSP filter type (DSP_MEDIAN, DSP_EMA, DSP_FIR, DSP_BIQUAD_Q15, DSP_BIQUAD_Q31) */
+
+#define DSP_MEDIAN_SIZE 9   /**< Window of the median filter */
+#define DSP_EMA_ALPHA 4096  /**< Weight of the new sample of the EMA filter (Q15, 1/8) */
+#define DSP_FIR_TAPS 8      /**< Taps of the FIR filter */
 
 #define STACK_SIZE 1024 /**< Size of stack area used by each thread */
 
@@ -56,15 +95,63 @@ k_tid_t thread_processing_tid;  /**< Processing thread task ID */
 k_tid_t thread_actuation_tid;   /**< Actuation thread task ID */
 
 /* Create fifos*/
-struct k_fifo fifo_sample;   /**< Fifo sample data*/
-struct k_fifo fifo_average;  /**< Fifo average data*/
+K_FIFO_DEFINE(fifo_sample);   /**< Fifo sample data*/
+K_FIFO_DEFINE(fifo_average);  /**< Fifo average data*/
  
 /** Create fifo data structure and variables */
 struct data_item_t {
     void *fifo_reserved;    /**< 1st word reserved for use by FIFO */
     uint16_t data;          /**< Actual data */
+    uint32_t seq;           /**< Sequence number of the newest sample of the average */
+    int64_t stamp_us;       /**< Acquisition instant of the newest sample of the average (us) */
+    int64_t proc_us;        /**< Instant the average was computed (us) */
+};
+
+/** Sample fifo item, a block of samples or a block of the continuous acquisition */
+struct sample_block_t {
+    void *fifo_reserved;            /**< 1st word reserved for use by FIFO */
+    timing_t ready;                 /**< Instant the block was given to the processing */
+    uint32_t seq;                   /**< Sequence number of the first sample */
+    struct adc_block *adc;          /**< ADC block (ADC_BLOCK_SIZE raw samples, released by the processing), NULL if the samples are in data */
+    uint32_t period_us;             /**< Sample period of the ADC block, stamp_us[0] is its newest sample */
+    int64_t stamp_us[BLOCK_SIZE];   /**< Acquisition instant of each sample (us) */
+    uint16_t data[BLOCK_SIZE];      /**< Samples, oldest first */
 };
 
+/* Create memory slabs for the fifo items */
+K_MEM_SLAB_DEFINE(sample_slab, sizeof(struct sample_block_t), NBLOCKS, 8);  /**< Blocks of the sample fifo items */
+K_MEM_SLAB_DEFINE(average_slab, sizeof(struct data_item_t), NBLOCKS, 8); /**< Blocks of the average fifo items */
+
+/** Pipeline statistics, each counter is only written by one thread */
+struct pipeline_stats {
+    uint32_t samples;           /**< Number of sampling periods */
+    uint32_t samples_dropped;   /**< Samples dropped because the sample slab was empty */
+    uint32_t averages_dropped;  /**< Averages dropped because the average slab was empty */
+    uint32_t sample_peak;       /**< Peak number of sample blocks in use */
+    uint32_t average_peak;      /**< Peak number of average blocks in use */
+    uint32_t blocks;            /**< Number of processed blocks */
+    uint64_t latency_max_ns;    /**< Peak time from the end of a block to the end of its processing */
+    uint64_t latency_sum_ns;    /**< Sum of the block latencies */
+    uint64_t busy_ns;           /**< Processing time of the blocks */
+    uint32_t actuations;        /**< Number of averages applied to the PWM */
+    uint32_t seq_lost;          /**< Sample sequence numbers lost before the actuation (dropped items) */
+    uint32_t e2e_max_us;        /**< Peak latency from the sample to the PWM update */
+    uint64_t e2e_sum_us;        /**< Sum of the sample to PWM latencies */
+};
+
+struct pipeline_stats stats; /**< Pipeline statistics */
+
+struct periodic_task sampling_task; /**< Releases of the sampling thread */
+
+OFILTER_DEFINE(window, SIZE); /**< Window of samples of the incremental filter */
+
+/* DSP filters parameters and storage */
+static const q15_t dsp_fir_taps[DSP_FIR_TAPS] = {4096, 4096, 4096, 4096, 4096, 4096, 4096, 4096};   /**< Moving average of 8 samples */
+static const q15_t dsp_biquad_q15[DSP_BIQUAD_Q15_COEFFS_SIZE(1)] = {329, 0, 658, 329, 25576, -10508}; /**< Butterworth low-pass, fc = 0.05 fs, post shift 1 */
+static const q31_t dsp_biquad_q31[DSP_BIQUAD_Q31_COEFFS_SIZE(1)] = {21564350, 43128699, 21564350, 1676130396, -688645970}; /**< Same low-pass, Q31 */
+static q15_t dsp_buf[DSP_MEDIAN_BUF_SIZE(DSP_MEDIAN_SIZE) + DSP_FIR_STATE_SIZE(DSP_FIR_TAPS)];    /**< Median window or FIR state */
+static q31_t dsp_state[DSP_BIQUAD_STATE_SIZE(1)];  /**< Biquad state */
+
 /** Circular array to store data */
 typedef struct {
     uint16_t data[SIZE];  /**< Array to store data*/
@@ -77,6 +164,12 @@ void thread_processing(void *argA, void *argB, void *argC);
 void thread_actuation(void *argA, void *argB, void *argC);
 
 int filter(uint16_t*);
+int dsp_config(struct dsp_filter*, enum dsp_filter_type);
+void sample_put(uint16_t, int64_t);
+void adc_block_put(struct adc_block*, int64_t, uint32_t);
+int64_t time_us(void);
+void trace_print(const struct data_item_t*, int64_t, uint32_t);
+void stats_print(void);
 void array_init(uint16_t*, int);
 int array_average(uint16_t*, int);
 
@@ -87,6 +180,9 @@ int array_average(uint16_t*, int);
  */
 void main(void) {
     
+    timing_init();  // Timing of the blocks processing
+    timing_start();
+
     /* Create tasks */
     thread_sampling_tid = k_thread_create(&thread_sampling_data, thread_sampling_stack,
         K_THREAD_STACK_SIZEOF(thread_sampling_stack), thread_sampling,
@@ -106,47 +202,75 @@ void main(void) {
 /** \brief Sampling thread
  *  
  *  This thread implements the sampling task.
- * It's a periodic thread that reads the adc with period SAMP_PERIOD_MS and stores it in the sample buffer.
- * After sampling triggers the processing task.
+ * It's a periodic thread (sampling_task) that reads the adc with period SAMP_PERIOD_US and stores it in a block of the sample slab.
+ * After sampling gives the block to the processing task through the fifo. If the slab is empty
+ * (processing is not keeping up) the sample is dropped.
+ *  When ACQ_RATE_HZ is set the adc runs in continuous mode instead, the thread wakes once per
+ * block of ADC_BLOCK_SIZE samples and gives the whole block to the processing (adc_block_put()).
+ *  The samples are grouped in blocks of BLOCK_SIZE by sample_put().
  * 
  * \pre adc_sample()
  * \pre adc_config()
  * 
- * \see SAMP_PERIOD_MS
+ * \see SAMP_PERIOD_US
+ * \see SAMP_POLICY
+ * \see ACQ_RATE_HZ
+ * \see BLOCK_SIZE
  * 
  */
 void thread_sampling(void *argA , void *argB, void *argC)
 {
-    /* Timing variables to control task periodicity */
-    int64_t fin_time=0, release_time=0;
-    struct data_item_t sample;
-
-    /* Create/Init fifos */
-    k_fifo_init(&fifo_sample);
+    uint16_t sample;
+    int64_t stamp;
+    struct adc_block *block;
+    const uint32_t rate_hz = ACQ_RATE_HZ;
+    uint32_t nblocks = 0;
     
     adc_config(); // Configure adc
+
+    if(rate_hz > 0 && adc_continuous_start(rate_hz) == 0)
+    {
+        while(1)
+        {
+            block = adc_block_get(K_FOREVER);   // Wait for a full block of samples
+            if(block == NULL)
+                continue;
+            stamp = time_us();  // Newest sample of the block
+
+            stats.samples += ADC_BLOCK_SIZE;
+            adc_block_put(block, stamp, 1000000 / rate_hz);  // Processing thread owns the block now
+
+            if(++nblocks % STATS_PERIOD == 0)
+            {
+                stats_print();
+                printk("adc overruns = %u\n", adc_overruns_get());
+            }
+        }
+    }
     
-    /* Compute next release instant */
-    release_time = k_uptime_get() + SAMP_PERIOD_MS;
+    periodic_task_init(&sampling_task, SAMP_PERIOD_US, SAMP_POLICY);
+    periodic_task_start(&sampling_task);    // First release now
 
     /* Thread loop */
     while(1)
     {
-        sample.data = adc_sample(); // Get adc sample
-        
+        stats.samples++;
+
+        stamp = time_us();
+        sample = adc_sample(); // Get adc sample
+            
         printk("\n----------------------------\n");
-        printk("\nsample = %d\n", sample.data);
+        printk("\nsample = %d\n", sample);
 
-        k_fifo_put(&fifo_sample, &sample);  // Store sample on FIFO
-       
-        
-        /* Wait for next release instant */ 
-        fin_time = k_uptime_get();
-        if( fin_time < release_time)
+        sample_put(sample, stamp);    // Store sample on the block, given to the processing thread when full
+
+        if(stats.samples % STATS_PERIOD == 0)
         {
-            k_msleep(release_time - fin_time);
-            release_time += SAMP_PERIOD_MS;
+            stats_print();
+            periodic_task_stats_print(&sampling_task, "sampling");
         }
+        
+        periodic_task_wait(&sampling_task);    // Wait for next release instant
     }
 
 }
@@ -155,33 +279,137 @@ void thread_sampling(void *argA , void *argB, void *argC)
  *  
  *  This thread implements the task of processing.
  * It filters the data samples and updates the average of the filtered data samples.
- * It's a sporadic thread triggered by the end of sampling (sampling thread). After processing
- * triggers the actuation task.
+ * It's a sporadic thread triggered by the end of a block of samples (sampling thread). The whole
+ * block is filtered at once and one average is given to the actuation task every DECIMATION samples,
+ * the filter output is only computed for these samples (the samples in between go to the outlier
+ * filter window at once, ofilter_insert_block()). It frees the sample blocks and allocates
+ * the average blocks, an average is dropped if the average slab is empty.
+ *  The samples of an ADC block are converted to mV in place and the block is given back to the
+ * ADC once they are filtered.
+ *  The latency of each block (from its handover to the end of its filtering) and the filtering
+ * time are added to the pipeline statistics.
  * 
  * \see filter(uint16_t *data)
+ * \see FILTER_INCREMENTAL
+ * \see DSP_FILTER
+ * \see BLOCK_SIZE
+ * \see DECIMATION
  * 
  */
 void thread_processing(void *argA , void *argB, void *argC)
 {
-    struct data_item_t *data_samples;
-    struct data_item_t average;
-    buffer buffer;
-    
-    /* Create/Init fifos */
-    k_fifo_init(&fifo_average);
+    struct sample_block_t *block;
+    struct data_item_t *average;
+#if !FILTER_INCREMENTAL
+    buffer buffer = {0};
+#endif
+    static q15_t out[PROC_BLOCK_MAX];   // DSP filter output of a block
+    static struct data_item_t avg[PROC_BLOCK_MAX / DECIMATION + 1];   // Averages of a block
+    uint16_t *data;
+    int len, chunk, last;
+    int navg;
+    int n = 0;  // Filtered samples since the last average
+    struct dsp_filter dsp;
+    int use_dsp;
+    timing_t start, end, ready;
+    uint64_t latency;
+
+    use_dsp = (dsp_config(&dsp, DSP_FILTER) == 0);  // Fails for 0, outlier filter
+    ofilter_init(&window);
     
     while(1)
     {
-        data_samples = k_fifo_get(&fifo_sample, K_FOREVER);  // Get sample from FIFO
-        buffer.data[buffer.head] = data_samples->data;   // Append to sample array
-       
-        buffer.head = (buffer.head + 1) % SIZE;     // Increment position to store data
-        
-        average.data = filter(buffer.data);     // Filter data
+        block = k_fifo_get(&fifo_sample, K_FOREVER);  // Get block of samples from FIFO
+        start = timing_counter_get();
+
+        if(block->adc)
+        {
+            data = (uint16_t *)block->adc->samples;    // Raw samples replaced by their mV
+            len = ADC_BLOCK_SIZE;
+            for(int i = 0; i < len; i++)
+                data[i] = adc_to_mv(block->adc->samples[i]);
+        }
+        else
+        {
+            data = block->data;
+            len = BLOCK_SIZE;
+        }
+
+        if(use_dsp)
+            dsp_filter_block(&dsp, (const q15_t *)data, out, len);  // Filter data, mV fit in q15_t
+
+        navg = 0;
+        for(int i = 0; i < len; i += chunk)
+        {
+            chunk = MIN(DECIMATION - n, len - i);  // Samples up to the next average
+            if(!use_dsp)
+            {
+#if FILTER_INCREMENTAL
+                ofilter_insert_block(&window, &data[i], chunk);    // Append to the filter window
+#else
+                for(int j = i; j < i + chunk; j++)
+                {
+                    buffer.data[buffer.head] = data[j];   // Append to sample array
+                    buffer.head = (buffer.head + 1) % SIZE;     // Increment position to store data
+                }
+#endif
+            }
+
+            n += chunk;
+            if(n < DECIMATION)
+                continue;
+            n = 0;
+            last = i + chunk - 1;   // Newest sample of the average
+
+            if(use_dsp)
+                avg[navg].data = out[last];
+            else
+#if FILTER_INCREMENTAL
+                avg[navg].data = ofilter_output(&window);  // Filter data
+#else
+                avg[navg].data = filter(buffer.data);     // Filter data
+#endif
+            avg[navg].seq = block->seq + last;
+            if(block->adc)
+                avg[navg].stamp_us = block->stamp_us[0] - (int64_t)(len - 1 - last) * block->period_us;
+            else
+                avg[navg].stamp_us = block->stamp_us[last];
+            navg++;
+        }
+
+        if(block->adc)
+            adc_block_release(block->adc);  // Give the block back to the acquisition
+        ready = block->ready;
+        k_mem_slab_free(&sample_slab, (void **)&block);  // Give the block back to the slab
+
+        end = timing_counter_get();
+        latency = timing_cycles_to_ns(timing_cycles_get(&ready, &end));
+        stats.busy_ns += timing_cycles_to_ns(timing_cycles_get(&start, &end));
+        stats.latency_sum_ns += latency;
+        if(latency > stats.latency_max_ns)
+            stats.latency_max_ns = latency;
+        stats.blocks++;
         
-        printk("\nnew average = %d\n",average.data);
-        k_fifo_put(&fifo_average, &average);    // Store average on FIFO
-         
+        for(int i = 0; i < navg; i++)
+        {
+            printk("\nnew average = %d\n", avg[i].data);
+
+            if(k_mem_slab_alloc(&average_slab, (void **)&average, K_NO_WAIT) == 0)
+            {
+                average->data = avg[i].data;
+                average->seq = avg[i].seq;
+                average->stamp_us = avg[i].stamp_us;
+                average->proc_us = time_us();
+                k_fifo_put(&fifo_average, average);    // Store average on FIFO, actuation thread owns it now
+
+                if(k_mem_slab_num_used_get(&average_slab) > stats.average_peak)
+                    stats.average_peak = k_mem_slab_num_used_get(&average_slab);
+            }
+            else
+            {
+                stats.averages_dropped++;   // Slab empty, actuation is not keeping up
+            }
+        }
     }
 }
 
@@ -190,14 +418,22 @@ void thread_processing(void *argA , void *argB, void *argC)
  *  This thread implements the task of actuation.
  * It computes the pulse width of the pwm signal from the average (computed on the processing task)
  * and updates the pwm signal. It's a sporadic thread triggered by the end of processing (processing thread).
+ *  After the update it measures the latency from the newest sample of the average and counts the
+ * sample sequence numbers lost since the last average (a gap bigger than DECIMATION).
+ * 
+ * \see TRACE_ENABLE
  */
 void thread_actuation(void *argA , void *argB, void *argC)
 {
-    const struct device *pwm0_dev;          /* Pointer to PWM device structure */
+    const struct device *pwm0_dev = NULL;   /* Pointer to PWM device structure */
     unsigned int pwmPeriod_us = 1000;       /* PWM priod in us */
     struct data_item_t *average;
+    uint32_t last_seq = 0, lost;
+    int64_t end, latency;
 
+#if DT_NODE_HAS_STATUS(PWM0_NID, okay)
     pwm0_dev = device_get_binding(DT_LABEL(PWM0_NID));
+#endif
     int ton=0;
 
     while(1)
@@ -208,7 +444,26 @@ void thread_actuation(void *argA , void *argB, void *argC)
         
         printk("ton = %d\n",ton);
         
-        pwm_pin_set_usec(pwm0_dev, BOARDLED_PIN, pwmPeriod_us, ton, PWM_POLARITY_NORMAL);   // Update PWM
+        if(pwm0_dev)    // No pwm on native_posix
+            pwm_pin_set_usec(pwm0_dev, BOARDLED_PIN, pwmPeriod_us, ton, PWM_POLARITY_NORMAL);   // Update PWM
+
+        end = time_us();
+        latency = end - average->stamp_us;
+        lost = 0;
+        if(stats.actuations > 0 && average->seq - last_seq > DECIMATION)
+            lost = average->seq - last_seq - DECIMATION;
+        last_seq = average->seq;
+
+        stats.actuations++;
+        stats.seq_lost += lost;
+        stats.e2e_sum_us += latency;
+        if(latency > stats.e2e_max_us)
+            stats.e2e_max_us = latency;
+
+        if(TRACE_ENABLE)
+            trace_print(average, end, lost);
+
+        k_mem_slab_free(&average_slab, (void **)&average);  // Give the block back to the slab
     }
 }
 
@@ -216,7 +471,8 @@ void thread_actuation(void *argA , void *argB, void *argC)
  *  
  *  This function implements a digital filter that removes the outliers
  * (10% or high deviation from average) from a set of data and computes the average
- * of the remaining samples.  
+ * of the remaining samples. It scans the whole window, the outlier filter module gives the
+ * same result incrementally (ofilter_output()).
  *
  * \param[in] data pointer to array 
  * 
@@ -258,6 +514,118 @@ int filter(uint16_t *data)
     return array_average(new_data, j);  // return average of filtered data
 }
 
+/** \brief Function to give a sample to the processing thread
+ *
+ *  Stores the sample on the current block and gives the block to the processing thread
+ * through the fifo when it is full. The block is allocated with its first sample, if the slab
+ * is empty (processing is not keeping up) the samples of the block are dropped. Every sample
+ * gets the next sequence number, dropped or not.
+ *
+ * \param[in] sample sample (mV)
+ * \param[in] stamp acquisition instant (us)
+ */
+void sample_put(uint16_t sample, int64_t stamp)
+{
+    static struct sample_block_t *block;
+    static int n = 0;   // Samples on the current block
+    static uint32_t seq = 0;    // Sequence number of the sample
+
+    if(n == 0 && k_mem_slab_alloc(&sample_slab, (void **)&block, K_NO_WAIT) != 0)
+        block = NULL;
+
+    if(block)
+    {
+        if(n == 0)
+        {
+            block->seq = seq;
+            block->adc = NULL;
+        }
+        block->data[n] = sample;
+        block->stamp_us[n] = stamp;
+    }
+    else
+    {
+        stats.samples_dropped++;
+    }
+    seq++;
+
+    n = (n + 1) % BLOCK_SIZE;
+
+    if(n == 0 && block)
+    {
+        block->ready = timing_counter_get();
+        k_fifo_put(&fifo_sample, block);  // Store block on FIFO, processing thread owns it now
+
+        if(k_mem_slab_num_used_get(&sample_slab) > stats.sample_peak)
+            stats.sample_peak = k_mem_slab_num_used_get(&sample_slab);
+    }
+}
+
+/** \brief Function to give a block of the continuous acquisition to the processing thread
+ *
+ *  Gives the ADC block to the processing thread through the fifo, without copying the samples,
+ * the processing thread releases it. If the slab is empty (processing is not keeping up) the
+ * block is given back to the ADC and its samples are dropped. Every sample gets the next
+ * sequence number, dropped or not.
+ *
+ * \param[in] adc block returned by adc_block_get()
+ * \param[in] stamp acquisition instant of the newest sample (us)
+ * \param[in] period_us sample period (us)
+ */
+void adc_block_put(struct adc_block *adc, int64_t stamp, uint32_t period_us)
+{
+    struct sample_block_t *block;
+    static uint32_t seq = 0;    // Sequence number of the first sample of the block
+
+    if(k_mem_slab_alloc(&sample_slab, (void **)&block, K_NO_WAIT) == 0)
+    {
+        block->seq = seq;
+        block->adc = adc;
+        block->period_us = period_us;
+        block->stamp_us[0] = stamp;
+        block->ready = timing_counter_get();
+        k_fifo_put(&fifo_sample, block);  // Store block on FIFO, processing thread owns it now
+
+        if(k_mem_slab_num_used_get(&sample_slab) > stats.sample_peak)
+            stats.sample_peak = k_mem_slab_num_used_get(&sample_slab);
+    }
+    else
+    {
+        adc_block_release(adc);
+        stats.samples_dropped += ADC_BLOCK_SIZE;
+    }
+    seq += ADC_BLOCK_SIZE;
+}
+
+/** \brief Function to configure a DSP filter
+ *
+ *  Initializes the filter with the parameters of the application for the given type,
+ * can be called at runtime to change the filter.
+ *
+ * \param[out] f filter
+ * \param[in] type filter type
+ *
+ * \returns 0 on success, -1 if the type is unknown
+ */
+int dsp_config(struct dsp_filter *f, enum dsp_filter_type type)
+{
+    switch(type)
+    {
+        case DSP_MEDIAN:
+            return dsp_median_init(f, dsp_buf, DSP_MEDIAN_SIZE);
+        case DSP_EMA:
+            return dsp_ema_init(f, DSP_EMA_ALPHA);
+        case DSP_FIR:
+            return dsp_fir_init(f, dsp_fir_taps, DSP_FIR_TAPS, dsp_buf);
+        case DSP_BIQUAD_Q15:
+            return dsp_biquad_q15_init(f, dsp_biquad_q15, 1, 1, (q15_t *)dsp_state);
+        case DSP_BIQUAD_Q31:
+            return dsp_biquad_q31_init(f, dsp_biquad_q31, 1, 1, dsp_state);
+        default:
+            return -1;
+    }
+}
+
 /** \brief Function to initialize integer array
  * 
  *  This function fills an integer array with zeros
@@ -290,4 +658,63 @@ int array_average(uint16_t *data, int size)
         printk("%d ", data[i]);
     }
     return sum / size;
+}
+
+/** \brief Function to print the pipeline statistics
+ * 
+ *  Prints the number of samples, the dropped items and the peak usage of each memory slab,
+ * and the latency of the blocks and the load of the processing thread (% of the uptime).
+ */
+void stats_print(void)
+{
+    uint32_t blocks = stats.blocks;
+    uint64_t uptime_ms = k_uptime_get();
+    uint32_t load = uptime_ms ? stats.busy_ns / (uptime_ms * 100) : 0;  // 0.01 %
+
+    printk("\nstats: samples = %u, dropped samples = %u, dropped averages = %u, "
+           "peak blocks sample = %u/%d, average = %u/%d\n",
+           stats.samples, stats.samples_dropped, stats.averages_dropped,
+           stats.sample_peak, NBLOCKS, stats.average_peak, NBLOCKS);
+    printk("blocks = %u (%d samples), latency avg = %u us, max = %u us, processing load = %u.%02u %%\n",
+           blocks, ACQ_RATE_HZ > 0 ? ADC_BLOCK_SIZE : BLOCK_SIZE, blocks ? (uint32_t)(stats.latency_sum_ns / blocks / 1000) : 0,
+           (uint32_t)(stats.latency_max_ns / 1000), load / 100, load % 100);
+    printk("actuations = %u, lost sequence numbers = %u, sample to PWM latency avg = %u us, max = %u us\n",
+           stats.actuations, stats.seq_lost,
+           stats.actuations ? (uint32_t)(stats.e2e_sum_us / stats.actuations) : 0, stats.e2e_max_us);
+}
+
+/** \brief Function to get the uptime in microseconds
+ *
+ *  Time base of the sequence of the samples and of the trace (kernel ticks resolution).
+ *
+ * \returns uptime (us)
+ */
+int64_t time_us(void)
+{
+    return k_ticks_to_us_floor64(k_uptime_ticks());
+}
+
+/** \brief Function to print the trace events of an average
+ *
+ *  Prints one console line per event, prefixed with "TRACE ", each one a Chrome trace event
+ * (JSON) of the pipeline process: the sampling to processing span (fifo wait and filter, thread 1),
+ * the processing to actuation span (thread 2) and an instant event when sequence numbers were lost.
+ * tools/trace_capture.py joins the lines in a trace file.
+ *
+ * \param[in] item average applied to the PWM
+ * \param[in] end instant of the PWM update (us)
+ * \param[in] lost sequence numbers lost before this average
+ */
+void trace_print(const struct data_item_t *item, int64_t end, uint32_t lost)
+{
+    printk("TRACE {\"name\":\"sample %u\",\"ph\":\"X\",\"pid\":1,\"tid\":1,\"ts\":%u,\"dur\":%u,"
+           "\"args\":{\"seq\":%u}}\n",
+           item->seq, (uint32_t)item->stamp_us, (uint32_t)(item->proc_us - item->stamp_us), item->seq);
+    printk("TRACE {\"name\":\"average %u\",\"ph\":\"X\",\"pid\":1,\"tid\":2,\"ts\":%u,\"dur\":%u,"
+           "\"args\":{\"seq\":%u,\"value\":%u,\"latency_us\":%u}}\n",
+           item->seq, (uint32_t)item->proc_us, (uint32_t)(end - item->proc_us), item->seq, item->data,
+           (uint32_t)(end - item->stamp_us));
+    if(lost)
+        printk("TRACE {\"name\":\"lost\",\"ph\":\"i\",\"s\":\"p\",\"pid\":1,\"tid\":2,\"ts\":%u,"
+               "\"args\":{\"lost\":%u}}\n", (uint32_t)end, lost);
 }
\ No newline at end of file
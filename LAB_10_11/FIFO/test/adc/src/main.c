@@ -0,0 +1,259 @@
+/** \file main.c
+ * 	\brief Test of the continuous acquisition and of the scan of the ADC module with the ADC emulator (native_posix)
+ *
+ *  adc_config() feeds the emulated channel with a sawtooth, 500 + (n % 100) * 20 mV for
+ * the n-th conversion. The blocks must arrive once every ADC_BLOCK_SIZE sample periods
+ * and hold consecutive points of the sawtooth. A consumer that stops reading loses the
+ * oldest blocks, counted as overruns, and one that holds every block stalls the
+ * acquisition without overruns until a block is released.
+ *  The scan mixes gains, references and three oversampling values on channels given out of
+ * order, each emulated channel at its own tension: every callback must get the raw sample
+ * and the millivolts of its own channel, every channel converted once per scan.
+ *
+ * \author André Brandão
+ * \author Emanuel Pereira
+ * \date 29/05/2022
+ */
+
+#include <ztest.h>
+#include <errno.h>
+#include <drivers/adc/adc_emul.h>
+#include <ADC.h>
+
+#define RATE_HZ 1000    /**< Sampling rate */
+#define NBLOCKS 10      /**< Blocks timed by the rate test */
+#define STALL 12        /**< Block periods the consumer stops reading */
+#define TOL_MV 6        /**< Conversion error (1 LSB truncated by the emulator, 1 by adc_to_mv()) */
+
+#define BLOCK_MS (ADC_BLOCK_SIZE * 1000 / RATE_HZ)  /**< Block period (ms) */
+
+#define ADC_NID DT_NODELABEL(adc)   /**< Emulated ADC */
+#define REF_INTERNAL_MV DT_PROP(ADC_NID, ref_internal_mv)  /**< Internal reference of the emulator */
+#define SCANS 3 /**< Scans of the scan test */
+
+/** Emulated input and results of a scanned channel */
+struct scan_input {
+    int32_t mv;         /**< Input tension */
+    int conversions;    /**< Conversions of the channel by the emulator */
+    int callbacks;      /**< Calls of the callback */
+    uint8_t channel_id; /**< Channel given to the callback */
+    int16_t raw;        /**< Raw sample given to the callback */
+    int32_t cb_mv;      /**< Millivolts given to the callback */
+};
+
+static struct scan_input inputs[] = {{.mv = 2400}, {.mv = 450}, {.mv = 1000}, {.mv = 2000}, {.mv = 1500}};   /**< One per entry of scan_table */
+
+/** \brief Callback of the scanned channels, keeps the result */
+static void scan_callback(uint8_t channel_id, int16_t raw, int32_t mv, void *user_data)
+{
+    struct scan_input *in = user_data;
+
+    in->callbacks++;
+    in->channel_id = channel_id;
+    in->raw = raw;
+    in->cb_mv = mv;
+}
+
+/** Channels of the scan, not sorted by id, oversampling 2, 0, 2, 0 and 1 */
+static const struct adc_scan_channel scan_table[] = {
+    { 5, 0, ADC_GAIN_1_4, ADC_REF_VDD_1_4, ADC_ACQUISITION_TIME, 2, scan_callback, &inputs[0] },
+    { 0, 0, ADC_GAIN_1, ADC_REF_INTERNAL, ADC_ACQUISITION_TIME, 0, scan_callback, &inputs[1] },
+    { 3, 0, ADC_GAIN_1_2, ADC_REF_VDD_1_2, ADC_ACQUISITION_TIME, 2, scan_callback, &inputs[2] },
+    { 6, 0, ADC_GAIN_1_6, ADC_REF_INTERNAL, ADC_ACQUISITION_TIME, 0, scan_callback, &inputs[3] },
+    { 2, 0, ADC_GAIN_1_3, ADC_REF_VDD_1, ADC_ACQUISITION_TIME, 1, scan_callback, &inputs[4] },
+};
+
+#define NSCAN ((int)ARRAY_SIZE(scan_table)) /**< Channels of the scan */
+
+/** \brief Emulated input of a scanned channel, counts its conversions */
+static int scan_signal(const struct device *dev, unsigned int chan, void *data, uint32_t *result)
+{
+    struct scan_input *in = data;
+
+    in->conversions++;
+    *result = in->mv;
+
+    return 0;
+}
+
+/** \brief Value of the sawtooth for the n-th conversion */
+static int sawtooth(uint32_t n)
+{
+    return 500 + (n % 100) * 20;
+}
+
+/** \brief Checks that a block holds the conversions n, n + 1, ... of the sawtooth
+ *
+ *  \param[in] block block of the acquisition
+ *  \param[in] n conversion of the first sample, -1 to find it from the sample
+ *
+ *  \returns conversion of the first sample of the next block
+ */
+static int64_t check_block(const struct adc_block *block, int64_t n)
+{
+    int mv;
+
+    if(n < 0)
+        n = (adc_to_mv(block->samples[0]) - 500 + 10) / 20;
+
+    for(int i = 0; i < ADC_BLOCK_SIZE; i++)
+    {
+        mv = adc_to_mv(block->samples[i]);
+        zassert_within(mv, sawtooth(n + i), TOL_MV, "sample %d: %d mV, %d mV expected", i, mv, sawtooth(n + i));
+    }
+
+    return n + ADC_BLOCK_SIZE;
+}
+
+/** \brief Blocks arrive at the rate, with consecutive samples and no overrun */
+static void test_rate(void)
+{
+    struct adc_block *block;
+    uint32_t overruns = adc_overruns_get();
+    int64_t n, start, elapsed;
+
+    zassert_equal(adc_continuous_start(RATE_HZ), 0, NULL);
+    zassert_equal(adc_continuous_start(RATE_HZ), -EBUSY, NULL);
+
+    block = adc_block_get(K_MSEC(2 * BLOCK_MS));
+    zassert_not_null(block, NULL);
+    start = k_uptime_get();
+    n = check_block(block, -1);
+    adc_block_release(block);
+
+    for(int i = 0; i < NBLOCKS; i++)
+    {
+        block = adc_block_get(K_MSEC(2 * BLOCK_MS));
+        zassert_not_null(block, "block %d", i);
+        n = check_block(block, n);
+        adc_block_release(block);
+    }
+    elapsed = k_uptime_get() - start;
+
+    adc_continuous_stop();
+
+    TC_PRINT("%d blocks in %lld ms\n", NBLOCKS, (long long)elapsed);
+    zassert_within(elapsed, NBLOCKS * BLOCK_MS, BLOCK_MS / 10, "%lld ms", (long long)elapsed);
+    zassert_equal(adc_overruns_get(), overruns, NULL);
+}
+
+/** \brief A consumer that stops reading loses the oldest blocks, counted as overruns */
+static void test_overrun(void)
+{
+    struct adc_block *block;
+    uint32_t overruns = adc_overruns_get();
+    int64_t n = -1;
+    int nready = 0;
+
+    zassert_equal(adc_continuous_start(RATE_HZ), 0, NULL);
+
+    k_msleep(STALL * BLOCK_MS + BLOCK_MS / 2);  // Blocks 0 to STALL - 1 are full, STALL is being read
+
+    zassert_equal(adc_overruns_get() - overruns, STALL + 1 - ADC_NUM_BLOCKS, "%u overruns",
+                  adc_overruns_get() - overruns);
+
+    while((block = adc_block_get(K_NO_WAIT)) != NULL)   // The newest full blocks, in order
+    {
+        n = check_block(block, n);
+        adc_block_release(block);
+        nready++;
+    }
+    zassert_equal(nready, ADC_NUM_BLOCKS - 1, NULL);
+
+    block = adc_block_get(K_MSEC(2 * BLOCK_MS));    // The acquisition goes on
+    zassert_not_null(block, NULL);
+    check_block(block, n);
+    adc_block_release(block);
+
+    adc_continuous_stop();
+}
+
+/** \brief A consumer that holds every block stalls the acquisition, nothing is lost */
+static void test_stall(void)
+{
+    struct adc_block *blocks[ADC_NUM_BLOCKS];
+    uint32_t overruns = adc_overruns_get();
+    int64_t n = -1;
+
+    zassert_equal(adc_continuous_start(RATE_HZ), 0, NULL);
+
+    for(int i = 0; i < ADC_NUM_BLOCKS; i++)
+    {
+        blocks[i] = adc_block_get(K_MSEC(2 * BLOCK_MS));
+        zassert_not_null(blocks[i], "block %d", i);
+        n = check_block(blocks[i], n);
+    }
+
+    zassert_is_null(adc_block_get(K_MSEC(3 * BLOCK_MS)), "no block to fill");
+    zassert_equal(adc_overruns_get(), overruns, NULL);
+
+    adc_block_release(blocks[0]);   // Resumes the acquisition
+    blocks[0] = adc_block_get(K_MSEC(2 * BLOCK_MS));
+    zassert_not_null(blocks[0], NULL);
+    check_block(blocks[0], n);  // Continues where it stalled
+
+    for(int i = 0; i < ADC_NUM_BLOCKS; i++)
+        adc_block_release(blocks[i]);
+
+    adc_continuous_stop();
+    zassert_equal(adc_overruns_get(), overruns, NULL);
+}
+
+/** \brief Rates the ADC cannot reach are refused */
+static void test_limits(void)
+{
+    zassert_equal(adc_continuous_start(0), -EINVAL, NULL);
+    zassert_equal(adc_continuous_start(ADC_MAX_RATE_OF(ADC_ACQ_TIME_US) + 1), -EINVAL, NULL);
+}
+
+/** \brief Each channel of a scan gets its own raw sample and millivolts */
+static void test_scan(void)
+{
+    const struct device *dev = device_get_binding(DT_LABEL(ADC_NID));
+    int16_t samples[NSCAN];
+    int32_t full, raw, tol;
+
+    zassert_not_null(dev, "no ADC emulator");
+    zassert_equal(adc_scan_config(scan_table, NSCAN), 0, NULL);
+    for(int i = 0; i < NSCAN; i++)
+        zassert_equal(adc_emul_value_func_set(dev, scan_table[i].channel_id, scan_signal, &inputs[i]), 0, NULL);
+
+    for(int s = 1; s <= SCANS; s++)
+    {
+        zassert_equal(adc_scan(samples), 0, NULL);
+
+        for(int i = 0; i < NSCAN; i++)
+        {
+            const struct adc_scan_channel *ch = &scan_table[i];
+            struct scan_input *in = &inputs[i];
+
+            full = ch->reference == ADC_REF_INTERNAL ? REF_INTERNAL_MV : ADC_REF_MV_OF(ch->reference);
+            zassert_equal(adc_gain_invert(ch->gain, &full), 0, NULL);   // Input tension of the full scale
+            raw = (int64_t)in->mv * BIT(ADC_RESOLUTION) / full;
+            tol = 2 * full / BIT(ADC_RESOLUTION) + 1;    // Truncated by the emulator and by the conversion
+
+            zassert_equal(in->conversions, s, "channel %u: %d conversions", ch->channel_id, in->conversions);
+            zassert_equal(in->callbacks, s, "channel %u: %d callbacks", ch->channel_id, in->callbacks);
+            zassert_equal(in->channel_id, ch->channel_id, NULL);
+            zassert_within(in->raw, raw, 1, "channel %u: raw %d, %d expected", ch->channel_id, in->raw, raw);
+            zassert_equal(samples[i], in->raw, "channel %u: sample not in the order of the table", ch->channel_id);
+            zassert_within(in->cb_mv, in->mv, tol, "channel %u: %d mV, %d mV expected", ch->channel_id,
+                           in->cb_mv, in->mv);
+        }
+    }
+
+    zassert_equal(adc_scan_config(scan_table, ADC_SCAN_MAX_CHANNELS + 1), -EINVAL, NULL);
+}
+
+void test_main(void)
+{
+    adc_config();
+
+    ztest_test_suite(adc,
+                     ztest_unit_test(test_limits),
+                     ztest_unit_test(test_rate),
+                     ztest_unit_test(test_overrun),
+                     ztest_unit_test(test_stall),
+                     ztest_unit_test(test_scan));
+    ztest_run_test_suite(adc);
+}
@@ -0,0 +1,111 @@
+/** \file benchadcconv.c
+ * 	\brief Host benchmark of the ADC millivolt conversion
+ *
+ *  Checks the fixed-point conversion (adc_conv_mv()) against the exact integer result
+ * for every sample, including out of range ones, and compares the time per sample of
+ * the original float conversion, the fixed-point one and the linearization table one.
+ *
+ * \author André Brandão
+ * \author Emanuel Pereira
+ * \date 29/05/2022
+ */
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdio.h>
+#include <stddef.h>
+#include <time.h>
+#include "ADC_conv.h"
+
+#define NSAMPLES 100000000L /**< Samples converted per run */
+
+static volatile uint32_t sink; /**< Keeps the conversions from being optimized out */
+
+/** \brief Original float conversion (out of range samples map to 0) */
+static uint16_t adc_to_mv_float(int16_t raw)
+{
+	if(raw < 0 || raw > ADC_MAX_RAW)
+		raw = 0;
+
+	return (uint16_t)(1000*raw*((float)3/1023));
+}
+
+/** \brief Current time in nanoseconds */
+static double now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+/** \brief Converts NSAMPLES samples
+ *
+ * \param[in] mode 0 float, 1 fixed-point, 2 fixed-point with linearization table
+ * \param[in] lut linearization table (mode 2)
+ *
+ * \return time per sample in nanoseconds
+ */
+static double run(int mode, const uint16_t *lut)
+{
+	uint32_t acc = 0;
+	uint16_t mv;
+	int16_t raw;
+	double start = now_ns();
+
+	for(long i = 0; i < NSAMPLES; i++)
+	{
+		raw = (int16_t)(i & ADC_MAX_RAW);
+
+		if(mode == 0)
+		{
+			acc += adc_to_mv_float(raw);
+		}
+		else
+		{
+			acc += adc_conv_mv(raw, mode == 2 ? lut : NULL, &mv);
+			acc += mv;
+		}
+	}
+
+	sink = acc;
+	return (now_ns() - start) / NSAMPLES;
+}
+
+int main(void)
+{
+	uint16_t lut[ADC_LUT_SEGMENTS + 1];
+	uint16_t mv;
+	int32_t exact, clamped;
+	int sat, fails = 0, float_diff = 0, lut_err = 0;
+
+	adc_conv_lut_ideal(lut);
+
+	/* Every sample, with a margin of out of range ones on both sides */
+	for(int32_t raw = -64; raw <= ADC_MAX_RAW + 64; raw++)
+	{
+		clamped = raw < 0 ? 0 : (raw > ADC_MAX_RAW ? ADC_MAX_RAW : raw);
+		exact = clamped * ADC_FULL_SCALE_MV / ADC_MAX_RAW;
+
+		sat = adc_conv_mv(raw, NULL, &mv);
+		if(mv != exact || sat != (raw < 0 ? ADC_SAT_LOW : (raw > ADC_MAX_RAW ? ADC_SAT_HIGH : 0)))
+		{
+			printf("raw %d: got %u mV (sat %d), expected %d mV\n", raw, mv, sat, exact);
+			fails++;
+		}
+
+		if(raw == clamped && adc_to_mv_float(raw) != exact)
+			float_diff++;
+
+		adc_conv_mv(raw, lut, &mv);
+		if(mv - exact > lut_err || exact - mv > lut_err)
+			lut_err = mv > exact ? mv - exact : exact - mv;
+	}
+
+	printf("fixed-point: %d mismatches, float: %d samples off by rounding, ideal table: max error %d mV\n",
+		fails, float_diff, lut_err);
+
+	printf("%12s %12s %12s\n", "float", "fixed", "table");
+	printf("%9.2f ns %9.2f ns %9.2f ns\n", run(0, lut), run(1, lut), run(2, lut));
+
+	return fails != 0;
+}
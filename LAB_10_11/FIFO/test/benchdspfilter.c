@@ -0,0 +1,96 @@
+/** \file benchdspfilter.c
+ * 	\brief Host benchmark of the DSP filter library
+ *
+ *  Filters a block of samples many times with each filter type and reports the time
+ * and the CPU cycles (time stamp counter, x86 only) per sample. On the target the same
+ * loop can be timed with the DWT cycle counter.
+ *
+ * \author André Brandão
+ * \author Emanuel Pereira
+ * \date 29/05/2022
+ */
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "dsp_filter.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define CYCLES() __rdtsc()  /**< Cycle counter */
+#else
+#define CYCLES() 0ULL
+#endif
+
+#define BLOCK 256       /**< Samples per block */
+#define NBLOCKS 20000   /**< Blocks per filter */
+
+static q15_t in[BLOCK];     /**< Input block */
+static q15_t out[BLOCK];    /**< Output block */
+
+/** \brief Current time in nanoseconds */
+static double now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+/** \brief Filters NBLOCKS blocks and prints the time per sample */
+static void run(struct dsp_filter *f, const char *name)
+{
+    unsigned long long c0;
+    double t0, ns, cycles;
+    long check = 0;
+
+    t0 = now_ns();
+    c0 = CYCLES();
+
+    for(int i = 0; i < NBLOCKS; i++)
+    {
+        dsp_filter_block(f, in, out, BLOCK);
+        check += out[BLOCK - 1];
+    }
+
+    cycles = (double)(CYCLES() - c0) / ((double)NBLOCKS * BLOCK);
+    ns = (now_ns() - t0) / ((double)NBLOCKS * BLOCK);
+
+    printf("%-16s %8.2f ns %8.1f cycles  (check %ld)\n", name, ns, cycles, check);
+}
+
+int main(void)
+{
+    static q15_t median_buf[DSP_MEDIAN_BUF_SIZE(31)];
+    static q15_t taps[64], fir_state[DSP_FIR_STATE_SIZE(64)];
+    static const q15_t b15[DSP_BIQUAD_Q15_COEFFS_SIZE(2)] = {312, 0, 624, 312, 24243, -9107, 359, 0, 717, 359, 27869, -12919};
+    static const q31_t b31[DSP_BIQUAD_Q31_COEFFS_SIZE(2)] = {1001305, 2002611, 1001305, 2025731614, -955995012,
+                                                             1034533, 2069067, 1034533, 2092954698, -1023351008};
+    static q15_t b15_state[DSP_BIQUAD_STATE_SIZE(2)];
+    static q31_t b31_state[DSP_BIQUAD_STATE_SIZE(2)];
+    struct dsp_filter f;
+
+    srand(1);
+    for(int i = 0; i < BLOCK; i++)
+        in[i] = 1500 + rand() % 200;
+    for(int i = 0; i < 64; i++)
+        taps[i] = 32767 / 64;
+
+    dsp_median_init(&f, median_buf, 7);
+    run(&f, "median 7");
+    dsp_median_init(&f, median_buf, 31);
+    run(&f, "median 31");
+    dsp_ema_init(&f, 4096);
+    run(&f, "ema");
+    dsp_fir_init(&f, taps, 16, fir_state);
+    run(&f, "fir 16 taps");
+    dsp_fir_init(&f, taps, 64, fir_state);
+    run(&f, "fir 64 taps");
+    dsp_biquad_q15_init(&f, b15, 2, 1, b15_state);
+    run(&f, "biquad q15 x2");
+    dsp_biquad_q31_init(&f, b31, 2, 1, b31_state);
+    run(&f, "biquad q31 x2");
+
+    return 0;
+}
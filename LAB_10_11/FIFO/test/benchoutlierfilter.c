@@ -0,0 +1,90 @@
+/** \file benchoutlierfilter.c
+ * 	\brief Host benchmark of the incremental outlier filter
+ *
+ *  Time per sample (insert + output) of the incremental filter against the reference
+ * full scan, for windows from 10 to 10000 samples.
+ *
+ * \author André Brandão
+ * \author Emanuel Pereira
+ * \date 29/05/2022
+ */
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "outlier_filter.h"
+
+#define MAX_N 10000         /**< Biggest window */
+#define OPS_BUDGET 50000000L /**< Scanned samples per window size (limits the full scan run time) */
+#define MIN_OPS 20000       /**< Minimum number of samples per run */
+
+OFILTER_DEFINE(of, MAX_N);
+
+/** \brief Current time in nanoseconds */
+static double now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+/** \brief Filters ops samples of noise around 2000 mV
+ *
+ * \param[in] N window size
+ * \param[in] ops number of samples
+ * \param[in] scan 1 to use the full scan, 0 the incremental filter
+ * \param[out] check accumulated outputs (to compare both implementations)
+ *
+ * \return time per sample in nanoseconds
+ */
+static double run(int N, long ops, int scan, long long *check)
+{
+    long long acc = 0;
+    double start;
+
+    of.size = N;
+    ofilter_init(&of);
+    srand(1);
+
+    start = now_ns();
+    for(long i = 0; i < ops; i++)
+    {
+        ofilter_insert(&of, 1800 + rand() % 401);
+        acc += scan ? ofilter_scan(&of) : ofilter_output(&of);
+    }
+
+    *check = acc;
+    return (now_ns() - start) / ops;
+}
+
+int main(void)
+{
+    int sizes[] = {10, 100, 1000, MAX_N};
+    long long check_scan, check_inc;
+    double t_scan, t_inc;
+    long ops;
+
+    printf("%8s %10s %14s %14s %10s\n", "N", "samples", "scan (ns)", "incr (ns)", "speedup");
+
+    for(unsigned int i = 0; i < sizeof(sizes)/sizeof(sizes[0]); i++)
+    {
+        ops = OPS_BUDGET / sizes[i];
+        if(ops < MIN_OPS)
+            ops = MIN_OPS;
+
+        t_scan = run(sizes[i], ops, 1, &check_scan);
+        t_inc = run(sizes[i], ops, 0, &check_inc);
+
+        if(check_scan != check_inc)
+        {
+            printf("Mismatch between implementations for N = %d\n", sizes[i]);
+            return 1;
+        }
+
+        printf("%8d %10ld %14.1f %14.1f %9.1fx\n", sizes[i], ops, t_scan, t_inc, t_scan / t_inc);
+    }
+
+    return 0;
+}
@@ -0,0 +1,171 @@
+/* Generated by gen_dsp_golden.py, do not edit */
+#define GOLDEN_N 256
+#define GOLDEN_MEDIAN_SIZE 7
+#define GOLDEN_EMA_ALPHA 4096
+#define GOLDEN_FIR_TAPS 16
+#define GOLDEN_BIQUAD_STAGES 2
+#define GOLDEN_BIQUAD_POST_SHIFT 1
+
+static const q15_t golden_in[256] = {
+	467, 522, 547, 458, 482, 465, 513, 547, 507, 510, 533, 498,
+	550, 476, 462, 512, 453, 499, 505, 527, 547, 548, 450, 539,
+	507, 484, 542, 479, 525, 463, 1490, 453, 452, 453, 533, 519,
+	451, 498, 537, 477, 504, 542, 453, 517, 478, 547, 506, 513,
+	520, 479, 494, 479, 536, 478, 547, 508, 487, 452, 503, 521,
+	532, 462, 473, 530, 2042, 1987, 1965, 2045, 1992, 2042, 2041, 2014,
+	2004, 2014, 2035, 1974, 1988, 1986, 2025, 2013, 2014, 2000, 2025, 1954,
+	2011, 1981, 2045, 2001, 2003, 2035, 1972, 1996, 2020, 2039, 2049, 2036,
+	2044, 1997, 1961, 2006, 3034, 3015, 1963, 2049, 1970, 2016, 2000, 1997,
+	2012, 2043, 1953, 2010, 1955, 1989, 2040, 2028, 2025, 2024, 2000, 2032,
+	1971, 1971, 2014, 1979, 1951, 2048, 1975, 2019, 2020, 1979, 2001, 2015,
+	1994, 2023, 1995, 2008, 1984, 2034, 2020, 2027, 2043, 1950, 1999, 2050,
+	2044, 2015, 1966, 2016, 2049, 2021, 1976, 2004, 1957, 2011, 1996, 2022,
+	2020, 1975, 2014, 2002, 1212, 1195, 1203, 1194, 1150, 1218, 1219, 1229,
+	1250, 1228, 1192, 1208, 1226, 1153, 1179, 1231, 1172, 1220, 1224, 1173,
+	1161, 1220, 1182, 1154, 1236, 1159, 1160, 1152, 1207, 1151, 1246, 1246,
+	1185, 1181, 1184, 1164, 1229, 1173, 1194, 1187, 2158, 1171, 1170, 1182,
+	1217, 1171, 1234, 1184, 1232, 1241, 1187, 1208, 1239, 1191, 1213, 1210,
+	1164, 1153, 1189, 1199, 1193, 1203, 1174, 1183, 1163, 1182, 1243, 1215,
+	1176, 1227, 1205, 1152, 1178, 1152, 1200, 1168, 1154, 1242, 1170, 1207,
+	1240, 1214, 1236, 1204, 1219, 1178, 1230, 1238, 1216, 1207, 1178, 1217,
+	1233, 1153, 1200, 1236
+};
+
+static const q15_t golden_median[256] = {
+	0, 0, 0, 458, 467, 467, 482, 513, 507, 507, 510, 510,
+	513, 510, 507, 510, 498, 498, 499, 499, 505, 512, 505, 527,
+	527, 527, 539, 507, 507, 507, 507, 484, 479, 463, 463, 463,
+	453, 453, 498, 498, 504, 504, 498, 504, 504, 504, 506, 513,
+	513, 513, 506, 506, 506, 494, 494, 494, 494, 487, 503, 503,
+	508, 503, 487, 503, 521, 530, 532, 1965, 1987, 1992, 2041, 2014,
+	2014, 2014, 2014, 2014, 2014, 2004, 2004, 2013, 2013, 2000, 2013, 2013,
+	2013, 2011, 2011, 2001, 2003, 2003, 2003, 2001, 2003, 2003, 2020, 2035,
+	2036, 2036, 2036, 2036, 2036, 2036, 2006, 2006, 2006, 2016, 2016, 2000,
+	2000, 2012, 2000, 2010, 2000, 1997, 2010, 2010, 2010, 2024, 2024, 2025,
+	2025, 2024, 2014, 2000, 1979, 1979, 1975, 1979, 2014, 1979, 2001, 2015,
+	2001, 2015, 2001, 2001, 2001, 2008, 2008, 2020, 2020, 2020, 2020, 2027,
+	2027, 2027, 2015, 2015, 2016, 2021, 2016, 2015, 2004, 2011, 2004, 2004,
+	2004, 2004, 2011, 2011, 2002, 2002, 1975, 1212, 1203, 1203, 1203, 1203,
+	1218, 1219, 1219, 1219, 1226, 1226, 1208, 1208, 1192, 1208, 1220, 1179,
+	1179, 1220, 1182, 1182, 1182, 1173, 1161, 1160, 1160, 1159, 1160, 1160,
+	1185, 1185, 1185, 1184, 1185, 1184, 1184, 1184, 1187, 1187, 1187, 1182,
+	1187, 1182, 1182, 1182, 1184, 1217, 1217, 1208, 1232, 1208, 1213, 1210,
+	1208, 1208, 1191, 1191, 1193, 1193, 1189, 1189, 1189, 1183, 1183, 1183,
+	1182, 1183, 1205, 1205, 1205, 1178, 1178, 1178, 1168, 1168, 1170, 1170,
+	1200, 1207, 1214, 1214, 1214, 1214, 1219, 1219, 1219, 1216, 1216, 1216,
+	1217, 1216, 1207, 1207
+};
+
+static const q15_t golden_ema[256] = {
+	58, 116, 170, 206, 241, 269, 299, 330, 352, 372, 392, 405,
+	423, 430, 434, 444, 445, 452, 458, 467, 477, 486, 481, 489,
+	491, 490, 496, 494, 498, 494, 618, 598, 579, 564, 560, 555,
+	542, 536, 536, 529, 526, 528, 518, 518, 513, 517, 516, 516,
+	516, 512, 509, 506, 509, 505, 511, 510, 507, 500, 501, 503,
+	507, 501, 498, 502, 694, 856, 995, 1126, 1234, 1335, 1423, 1497,
+	1561, 1617, 1669, 1708, 1743, 1773, 1804, 1831, 1853, 1872, 1891, 1899,
+	1913, 1921, 1937, 1945, 1952, 1962, 1964, 1968, 1974, 1982, 1991, 1996,
+	2002, 2002, 1997, 1998, 2127, 2238, 2204, 2184, 2158, 2140, 2122, 2107,
+	2095, 2088, 2072, 2064, 2050, 2043, 2042, 2040, 2039, 2037, 2032, 2032,
+	2024, 2018, 2017, 2013, 2005, 2010, 2006, 2007, 2009, 2005, 2005, 2006,
+	2005, 2007, 2005, 2006, 2003, 2007, 2008, 2011, 2015, 2007, 2006, 2011,
+	2015, 2015, 2009, 2010, 2015, 2016, 2011, 2010, 2003, 2004, 2003, 2006,
+	2007, 2003, 2005, 2004, 1905, 1816, 1740, 1672, 1606, 1558, 1515, 1480,
+	1451, 1423, 1394, 1371, 1353, 1328, 1309, 1299, 1284, 1276, 1269, 1257,
+	1245, 1242, 1234, 1224, 1226, 1218, 1210, 1203, 1204, 1197, 1203, 1208,
+	1206, 1202, 1200, 1196, 1200, 1196, 1196, 1195, 1315, 1297, 1281, 1269,
+	1262, 1251, 1249, 1241, 1240, 1240, 1233, 1230, 1231, 1226, 1225, 1223,
+	1215, 1208, 1205, 1204, 1203, 1203, 1199, 1197, 1193, 1192, 1198, 1200,
+	1197, 1201, 1201, 1195, 1193, 1188, 1189, 1187, 1183, 1190, 1188, 1190,
+	1196, 1198, 1203, 1203, 1205, 1202, 1205, 1209, 1210, 1210, 1206, 1207,
+	1210, 1203, 1203, 1207
+};
+
+static const q15_t golden_fir_taps[16] = {
+	112, 243, 618, 1293, 2217, 3225, 4089, 4587, 4587, 4089, 3225, 2217,
+	1293, 618, 243, 112
+};
+
+static const q15_t golden_fir[256] = {
+	1, 5, 14, 33, 67, 116, 179, 248, 318, 380, 429, 463,
+	485, 497, 504, 509, 511, 511, 509, 506, 502, 498, 496, 496,
+	499, 503, 507, 511, 513, 513, 515, 517, 525, 542, 567, 592,
+	613, 624, 621, 605, 579, 552, 527, 511, 503, 501, 500, 501,
+	502, 502, 504, 505, 506, 506, 506, 505, 504, 502, 502, 502,
+	502, 502, 501, 500, 504, 514, 542, 603, 705, 854, 1043, 1254,
+	1466, 1655, 1806, 1909, 1971, 2000, 2011, 2015, 2012, 2009, 2006, 2004,
+	2003, 2003, 2004, 2004, 2003, 2003, 2002, 2002, 2003, 2004, 2005, 2007,
+	2008, 2010, 2013, 2016, 2023, 2032, 2047, 2078, 2123, 2178, 2232, 2271,
+	2285, 2269, 2227, 2170, 2111, 2061, 2029, 2012, 2004, 1999, 1999, 2000,
+	2002, 2006, 2009, 2011, 2011, 2009, 2005, 2001, 1997, 1994, 1993, 1993,
+	1995, 1997, 1999, 2001, 2002, 2003, 2003, 2004, 2005, 2006, 2007, 2009,
+	2011, 2012, 2013, 2013, 2014, 2014, 2014, 2014, 2014, 2013, 2012, 2010,
+	2007, 2004, 2001, 2000, 1996, 1991, 1977, 1947, 1893, 1815, 1714, 1601,
+	1487, 1387, 1309, 1256, 1228, 1217, 1215, 1214, 1214, 1212, 1209, 1204,
+	1201, 1198, 1197, 1197, 1196, 1195, 1194, 1192, 1189, 1187, 1184, 1182,
+	1181, 1181, 1182, 1185, 1189, 1193, 1196, 1197, 1199, 1201, 1210, 1228,
+	1254, 1283, 1307, 1321, 1321, 1307, 1284, 1257, 1234, 1219, 1212, 1212,
+	1211, 1212, 1211, 1209, 1205, 1201, 1196, 1192, 1189, 1187, 1186, 1186,
+	1186, 1187, 1188, 1190, 1193, 1195, 1197, 1197, 1195, 1192, 1187, 1183,
+	1181, 1180, 1182, 1186, 1191, 1197, 1203, 1208, 1211, 1214, 1214, 1215,
+	1214, 1213, 1213, 1211
+};
+
+static const q15_t golden_biquad_q15_coeffs[12] = {
+	312, 0, 624, 312, 24243, -9107, 359, 0, 717, 359, 27869, -12919
+};
+
+static const q15_t golden_biquad_q15[256] = {
+	0, 2, 7, 19, 40, 72, 115, 166, 222, 281, 340, 395,
+	445, 486, 519, 543, 558, 564, 563, 557, 546, 534, 521, 510,
+	501, 495, 492, 490, 491, 493, 497, 503, 513, 528, 548, 568,
+	586, 600, 608, 610, 606, 596, 582, 566, 549, 532, 517, 504,
+	494, 488, 485, 484, 485, 488, 492, 495, 499, 503, 506, 508,
+	509, 509, 508, 507, 506, 509, 523, 558, 622, 718, 846, 1000,
+	1173, 1355, 1534, 1701, 1849, 1972, 2066, 2131, 2169, 2183, 2178, 2158,
+	2129, 2095, 2060, 2028, 2001, 1979, 1965, 1958, 1956, 1959, 1966, 1975,
+	1986, 1997, 2008, 2018, 2026, 2035, 2048, 2069, 2100, 2138, 2176, 2209,
+	2233, 2245, 2244, 2231, 2208, 2177, 2141, 2103, 2066, 2033, 2006, 1985,
+	1972, 1965, 1964, 1967, 1973, 1980, 1988, 1994, 2000, 2005, 2008, 2009,
+	2010, 2010, 2009, 2008, 2007, 2005, 2004, 2004, 2004, 2004, 2005, 2007,
+	2008, 2010, 2012, 2013, 2015, 2016, 2017, 2017, 2018, 2017, 2016, 2015,
+	2013, 2010, 2008, 2005, 2003, 1999, 1990, 1970, 1936, 1885, 1816, 1734,
+	1643, 1547, 1454, 1367, 1292, 1230, 1183, 1150, 1131, 1124, 1125, 1134,
+	1147, 1162, 1177, 1191, 1202, 1211, 1216, 1217, 1216, 1212, 1207, 1200,
+	1194, 1188, 1184, 1182, 1181, 1182, 1183, 1185, 1188, 1192, 1201, 1216,
+	1235, 1256, 1275, 1291, 1302, 1306, 1305, 1298, 1287, 1274, 1259, 1244,
+	1230, 1218, 1208, 1200, 1193, 1189, 1185, 1184, 1183, 1183, 1184, 1185,
+	1186, 1187, 1189, 1191, 1193, 1195, 1197, 1198, 1197, 1196, 1194, 1191,
+	1189, 1187, 1186, 1186, 1187, 1190, 1194, 1198, 1202, 1207, 1211, 1214,
+	1217, 1218, 1219, 1219
+};
+
+static const q31_t golden_biquad_q31_coeffs[10] = {
+	1001305, 2002611, 1001305, 2025731614, -955995012, 1034533, 2069067, 1034533, 2092954698, -1023351008
+};
+
+static const q15_t golden_biquad_q31[256] = {
+	0, 0, 0, 0, 0, 0, 0, 1, 1, 2, 3, 4,
+	5, 7, 9, 11, 14, 17, 20, 24, 28, 33, 38, 44,
+	50, 56, 63, 70, 78, 86, 95, 104, 114, 123, 134, 144,
+	155, 166, 177, 189, 201, 213, 226, 238, 251, 263, 276, 289,
+	301, 314, 327, 339, 352, 364, 376, 388, 399, 411, 422, 432,
+	443, 453, 463, 472, 481, 490, 498, 506, 513, 521, 528, 535,
+	542, 549, 557, 564, 572, 581, 590, 599, 610, 621, 633, 646,
+	659, 674, 690, 707, 725, 743, 763, 785, 807, 830, 854, 879,
+	905, 932, 960, 989, 1018, 1049, 1079, 1111, 1143, 1175, 1208, 1242,
+	1275, 1309, 1343, 1378, 1412, 1446, 1480, 1514, 1548, 1581, 1614, 1647,
+	1679, 1710, 1741, 1771, 1800, 1828, 1856, 1882, 1908, 1932, 1956, 1978,
+	2000, 2020, 2039, 2058, 2074, 2090, 2105, 2119, 2131, 2142, 2153, 2162,
+	2170, 2177, 2183, 2188, 2193, 2196, 2198, 2200, 2200, 2200, 2200, 2198,
+	2196, 2193, 2190, 2186, 2182, 2177, 2172, 2166, 2160, 2154, 2147, 2139,
+	2132, 2124, 2115, 2106, 2097, 2087, 2076, 2065, 2054, 2042, 2029, 2016,
+	2003, 1989, 1974, 1959, 1943, 1927, 1911, 1894, 1876, 1858, 1840, 1821,
+	1802, 1783, 1764, 1744, 1724, 1704, 1684, 1664, 1643, 1623, 1603, 1582,
+	1562, 1543, 1523, 1504, 1485, 1466, 1447, 1430, 1412, 1395, 1378, 1362,
+	1347, 1332, 1317, 1303, 1290, 1277, 1265, 1254, 1243, 1233, 1223, 1214,
+	1205, 1197, 1190, 1183, 1176, 1171, 1165, 1161, 1156, 1153, 1149, 1146,
+	1144, 1142, 1140, 1139, 1138, 1138, 1137, 1137, 1138, 1138, 1139, 1140,
+	1142, 1143, 1145, 1147
+};
+
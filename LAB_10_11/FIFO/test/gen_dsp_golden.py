@@ -0,0 +1,117 @@
+#!/usr/bin/env python3
+"""Generates dsp_golden.h, the golden vectors of testdspfilter.c
+
+The input is a light sensor like signal (steps, noise and outliers) in millivolts.
+The expected outputs are computed in double precision from the quantized
+coefficients, so the tolerances of the test only cover the fixed-point rounding.
+
+    python3 gen_dsp_golden.py > dsp_golden.h
+"""
+
+import math
+import random
+
+N = 256
+
+def signal():
+    rnd = random.Random(1)
+    x = []
+    for n in range(N):
+        level = 500 if n < 64 else (2000 if n < 160 else 1200)
+        v = level + rnd.randint(-50, 50)
+        if n in (30, 100, 101, 200):
+            v += 1000    # Outliers
+        x.append(v)
+    return x
+
+def median(x, size):
+    win = [0] * size
+    out = []
+    for n, v in enumerate(x):
+        win[n % size] = v
+        out.append(sorted(win)[size // 2])
+    return out
+
+def ema(x, alpha):
+    a = alpha / 32768
+    y = 0.0
+    out = []
+    for v in x:
+        y += a * (v - y)
+        out.append(int(math.floor(y + 0.5)))
+    return out
+
+def fir_taps(ntaps, fc):
+    h = []
+    for k in range(ntaps):
+        m = k - (ntaps - 1) / 2
+        sinc = 2 * fc if m == 0 else math.sin(2 * math.pi * fc * m) / (math.pi * m)
+        h.append(sinc * (0.54 - 0.46 * math.cos(2 * math.pi * k / (ntaps - 1))))
+    s = sum(h)
+    return [int(round(v / s * 32767)) for v in h]
+
+def fir(x, taps):
+    hist = [0] * len(taps)
+    out = []
+    for v in x:
+        hist = [v] + hist[:-1]
+        out.append(math.floor(sum(t * h for t, h in zip(taps, hist)) / 32768))
+    return out
+
+def butter2_sections(fc, nstages):
+    """Cascade of 2nd order Butterworth low-pass sections (bilinear transform)"""
+    secs = []
+    wc = math.tan(math.pi * fc)
+    for k in range(nstages):
+        q = 1 / (2 * math.cos(math.pi * (2 * k + 1) / (4 * nstages)))
+        norm = 1 + wc / q + wc * wc
+        b0 = wc * wc / norm
+        secs.append((b0, 2 * b0, b0, -2 * (wc * wc - 1) / norm, -(1 - wc / q + wc * wc) / norm))
+    return secs
+
+def quantize(secs, bits, post_shift):
+    scale = (1 << bits) >> post_shift
+    return [[int(round(c * scale)) for c in s] for s in secs]
+
+def biquad(x, qsecs, bits, post_shift):
+    scale = (1 << bits) >> post_shift
+    out = []
+    st = [[0.0] * 4 for _ in qsecs]
+    for v in x:
+        for s, c in zip(st, qsecs):
+            b0, b1, b2, a1, a2 = (ci / scale for ci in c)
+            y = b0 * v + b1 * s[0] + b2 * s[1] + a1 * s[2] + a2 * s[3]
+            s[1], s[0], s[3], s[2] = s[0], v, s[2], y
+            v = y
+        out.append(int(math.floor(v + 0.5)))
+    return out
+
+def array(ctype, name, vals):
+    body = ",".join(("\n\t" if i % 12 == 0 else " ") + str(v) for i, v in enumerate(vals))
+    return "static const %s %s[%d] = {%s\n};\n" % (ctype, name, len(vals), body)
+
+def main():
+    x = signal()
+    taps = fir_taps(16, 0.05)
+    b15 = quantize(butter2_sections(0.05, 2), 15, 1)
+    b31 = quantize(butter2_sections(0.01, 2), 31, 1)
+
+    print("/* Generated by gen_dsp_golden.py, do not edit */")
+    print("#define GOLDEN_N %d" % N)
+    print("#define GOLDEN_MEDIAN_SIZE 7")
+    print("#define GOLDEN_EMA_ALPHA 4096")
+    print("#define GOLDEN_FIR_TAPS %d" % len(taps))
+    print("#define GOLDEN_BIQUAD_STAGES 2")
+    print("#define GOLDEN_BIQUAD_POST_SHIFT 1\n")
+    print(array("q15_t", "golden_in", x))
+    print(array("q15_t", "golden_median", median(x, 7)))
+    print(array("q15_t", "golden_ema", ema(x, 4096)))
+    print(array("q15_t", "golden_fir_taps", taps))
+    print(array("q15_t", "golden_fir", fir(x, taps)))
+    print(array("q15_t", "golden_biquad_q15_coeffs", [v for s in b15 for v in (s[0], 0) + tuple(s[1:])]))
+    print(array("q15_t", "golden_biquad_q15", biquad(x, b15, 15, 1)))
+    print(array("q31_t", "golden_biquad_q31_coeffs", [v for s in b31 for v in s]))
+    print(array("q15_t", "golden_biquad_q31", biquad(x, b31, 31, 1)))
+
+if __name__ == "__main__":
+    main()
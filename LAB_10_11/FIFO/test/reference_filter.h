@@ -0,0 +1,26 @@
+/** \file reference_filter.h
+ * 	\brief Host build of the reference filter of the application
+ *
+ *  reference_filter.c is generated by the makefile: this header and filter(), array_init()
+ * and array_average() copied from ../src/main.c, so the test checks the filter of the
+ * application itself. The window size is ref_size instead of SIZE and printk prints nothing.
+ *
+ * \author André Brandão
+ * \author Emanuel Pereira
+ * \date 29/05/2022
+ */
+#ifndef _REFERENCE_FILTER_H
+#define _REFERENCE_FILTER_H
+
+#include <stdint.h>
+
+#define SIZE ref_size           /**< Window size of filter() */
+#define printk(...) ((void)0)   /**< No output on the host */
+
+extern int ref_size;
+
+int filter(uint16_t *data);
+void array_init(uint16_t *data, int size);
+int array_average(uint16_t *data, int size);
+
+#endif // _REFERENCE_FILTER_H
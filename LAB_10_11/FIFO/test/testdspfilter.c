@@ -0,0 +1,171 @@
+/** \file testdspfilter.c
+ * 	\brief Golden vector test of the DSP filter library
+ *
+ *  Filters the golden input (dsp_golden.h, generated by gen_dsp_golden.py) with every
+ * filter type, sample by sample and by blocks, and checks the outputs against the
+ * double precision results. The tolerances cover the fixed-point rounding: the median
+ * is exact, the biquad Q15 tolerance is the rounding of each stage (samples have no
+ * fractional bits) amplified by the DC gain of the feedback (about 13 at fc = 0.05 fs).
+ * Reset, runtime change of filter type and invalid parameters are also checked.
+ *
+ * \author André Brandão
+ * \author Emanuel Pereira
+ * \date 29/05/2022
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include "dsp_filter.h"
+#include "dsp_golden.h"
+
+#define BLOCK 37    /**< Block size of the block run (not a divisor of GOLDEN_N) */
+
+static q15_t median_buf[DSP_MEDIAN_BUF_SIZE(GOLDEN_MEDIAN_SIZE)];  /**< Median window */
+static q15_t fir_state[DSP_FIR_STATE_SIZE(GOLDEN_FIR_TAPS)];         /**< FIR state */
+static q15_t biquad_q15_state[DSP_BIQUAD_STATE_SIZE(GOLDEN_BIQUAD_STAGES)]; /**< Q15 biquad state */
+static q31_t biquad_q31_state[DSP_BIQUAD_STATE_SIZE(GOLDEN_BIQUAD_STAGES)]; /**< Q31 biquad state */
+
+static int fails = 0;   /**< Number of failed checks */
+
+/** \brief Initializes filter f with type */
+static void init(struct dsp_filter *f, enum dsp_filter_type type)
+{
+    switch(type)
+    {
+        case DSP_MEDIAN:
+            dsp_median_init(f, median_buf, GOLDEN_MEDIAN_SIZE);
+            break;
+        case DSP_EMA:
+            dsp_ema_init(f, GOLDEN_EMA_ALPHA);
+            break;
+        case DSP_FIR:
+            dsp_fir_init(f, golden_fir_taps, GOLDEN_FIR_TAPS, fir_state);
+            break;
+        case DSP_BIQUAD_Q15:
+            dsp_biquad_q15_init(f, golden_biquad_q15_coeffs, GOLDEN_BIQUAD_STAGES, GOLDEN_BIQUAD_POST_SHIFT, biquad_q15_state);
+            break;
+        default:
+            dsp_biquad_q31_init(f, golden_biquad_q31_coeffs, GOLDEN_BIQUAD_STAGES, GOLDEN_BIQUAD_POST_SHIFT, biquad_q31_state);
+            break;
+    }
+}
+
+/** \brief Checks filter type against its golden output
+ *
+ * \param[in] type filter type
+ * \param[in] golden expected output
+ * \param[in] tol tolerance (LSB)
+ * \param[in] name filter name
+ */
+static void check(enum dsp_filter_type type, const q15_t *golden, int tol, const char *name)
+{
+    struct dsp_filter f;
+    q15_t out[GOLDEN_N];
+    int err, max_err = 0, bad = 0;
+
+    init(&f, type);
+    if(dsp_filter_type_get(&f) != type)
+    {
+        printf("%s: wrong type\n", name);
+        fails++;
+    }
+
+    /* Three runs: sample by sample, by blocks after a reset and by blocks in place */
+    for(int run = 0; run < 3; run++)
+    {
+        if(run == 0)
+        {
+            for(int i = 0; i < GOLDEN_N; i++)
+                out[i] = dsp_filter_step(&f, golden_in[i]);
+        }
+        else
+        {
+            dsp_filter_reset(&f);
+            for(int i = 0; i < GOLDEN_N; i += BLOCK)
+            {
+                int n = (GOLDEN_N - i < BLOCK) ? GOLDEN_N - i : BLOCK;
+
+                if(run == 1)
+                {
+                    dsp_filter_block(&f, &golden_in[i], &out[i], n);
+                }
+                else
+                {
+                    for(int j = 0; j < n; j++)
+                        out[i + j] = golden_in[i + j];
+                    dsp_filter_block(&f, &out[i], &out[i], n);
+                }
+            }
+        }
+
+        for(int i = 0; i < GOLDEN_N; i++)
+        {
+            err = abs(out[i] - golden[i]);
+            if(err > max_err)
+                max_err = err;
+            if(err > tol && bad++ < 5)
+                printf("%s run %d: sample %d got %d, expected %d\n", name, run, i, out[i], golden[i]);
+        }
+    }
+
+    printf("%-12s max error %d LSB (tolerance %d)\n", name, max_err, tol);
+    if(bad)
+        fails++;
+}
+
+int main(void)
+{
+    struct dsp_filter f;
+    q15_t state[4];
+    q31_t state31[4];
+
+    check(DSP_MEDIAN, golden_median, 0, "median");
+    check(DSP_EMA, golden_ema, 1, "ema");
+    check(DSP_FIR, golden_fir, 1, "fir");
+    check(DSP_BIQUAD_Q15, golden_biquad_q15, 6, "biquad q15");
+    check(DSP_BIQUAD_Q31, golden_biquad_q31, 1, "biquad q31");
+
+    /* Runtime change of filter type: a median turned into an EMA behaves as a new EMA */
+    dsp_median_init(&f, median_buf, GOLDEN_MEDIAN_SIZE);
+    for(int i = 0; i < 10; i++)
+        dsp_filter_step(&f, golden_in[i]);
+    dsp_ema_init(&f, GOLDEN_EMA_ALPHA);
+    for(int i = 0; i < GOLDEN_N; i++)
+    {
+        if(dsp_filter_step(&f, golden_in[i]) != golden_ema[i])
+        {
+            printf("runtime change of type failed at sample %d\n", i);
+            fails++;
+            break;
+        }
+    }
+
+    /* Invalid parameters */
+    if(dsp_median_init(&f, median_buf, 0) != -1 || dsp_median_init(&f, NULL, 3) != -1 ||
+       dsp_median_init(&f, median_buf, DSP_MEDIAN_MAX + 1) != -1 ||
+       dsp_ema_init(&f, 0) != -1 || dsp_fir_init(&f, golden_fir_taps, 0, fir_state) != -1 ||
+       dsp_biquad_q15_init(&f, golden_biquad_q15_coeffs, 1, 15, state) != -1 ||
+       dsp_biquad_q15_init(&f, golden_biquad_q15_coeffs, 1, 16, state) != -1 ||
+       dsp_biquad_q31_init(&f, golden_biquad_q31_coeffs, 0, 1, state31) != -1)
+    {
+        printf("invalid parameters accepted\n");
+        fails++;
+    }
+
+    /* Saturation: a unity FIR tap fed with full scale samples */
+    {
+        static const q15_t taps[2] = {32767, 32767};
+        q15_t st[DSP_FIR_STATE_SIZE(2)];
+
+        dsp_fir_init(&f, taps, 2, st);
+        dsp_filter_step(&f, 32767);
+        if(dsp_filter_step(&f, 32767) != 32767 || dsp_filter_step(&f, -32768) != -1)
+        {
+            printf("fir saturation failed\n");
+            fails++;
+        }
+    }
+
+    printf("%s\n", fails ? "FAIL" : "OK");
+
+    return fails != 0;
+}
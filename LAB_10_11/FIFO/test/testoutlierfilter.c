@@ -0,0 +1,111 @@
+/** \file testoutlierfilter.c
+ * 	\brief Equivalence test of the incremental outlier filter
+ *
+ *  Feeds random streams to windows of several sizes and checks, after every sample,
+ * that ofilter_output() is equal to filter() of the application (reference_filter.c,
+ * extracted from ../src/main.c) on the same window. The streams include constant signals,
+ * noise around a level (few outliers), wide noise (many outliers) and values near the top
+ * of the 16-bit samples. A second filter gets the same samples in blocks of random length
+ * (ofilter_insert_block(), up to twice the window) and is checked after each block.
+ *
+ * \author André Brandão
+ * \author Emanuel Pereira
+ * \date 29/05/2022
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include "outlier_filter.h"
+#include "reference_filter.h"
+
+#define MAX_N 4096      /**< Biggest window */
+#define NSAMPLES 20000  /**< Samples per stream */
+
+OFILTER_DEFINE(of, MAX_N);
+OFILTER_DEFINE(ofb, MAX_N);    /**< Same filter, fed by blocks */
+static uint16_t block[2 * MAX_N + 1];  /**< Block of ofb */
+static uint16_t window[MAX_N];  /**< Window of filter(), oldest sample replaced */
+
+int ref_size;   /**< Window size of filter() */
+
+/** \brief Sample i of stream type
+ *
+ * \param[in] type 0 constant, 1 noise around a level, 2 wide noise, 3 near the 16-bit limit, 4 steps
+ * \param[in] i sample index
+ */
+static int stream(int type, long i)
+{
+    switch(type)
+    {
+        case 0:
+            return 1500;
+        case 1:
+            return 2000 + rand() % 401 - 200 + (rand() % 50 == 0 ? 1000 : 0);
+        case 2:
+            return rand() % 3001;
+        case 3:
+            return 65535 - rand() % 6001;
+        default:
+            return (i / 97) % 2 ? 3000 : 10 + rand() % 5;
+    }
+}
+
+int main(void)
+{
+    int sizes[] = {1, 2, 3, 10, 11, 64, 1000, MAX_N};
+    int fails = 0, checks = 0, sample, out, ref;
+    int blen, bn;
+
+    srand(1);
+
+    for(unsigned int s = 0; s < sizeof(sizes)/sizeof(sizes[0]); s++)
+    {
+        for(int type = 0; type < 5; type++)
+        {
+            of.size = sizes[s];
+            ofb.size = sizes[s];
+            if(ofilter_init(&of) != 0 || ofilter_init(&ofb) != 0)
+            {
+                printf("ofilter_init() failed for N = %d\n", sizes[s]);
+                return 1;
+            }
+            ref_size = sizes[s];
+            array_init(window, ref_size);   // Zeros, as the sample buffer
+            bn = 0;
+            blen = 1 + rand() % (2 * sizes[s] + 1);
+
+            for(long i = 0; i < NSAMPLES; i++)
+            {
+                sample = stream(type, i);
+                ofilter_insert(&of, sample);
+                window[i % ref_size] = sample;
+                checks++;
+
+                if((out = ofilter_output(&of)) != (ref = filter(window)))
+                {
+                    if(fails++ < 10)
+                        printf("N = %d, stream %d, sample %ld: output %d, reference %d\n",
+                            sizes[s], type, i, out, ref);
+                }
+
+                block[bn++] = sample;
+                if(bn == blen)
+                {
+                    ofilter_insert_block(&ofb, block, bn);
+                    checks++;
+                    if((out = ofilter_output(&ofb)) != ref)
+                    {
+                        if(fails++ < 10)
+                            printf("N = %d, stream %d, block of %d up to sample %ld: output %d, reference %d\n",
+                                sizes[s], type, bn, i, out, ref);
+                    }
+                    bn = 0;
+                    blen = 1 + rand() % (2 * sizes[s] + 1);
+                }
+            }
+        }
+    }
+
+    printf("%d checks, %d mismatches\n", checks, fails);
+
+    return fails != 0;
+}
@@ -0,0 +1,48 @@
+#!/usr/bin/env python3
+"""Builds a trace file from the console output of the FIFO application
+
+Build the application with TRACE_ENABLE 1 and save its console output (or pipe
+it from the serial port). The "TRACE " lines are Chrome trace events (JSON), they
+are joined in a trace file that opens in Perfetto (ui.perfetto.dev) or chrome://tracing.
+The 32-bit timestamps of the application (us) are unwrapped.
+
+    python3 trace_capture.py console.log > pipeline.json
+    python3 trace_capture.py < /dev/ttyACM0 > pipeline.json
+"""
+
+import json
+import sys
+
+PREFIX = "TRACE "
+THREADS = {1: "sampling -> processing", 2: "processing -> actuation"}
+
+
+def events(lines):
+    offset = 0
+    last = None
+    for line in lines:
+        pos = line.find(PREFIX)
+        if pos < 0:
+            continue
+        try:
+            ev = json.loads(line[pos + len(PREFIX):])
+        except ValueError:
+            continue    # Line mixed with other console output
+        if last is not None and ev["ts"] + offset < last - (1 << 31):
+            offset += 1 << 32
+        ev["ts"] += offset
+        last = ev["ts"]
+        yield ev
+
+
+def main():
+    src = open(sys.argv[1], errors="replace") if len(sys.argv) > 1 else sys.stdin
+    trace = [{"name": "process_name", "ph": "M", "pid": 1, "args": {"name": "FIFO pipeline"}}]
+    trace += [{"name": "thread_name", "ph": "M", "pid": 1, "tid": tid, "args": {"name": name}}
+              for tid, name in THREADS.items()]
+    trace += list(events(src))
+    json.dump({"traceEvents": trace, "displayTimeUnit": "ms"}, sys.stdout)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,91 @@
+/** \file ADC_conv.h
+ * 	\brief Integer conversion of ADC samples to millivolts
+ *
+ *  The conversion factor is computed at compile time from ADC_RESOLUTION, ADC_GAIN_INV
+ * and ADC_REF_MV as a 0.32 fixed-point multiplier, so a sample costs one multiply and
+ * one shift. Optionally a per-board linearization table (ADC_LUT_SEGMENTS + 1 points,
+ * in millivolts) replaces the ideal line with a piecewise-linear one.
+ *  Out of range samples are clamped and reported (ADC_SAT_LOW / ADC_SAT_HIGH).
+ *  This file does not depend on Zephyr so that it can be tested and benchmarked on the host.
+ *
+ * \author André Brandão
+ * \author Emanuel Pereira
+ * \date 29/05/2022
+ */
+#ifndef _ADC_CONV_H
+#define _ADC_CONV_H
+
+#include <stdint.h>
+
+#define ADC_RESOLUTION 10           /**< ADC Resolution */
+#define ADC_VDD_MV 3000             /**< Supply tension (mV), reference of the ADC_REF_VDD_x channels */
+#define ADC_GAIN_INV 4              /**< Inverse of ADC_GAIN (ADC.h), checked at build time in ADC.c */
+#define ADC_REF_MV (ADC_VDD_MV / 4) /**< Tension of ADC_REFERENCE (ADC.h) in millivolts, checked at build time in ADC.c */
+
+#define ADC_MAX_RAW ((1 << ADC_RESOLUTION) - 1)         /**< Biggest sample */
+#define ADC_FULL_SCALE_MV (ADC_REF_MV * ADC_GAIN_INV)   /**< Tension of ADC_MAX_RAW */
+
+/** Millivolts per count in 0.32 fixed point, rounded up so that the truncated product is exact */
+#define ADC_MV_SCALE ((((uint64_t)ADC_FULL_SCALE_MV << 32) + ADC_MAX_RAW - 1) / ADC_MAX_RAW)
+
+#define ADC_LUT_SEGMENTS 16 /**< Segments of the linearization table (power of 2) */
+#define ADC_LUT_SHIFT (ADC_RESOLUTION - 4) /**< log2 of the counts per segment (16 segments) */
+
+#if (1 << (ADC_RESOLUTION - ADC_LUT_SHIFT)) != ADC_LUT_SEGMENTS
+#error "ADC_LUT_SHIFT does not match ADC_LUT_SEGMENTS"
+#endif
+
+/* Conversion results */
+#define ADC_SAT_LOW  -1 /**< Sample below 0, clamped to 0 mV */
+#define ADC_SAT_HIGH  1 /**< Sample above ADC_MAX_RAW, clamped to full scale */
+
+/** \brief Function to convert a sample to millivolts
+ *
+ *  \param[in] raw ADC sample
+ *  \param[in] lut linearization table, tension (mV) of the samples 0, 2^ADC_LUT_SHIFT, ...,
+ * ADC_LUT_SEGMENTS * 2^ADC_LUT_SHIFT, or NULL for the ideal conversion
+ *  \param[out] mv tension in millivolts
+ *
+ *  \returns 0, ADC_SAT_LOW or ADC_SAT_HIGH if the sample was out of range
+ */
+static inline int adc_conv_mv(int32_t raw, const uint16_t *lut, uint16_t *mv)
+{
+	int sat = 0;
+	int32_t seg, frac;
+
+	if(raw < 0)
+	{
+		raw = 0;
+		sat = ADC_SAT_LOW;
+	}
+	else if(raw > ADC_MAX_RAW)
+	{
+		raw = ADC_MAX_RAW;
+		sat = ADC_SAT_HIGH;
+	}
+
+	if(lut == NULL)
+	{
+		*mv = (uint16_t)(((uint64_t)raw * ADC_MV_SCALE) >> 32);
+	}
+	else
+	{
+		seg = raw >> ADC_LUT_SHIFT;
+		frac = raw & ((1 << ADC_LUT_SHIFT) - 1);
+		*mv = (uint16_t)(lut[seg] + ((((int32_t)lut[seg + 1] - lut[seg]) * frac) >> ADC_LUT_SHIFT));
+	}
+
+	return sat;
+}
+
+/** \brief Function to fill a linearization table with the ideal conversion
+ *
+ *  \param[out] lut table of ADC_LUT_SEGMENTS + 1 points
+ */
+static inline void adc_conv_lut_ideal(uint16_t *lut)
+{
+	for(int i = 0; i <= ADC_LUT_SEGMENTS; i++)
+		lut[i] = (uint16_t)(((uint64_t)(i << ADC_LUT_SHIFT) * ADC_MV_SCALE) >> 32);
+}
+
+#endif // _ADC_CONV_H
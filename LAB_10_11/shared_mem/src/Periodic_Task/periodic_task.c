@@ -0,0 +1,116 @@
+/** \file periodic_task.c
+ * 	\brief Module implementing periodic tasks released by a kernel timer
+ *
+ *  The timer counts its expirations, k_timer_status_get() gives the releases that passed
+ * during the job (without waiting) and k_timer_status_sync() waits for the next one. The
+ * release index is advanced by every release, run or dropped, so the release instant of the
+ * current job is always start + release * period.
+ *
+ *  \author André Brandão
+ *  \author Emanuel Pereira
+ *  \date 29/05/2022
+ */
+
+#include <periodic_task.h>
+#include <sys/printk.h>
+
+/** \brief Function to initialize a periodic task
+ *
+ *  \param[out] t task
+ *  \param[in] period_us period (us), rounded up to the kernel ticks
+ *  \param[in] policy deadline miss policy
+ */
+void periodic_task_init(struct periodic_task *t, uint32_t period_us, enum periodic_policy policy)
+{
+    k_timer_init(&t->timer, NULL, NULL);
+    t->policy = policy;
+    t->period_ticks = k_us_to_ticks_ceil64(period_us);
+    t->start = 0;
+    t->release = 0;
+    t->pending = 0;
+    t->jobs = 0;
+    t->misses = 0;
+    t->skipped = 0;
+    t->jitter_us = 0;
+    t->jitter_max_us = 0;
+    t->jitter_sum_us = 0;
+}
+
+/** \brief Function to start the releases of a periodic task
+ *
+ *  The current instant is release 0 (the first job runs now), the next releases are
+ * one period apart.
+ *
+ *  \param[in] t task
+ */
+void periodic_task_start(struct periodic_task *t)
+{
+    t->start = k_uptime_ticks();
+    k_timer_start(&t->timer, K_TICKS(t->period_ticks), K_TICKS(t->period_ticks));
+    t->jobs = 1;
+}
+
+/** \brief Function to wait for the next job of a periodic task
+ *
+ *  Called by the task at the end of each job, returns at the release of the next job.
+ *
+ *  \param[in] t task
+ *
+ *  \returns number of releases that passed during the job (0 if the deadline was met)
+ */
+uint32_t periodic_task_wait(struct periodic_task *t)
+{
+    uint32_t late = k_timer_status_get(&t->timer);  // Releases passed during the job
+    uint32_t n;
+    int64_t jitter;
+
+    if(late > 0)
+        t->misses++;
+
+    if(t->policy == PERIODIC_SKIP)
+    {
+        t->skipped += late;
+        t->release += late;
+    }
+    else
+    {
+        t->pending += late;
+    }
+
+    if(t->pending == 0)
+    {
+        n = k_timer_status_sync(&t->timer); // Wait for the next release
+        if(n > 1 && t->policy == PERIODIC_SKIP) // Preempted past more than one release
+        {
+            t->skipped += n - 1;
+            t->release += n - 1;
+            n = 1;
+        }
+        t->pending = n;
+    }
+
+    t->pending--;
+    t->release++;
+    t->jobs++;
+
+    jitter = k_uptime_ticks() - (t->start + (int64_t)t->release * t->period_ticks);  // Delay from the release
+    jitter = jitter > 0 ? k_ticks_to_us_floor64(jitter) : 0;
+    t->jitter_us = jitter;
+    if(jitter > t->jitter_max_us)
+        t->jitter_max_us = jitter;
+    t->jitter_sum_us += jitter;
+
+    return late;
+}
+
+/** \brief Function to print the statistics of a periodic task
+ *
+ *  \param[in] t task
+ *  \param[in] name task name
+ */
+void periodic_task_stats_print(const struct periodic_task *t, const char *name)
+{
+    printk("%s: jobs = %u, deadline misses = %u, skipped releases = %u, jitter avg = %u us, max = %u us\n",
+           name, t->jobs, t->misses, t->skipped,
+           t->jobs ? (uint32_t)(t->jitter_sum_us / t->jobs) : 0, t->jitter_max_us);
+}
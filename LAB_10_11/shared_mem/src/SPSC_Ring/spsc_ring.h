@@ -0,0 +1,46 @@
+/** \file spsc_ring.h
+ * 	\brief Module implementing a lock-free single-producer single-consumer ring of samples
+ *
+ *  One thread (or ISR) puts the samples, one thread gets them, without locks or semaphores:
+ * the producer only writes the head and the consumer only writes the tail, both are read and
+ * written with atomic operations. A full ring drops the new sample (overrun), a get on an empty
+ * ring fails (underrun), both are counted.
+ *  The consumer can also take a snapshot of the last samples put on the ring (a consistent window,
+ * copied again if the producer overwrote it during the copy).
+ *  The storage is given by the user (SPSC_RING_DEFINE()), there is no dynamic memory.
+ *
+ * \author André Brandão
+ * \author Emanuel Pereira
+ * \date 29/05/2022
+ */
+#ifndef _SPSC_RING_H
+#define _SPSC_RING_H
+
+#include <stdint.h>
+
+#define SPSC_RING_SNAPSHOT_RETRIES 4 /**< Copies of a snapshot before giving up */
+
+/** Single-producer single-consumer ring */
+struct spsc_ring {
+    uint16_t *data;         /**< Samples, sample n is at data[n % size] */
+    uint32_t size;          /**< Number of samples (power of 2) */
+    uint32_t head;          /**< Samples put (written by the producer) */
+    uint32_t tail;          /**< Samples got (written by the consumer) */
+    uint32_t overruns;      /**< Samples dropped because the ring was full (written by the producer) */
+    uint32_t underruns;     /**< Gets on an empty ring (written by the consumer) */
+};
+
+/** Declares the storage of a ring of N samples, N a power of 2 (call spsc_ring_init() before use) */
+#define SPSC_RING_DEFINE(name, N) \
+    static uint16_t name##_data[N]; \
+    static struct spsc_ring name = { .data = name##_data, .size = (N) }
+
+int spsc_ring_init(struct spsc_ring *r);
+int spsc_ring_put(struct spsc_ring *r, uint16_t val);
+int spsc_ring_get(struct spsc_ring *r, uint16_t *val);
+uint32_t spsc_ring_count(const struct spsc_ring *r);
+int spsc_ring_snapshot(struct spsc_ring *r, uint16_t *window, uint32_t n);
+uint32_t spsc_ring_overruns_get(const struct spsc_ring *r);
+uint32_t spsc_ring_underruns_get(const struct spsc_ring *r);
+
+#endif // _SPSC_RING_H
@@ -6,6 +6,9 @@
  * The Digital filter consists in a moving average filter that removes the outliers (10% or high deviation from average)
  * and outputs the average of the remaining samples. This average is computed into a pulse width of a pwm signal that is 
  * applied to one of the DevKit leds. It was implemented recuuring to threads, shared-memory and semaphores.
+ *  The samples go from the sampling to the processing thread through a lock-free single-producer
+ * single-consumer ring, the processing thread is signalled after each sample (k_poll_signal) and gets
+ * every sample put since the last run, none is lost or torn (a full ring is counted as an overrun).
  *  It was implemented using the board Nordic nrf52840-dk.
  * 
  * \author André Brandão
@@ -27,9 +30,22 @@
 /* import ADC file */
 #include <ADC.h>
 
+/* import outlier filter file */
+#include <outlier_filter.h>
+
+/* import SPSC ring file */
+#include <spsc_ring.h>
+
+/* import periodic task file */
+#include <periodic_task.h>
+
 #define SAMP_PERIOD_MS  1000 /**< Sample period (ms) */
+#define SAMP_POLICY PERIODIC_SKIP   /**< Releases of the sampling thread missed by a late sample are dropped */
+#define STATS_PERIOD 10 /**< Number of samples between sampling task statistics reports */
 
 #define SIZE 10 /**< Window Size of samples (digital filter) */
+#define RING_SIZE 16 /**< Size of the sample ring (power of 2, bigger than SIZE) */
+#define FILTER_INCREMENTAL 1 /**< 1 to filter with the O(log SIZE) outlier filter, 0 with filter() */
 
 #define STACK_SIZE 1024 /**< Size of stack area used by each thread */
 
@@ -52,19 +68,15 @@ k_tid_t thread_sampling_tid;    /**< Sampling thread task ID */
 k_tid_t thread_processing_tid;  /**< Processing thread task ID */
 k_tid_t thread_actuation_tid;   /**< Actuation thread task ID */
 
-/** Circular array to store data */
-typedef struct {
-    uint16_t data[SIZE];    /**< Array to store data*/
-    int head;    /**< Index of next position to store data */   
-}buffer;
-
 // Global variables (shared memory) to communicate between tasks
-buffer sample_buffer;   /**< Buffer to store samples to communicate between tasks*/ 
+SPSC_RING_DEFINE(sample_ring, RING_SIZE);   /**< Ring to pass the samples to the processing task */
 int average;    /**< Store filter output (communicate between tasks) */
 
+struct periodic_task sampling_task; /**< Releases of the sampling thread */
+
 // Semaphores for task synch
-struct k_sem sem_adc;   /**< Semaphore to synch sample and processing tasks (signals end of sampling)*/
 struct k_sem sem_proc;  /**< Semaphore to synch processing and actuation tasks (signals end of processing)*/
+struct k_poll_signal sig_sample;    /**< Signal of a new sample on the ring, to trigger processing thread */
 
 void thread_sampling(void *argA, void *argB, void *argC);
 void thread_processing(void *argA, void *argB, void *argC);
@@ -82,8 +94,10 @@ int array_average(uint16_t*, int);
 void main(void) {
     
     /* Create and init semaphores */
-    k_sem_init(&sem_adc, 0, 1);
     k_sem_init(&sem_proc, 0, 1);
+    k_poll_signal_init(&sig_sample);
+
+    spsc_ring_init(&sample_ring);   // Empty sample ring
     
     /* Create tasks */
     thread_sampling_tid = k_thread_create(&thread_sampling_data, thread_sampling_stack,
@@ -104,43 +118,39 @@ void main(void) {
 /** \brief Sampling thread
  *  
  *  This thread implements the sampling task.
- * It's a periodic thread that reads the adc with period SAMP_PERIOD_MS and stores it in the sample buffer.
- * After sampling triggers the processing task.
+ * It's a periodic thread (sampling_task) that reads the adc with period SAMP_PERIOD_MS and puts it on the sample ring.
+ * After sampling signals the processing task (sig_sample).
  * 
  * \pre adc_sample()
  * 
  * \see SAMP_PERIOD_MS
+ * \see SAMP_POLICY
  */
 void thread_sampling(void *argA , void *argB, void *argC)
 {
-    /* Timing variables to control task periodicity */
-    int64_t fin_time=0, release_time=0;
+    uint16_t sample;
     
-    array_init(sample_buffer.data, SIZE);   // Initialize array with zeros
     adc_config();   // Configure adc
     
-    /* Compute next release instant */
-    release_time = k_uptime_get() + SAMP_PERIOD_MS;
+    periodic_task_init(&sampling_task, SAMP_PERIOD_MS * 1000, SAMP_POLICY);
+    periodic_task_start(&sampling_task);    // First release now
 
     /* Thread loop */
     while(1)
     {
-        sample_buffer.data[sample_buffer.head] = adc_sample();  // Get adc sample and store it in sample buffer
+        sample = adc_sample();  // Get adc sample
         
         printk("\n----------------------------\n");
-        printk("\nsample = %d\n", sample_buffer.data[sample_buffer.head]);
+        printk("\nsample = %d\n", sample);
 
-        sample_buffer.head = (sample_buffer.head + 1) % SIZE;   // Increment position to store data
+        spsc_ring_put(&sample_ring, sample);    // Store sample, dropped and counted if the ring is full
         
-       k_sem_give(&sem_adc);    // Signal new sample
+        k_poll_signal_raise(&sig_sample, 0);    // Signal new sample, kept until the processing resets it
+
+        if(sampling_task.jobs % STATS_PERIOD == 0)
+            periodic_task_stats_print(&sampling_task, "sampling");
         
-        /* Wait for next release instant */ 
-        fin_time = k_uptime_get();
-        if( fin_time < release_time)
-        {
-            k_msleep(release_time - fin_time);
-            release_time += SAMP_PERIOD_MS;
-        }
+        periodic_task_wait(&sampling_task);    // Wait for next release instant
     }
 
 }
@@ -149,21 +159,60 @@ void thread_sampling(void *argA , void *argB, void *argC)
  *  
  *  This thread implements the task of processing.
  * It filters the data samples and updates the average of the filtered data samples.
- * It's a sporadic thread triggered by the end of sampling (sampling thread). After processing
- * triggers the actuation task.
+ * It's a sporadic thread woken by the end of sampling (sampling thread), it gets every sample put
+ * on the ring since its last run. The signal is reset before the ring is read, so a sample put
+ * meanwhile is either read now or raises the signal again (no lost wakeup). If no sample arrives within two sample periods the empty get is
+ * counted as an underrun. After processing triggers the actuation task.
  * 
  * \see filter(uint16_t *data)
+ * \see FILTER_INCREMENTAL
  * 
  */
 void thread_processing(void *argA , void *argB, void *argC)
 {
+    OFILTER_DEFINE(window, SIZE);   // Window of samples of the incremental filter
+    uint16_t sample;
+    uint32_t n, got;
+#if !FILTER_INCREMENTAL
+    uint16_t samples[SIZE];     // Last samples
+#endif
+    struct k_poll_event event = K_POLL_EVENT_INITIALIZER(K_POLL_TYPE_SIGNAL, K_POLL_MODE_NOTIFY_ONLY, &sig_sample);
+
+    ofilter_init(&window);
+
     while(1)
     {
-        k_sem_take(&sem_adc,  K_FOREVER);   // Wait for new sample
+        if(spsc_ring_count(&sample_ring) == 0)
+            k_poll(&event, 1, K_MSEC(2 * SAMP_PERIOD_MS));  // Wait for new sample
+        k_poll_signal_reset(&sig_sample);   // Samples put from now on raise it again
+        event.state = K_POLL_STATE_NOT_READY;
         
-        average = filter(sample_buffer.data);   // Filter data
+        n = spsc_ring_count(&sample_ring);
+        got = 0;
+        do
+        {
+            if(spsc_ring_get(&sample_ring, &sample) != 0)
+                break;  // Woken by the timeout, no sample
+            got++;
+#if FILTER_INCREMENTAL
+            ofilter_insert(&window, sample);    // Every sample, in order
+#endif
+        } while(got < n);
+
+        if(got == 0)
+            continue;
+
+#if FILTER_INCREMENTAL
+        average = ofilter_output(&window);  // Filter data
+#else
+        if(spsc_ring_snapshot(&sample_ring, samples, SIZE) != 0)
+            continue;   // Producer kept overwriting the window
+        average = filter(samples);   // Filter data
+#endif
         
         printk("\nnew average = %d\n",average);
+        printk("ring overruns = %u, underruns = %u\n",
+               spsc_ring_overruns_get(&sample_ring), spsc_ring_underruns_get(&sample_ring));
 
         k_sem_give(&sem_proc);  // Signal new processed data
     }
@@ -201,7 +250,8 @@ void thread_actuation(void *argA , void *argB, void *argC)
  *  
  *  This function implements a digital filter that removes the outliers
  * (10% or high deviation from average) from a set of data and computes the average
- * of the remaining samples.  
+ * of the remaining samples. It scans the whole window, the outlier filter module gives the
+ * same result incrementally (ofilter_output()).
  *
  * \param[in] data pointer to array 
  * 
@@ -1,21 +1,409 @@
 /** \file ADC.c
  * 	\brief Module that implements ADC operations in nRF52840DK_nRF52840 board
- * 
+ *
  * \author André Brandão
  * \author Emanuel Pereira
- * \date 26/05/2022
+ * \date 29/05/2022
  */
- 
+#include <errno.h>
 #include "ADC.h"
 
+#ifdef CONFIG_NRFX_SAADC
+#include <nrfx_saadc.h>
+#include <nrfx_timer.h>
+#include <nrfx_ppi.h>
+#endif
+
+#ifdef CONFIG_ADC_EMUL
+#include <drivers/adc/adc_emul.h>
+#endif
+
+/* The conversion to millivolts (ADC_conv.h) uses the gain and reference of the channel */
+BUILD_ASSERT(ADC_GAIN_INV_OF(ADC_GAIN) == ADC_GAIN_INV, "ADC_GAIN_INV (ADC_conv.h) does not match ADC_GAIN");
+BUILD_ASSERT(ADC_REF_MV_OF(ADC_REFERENCE) == ADC_REF_MV, "ADC_REF_MV (ADC_conv.h) does not match ADC_REFERENCE");
+
 /* Global vars */
-const struct device *adc_dev = NULL; 	/**< Pointer to ADC device structure */
-static uint16_t adc_sample_buffer[BUFFER_SIZE]; /**< Buffer to store the adc samples */
+const struct device *adc_dev = NULL; /**< Pointer to ADC device structure */
+static int16_t adc_sample_buffer[BUFFER_SIZE]; /**< Buffer to store the adc samples */
+
+/* Continuous mode */
+static struct adc_block adc_blocks[ADC_NUM_BLOCKS]; /**< Blocks of samples */
+static K_FIFO_DEFINE(adc_free_fifo);    /**< Blocks free to be filled */
+static K_FIFO_DEFINE(adc_ready_fifo);   /**< Blocks filled, waiting for adc_block_get() */
+static uint32_t adc_rate_hz = 0;        /**< Sampling rate, 0 if continuous mode is stopped */
+static uint32_t adc_overruns = 0;       /**< Blocks lost because the consumer was late */
+
+/* Conversion */
+static const uint16_t *adc_lut = NULL;  /**< Linearization table, NULL for the ideal conversion */
+static uint32_t adc_saturations = 0;    /**< Out of range samples */
+
+/** \brief Function to put all blocks in the free fifo
+ *
+ *  \pre All blocks were released by the consumer
+ */
+static void adc_blocks_init(void)
+{
+	k_fifo_init(&adc_free_fifo);
+	k_fifo_init(&adc_ready_fifo);
+
+	for(unsigned int i = 0; i < ADC_NUM_BLOCKS; i++)
+		k_fifo_put(&adc_free_fifo, &adc_blocks[i]);
+}
+
+/** \brief Linearization table of the board
+ *
+ *  Boards with a characterized ADC override this function (it is weak) with a table of
+ * ADC_LUT_SEGMENTS + 1 points, see adc_conv_mv(). It is read by adc_config() after the
+ * offset calibration.
+ *
+ *  \returns table or NULL to use the ideal conversion
+ */
+__weak const uint16_t *adc_board_lut(void)
+{
+	return NULL;
+}
+
+/** \brief Function to convert a raw sample to millivolts
+ *
+ *  Out of range samples are clamped to 0 or full scale and counted.
+ *
+ *  \param[in] raw ADC sample
+ *  \param[out] mv tension in millivolts
+ *
+ *  \returns 0, ADC_SAT_LOW or ADC_SAT_HIGH if the sample was out of range
+ */
+int adc_convert(int16_t raw, uint16_t *mv)
+{
+	int sat = adc_conv_mv(raw, adc_lut, mv);
+
+	if(sat)
+		adc_saturations++;
+
+	return sat;
+}
+
+/** \brief Function to convert a raw sample to millivolts
+ *
+ *  \param[in] raw ADC sample
+ *
+ *  \returns tension in millivolts (clamped if the sample is out of range)
+ *
+ *  \see adc_convert()
+ */
+uint16_t adc_to_mv(int16_t raw)
+{
+	uint16_t mv;
+
+	adc_convert(raw, &mv);
+
+	return mv;
+}
+
+/** \brief Function to get the number of saturated samples
+ *
+ *  \returns number of out of range samples converted since boot
+ */
+uint32_t adc_saturations_get(void)
+{
+	return adc_saturations;
+}
+
+/** \brief Function to get the number of lost blocks
+ *
+ *  A block is lost when the ADC needs a buffer and every block is either
+ * full (waiting for adc_block_get()) or in use by the consumer. Only with the SAADC
+ * driven directly, the Zephyr ADC API path never loses a block.
+ *
+ *  \returns number of blocks overwritten or skipped since boot
+ */
+uint32_t adc_overruns_get(void)
+{
+	return adc_overruns;
+}
+
+#ifdef CONFIG_NRFX_SAADC
+/* ************************************************************************** */
+/* SAADC driven directly: TIMER -> PPI -> SAMPLE task, EasyDMA in ping-pong   */
+/* ************************************************************************** */
+
+#define ADC_TIMER_FREQ_HZ 16000000 /**< Frequency of the timer that triggers the conversions */
+/** Acquisition time of the continuous mode (us, 3, 5, 10, 15, 20 or 40). The SAADC needs 3 us for sources up to
+ * 10 kΩ, 5 us up to 40 kΩ, 10 us up to 100 kΩ, 15 us up to 200 kΩ, 20 us up to 400 kΩ and 40 us up to 800 kΩ.
+ * The 10 kΩ potentiometer is at most 2.5 kΩ, 10 us leaves room for a sensor divider. */
+#define ADC_CONT_ACQ_TIME_US 10
+#define ADC_MAX_RATE_HZ ADC_MAX_RATE_OF(ADC_CONT_ACQ_TIME_US) /**< Maximum SAADC sampling rate (83 kHz) */
+#define ADC_NRF_ACQTIME(us) ADC_NRF_ACQTIME_(us) /**< nrf_saadc_acqtime_t of an acquisition time (us) */
+#define ADC_NRF_ACQTIME_(us) NRF_SAADC_ACQTIME_ ## us ## US
+
+BUILD_ASSERT(ADC_NUM_BLOCKS >= 3, "Two blocks in DMA plus at least one for the consumer");
+BUILD_ASSERT(ADC_GAIN == ADC_GAIN_1_4 && ADC_REFERENCE == ADC_REF_VDD_1_4,
+	     "The SAADC channel is set to NRF_SAADC_GAIN1_4 and NRF_SAADC_REFERENCE_VDD4, change them with ADC_GAIN and ADC_REFERENCE");
+
+static const nrfx_timer_t adc_timer = NRFX_TIMER_INSTANCE(1); /**< Timer that triggers the conversions */
+static nrf_ppi_channel_t adc_ppi_channel;   /**< PPI channel from the timer compare event to the SAMPLE task */
+static volatile int16_t adc_last_raw = 0;   /**< Last sample of the last full block */
+static volatile bool adc_stalled = false;   /**< No buffer was available, acquisition stopped */
+
+/** \brief SAADC event handler (interrupt context)
+ *
+ *  On BUF_REQ gives the next buffer to EasyDMA (a free block or, if the consumer is
+ * late, the oldest full block). On DONE queues the full block for adc_block_get().
+ */
+static void adc_nrfx_handler(nrfx_saadc_evt_t const *p_event)
+{
+	struct adc_block *block;
+
+	switch(p_event->type)
+	{
+		case NRFX_SAADC_EVT_BUF_REQ:
+			block = k_fifo_get(&adc_free_fifo, K_NO_WAIT);
+			if(block == NULL)
+			{
+				block = k_fifo_get(&adc_ready_fifo, K_NO_WAIT);	// Drop the oldest full block
+				adc_overruns++;
+			}
+
+			if(block != NULL)
+				nrfx_saadc_buffer_set(block->samples, ADC_BLOCK_SIZE);
+			else
+				adc_stalled = true;	// Every block is in use, restarted by adc_block_release()
+			break;
+
+		case NRFX_SAADC_EVT_DONE:
+			block = CONTAINER_OF(p_event->data.done.p_buffer, struct adc_block, samples);
+			adc_last_raw = p_event->data.done.p_buffer[p_event->data.done.size - 1];
+			k_fifo_put(&adc_ready_fifo, block);
+			break;
+
+		default:
+			break;
+	}
+}
+
+/** \brief Timer event handler, unused (the compare event only triggers the SAADC through PPI) */
+static void adc_timer_handler(nrf_timer_event_t event_type, void *p_context)
+{
+}
+
+/** \brief Function to configure ADC
+ *
+ *  SAADC, timer and PPI configuration. The SAADC is calibrated, each timer compare event
+ * triggers one conversion once adc_continuous_start() sets the advanced mode.
+ *
+ *  \see adc_continuous_start()
+*/
+void adc_config()
+{
+	nrfx_saadc_channel_t channel = NRFX_SAADC_DEFAULT_CHANNEL_SE(ADC_CHANNEL_INPUT, ADC_CHANNEL_ID);
+	nrfx_timer_config_t timer_config = NRFX_TIMER_DEFAULT_CONFIG;
+	nrfx_err_t err;
+
+	IRQ_CONNECT(DT_IRQN(ADC_NID), DT_IRQ(ADC_NID, priority), nrfx_isr, nrfx_saadc_irq_handler, 0);
+
+	err = nrfx_saadc_init(DT_IRQ(ADC_NID, priority));
+	if (err != NRFX_SUCCESS) {
+		printk("nrfx_saadc_init() failed with error code %x\n", err);
+		return;
+	}
+
+	channel.channel_config.gain = NRF_SAADC_GAIN1_4;
+	channel.channel_config.reference = NRF_SAADC_REFERENCE_VDD4;
+	channel.channel_config.acq_time = ADC_NRF_ACQTIME(ADC_CONT_ACQ_TIME_US);
+	err = nrfx_saadc_channels_config(&channel, 1);
+	if (err != NRFX_SUCCESS) {
+		printk("nrfx_saadc_channels_config() failed with error code %x\n", err);
+	}
+
+	/* It is recommended to calibrate the SAADC at least once before use, and whenever the ambient temperature has changed by more than 10 °C */
+	nrfx_saadc_offset_calibrate(NULL);
+	adc_lut = adc_board_lut();
+
+	timer_config.frequency = NRF_TIMER_FREQ_16MHz;
+	timer_config.bit_width = NRF_TIMER_BIT_WIDTH_32;
+	err = nrfx_timer_init(&adc_timer, &timer_config, adc_timer_handler);
+	if (err != NRFX_SUCCESS) {
+		printk("nrfx_timer_init() failed with error code %x\n", err);
+	}
+
+	if (nrfx_ppi_channel_alloc(&adc_ppi_channel) != NRFX_SUCCESS) {
+		printk("nrfx_ppi_channel_alloc() failed\n");
+		return;
+	}
+	nrfx_ppi_channel_assign(adc_ppi_channel,
+		nrfx_timer_event_address_get(&adc_timer, NRF_TIMER_EVENT_COMPARE0),
+		nrf_saadc_task_address_get(NRF_SAADC, NRF_SAADC_TASK_SAMPLE));
+	nrfx_ppi_channel_enable(adc_ppi_channel);
+}
+
+/** \brief Function to get samples from ADC
+ *
+ *  While the continuous acquisition runs this function returns the most recent sample,
+ * otherwise it sets the SAADC to simple (blocking) mode and converts one sample.
+ *
+ *  \returns tension in millivolts from ADC.
+ *
+ *  \see adc_config()
+*/
+uint16_t adc_sample(void)
+{
+	int16_t raw = 0;
+	nrfx_err_t err;
+
+	if(adc_rate_hz != 0)
+		return adc_to_mv(adc_last_raw);
+
+	err = nrfx_saadc_simple_mode_set(BIT(ADC_CHANNEL_ID), NRF_SAADC_RESOLUTION_10BIT,
+		NRF_SAADC_OVERSAMPLE_DISABLED, NULL);	// No handler, blocking
+	if (err == NRFX_SUCCESS)
+		err = nrfx_saadc_buffer_set(&raw, 1);
+	if (err == NRFX_SUCCESS)
+		err = nrfx_saadc_mode_trigger();	// Returns with the conversion done
+	if (err != NRFX_SUCCESS) {
+		printk("SAADC one-shot conversion failed with error code %x\n", err);
+		return 0;
+	}
+
+	return adc_to_mv(raw);
+}
+
+/** \brief Function to start the continuous acquisition
+ *
+ *  Sets the SAADC to advanced mode, restarting on END, gives two blocks to EasyDMA (ping-pong)
+ * and starts the timer that triggers the conversions.
+ *
+ *  \pre adc_config() has been called, all blocks were released
+ *
+ *  \param[in] rate_hz sampling rate (Hz), up to ADC_MAX_RATE_HZ
+ *
+ *  \returns 0 on success, negative error code otherwise
+ */
+int adc_continuous_start(uint32_t rate_hz)
+{
+	nrfx_saadc_adv_config_t adv_config = NRFX_SAADC_DEFAULT_ADV_CONFIG;
+	struct adc_block *block;
+	nrfx_err_t err;
+
+	if(rate_hz == 0 || rate_hz > ADC_MAX_RATE_HZ)
+		return -EINVAL;
+
+	if(adc_rate_hz != 0)
+		return -EBUSY;
+
+	adv_config.start_on_end = true;	// Next buffer starts without CPU intervention
+	err = nrfx_saadc_advanced_mode_set(BIT(ADC_CHANNEL_ID), NRF_SAADC_RESOLUTION_10BIT, &adv_config, adc_nrfx_handler);
+	if (err != NRFX_SUCCESS) {
+		printk("nrfx_saadc_advanced_mode_set() failed with error code %x\n", err);
+		return -EIO;
+	}
+
+	adc_blocks_init();
+	adc_stalled = false;
+
+	for(unsigned int i = 0; i < 2; i++)
+	{
+		block = k_fifo_get(&adc_free_fifo, K_NO_WAIT);
+		nrfx_saadc_buffer_set(block->samples, ADC_BLOCK_SIZE);
+	}
+
+	nrfx_saadc_mode_trigger();	// START task, conversions are triggered by the timer
+
+	nrfx_timer_extended_compare(&adc_timer, NRF_TIMER_CC_CHANNEL0, ADC_TIMER_FREQ_HZ / rate_hz,
+		NRF_TIMER_SHORT_COMPARE0_CLEAR_MASK, false);
+	nrfx_timer_enable(&adc_timer);
+
+	adc_rate_hz = rate_hz;
+
+	return 0;
+}
+
+/** \brief Function to stop the continuous acquisition */
+void adc_continuous_stop(void)
+{
+	nrfx_timer_disable(&adc_timer);
+	nrfx_saadc_abort();
+	adc_rate_hz = 0;
+}
+
+/** \brief Function to get the next full block
+ *
+ *  \param[in] timeout time to wait for a block
+ *
+ *  \returns block of ADC_BLOCK_SIZE raw samples (must be given back with adc_block_release())
+ * or NULL on timeout
+ */
+struct adc_block *adc_block_get(k_timeout_t timeout)
+{
+	return k_fifo_get(&adc_ready_fifo, timeout);
+}
+
+/** \brief Function to give a block back to the ADC
+ *
+ *  If the acquisition stopped for lack of buffers it is restarted with this block.
+ *
+ *  \param[in] block block returned by adc_block_get()
+ */
+void adc_block_release(struct adc_block *block)
+{
+	unsigned int key = irq_lock();
+
+	if(adc_stalled && adc_rate_hz != 0)	// Restart the acquisition with this block
+	{
+		adc_stalled = false;
+		nrfx_saadc_buffer_set(block->samples, ADC_BLOCK_SIZE);
+		nrfx_saadc_mode_trigger();
+	}
+	else
+	{
+		k_fifo_put(&adc_free_fifo, block);
+	}
+
+	irq_unlock(key);
+}
+
+/** \brief Function to configure the channels of a scan
+ *
+ *  Not available when the SAADC is driven directly, its channels are owned by the
+ * continuous acquisition.
+ *
+ *  \returns -ENOTSUP
+ */
+int adc_scan_config(const struct adc_scan_channel *table, uint8_t n)
+{
+	return -ENOTSUP;
+}
+
+/** \brief Function to scan the channels
+ *
+ *  \returns -ENOTSUP
+ *
+ *  \see adc_scan_config()
+ */
+int adc_scan(int16_t *samples)
+{
+	return -ENOTSUP;
+}
+
+#else
+/* ************************************************************************** */
+/* Zephyr ADC API (also used with the ADC emulator on native_posix)           */
+/* ************************************************************************** */
+
+#ifdef CONFIG_ADC_EMUL
+/** \brief Test signal of the ADC emulator: sawtooth from 500 mV to 2480 mV */
+static int adc_emul_signal(const struct device *dev, unsigned int chan, void *data, uint32_t *result)
+{
+	static uint32_t n = 0;
+
+	*result = 500 + (n++ % 100) * 20;
+
+	return 0;
+}
+#endif
 
 /** \brief Function to configure ADC
- *   
+ *
  *  ADC driver's configuration
- * 
+ *
  *  \see adc_sample()
 */
 void adc_config()
@@ -25,24 +413,31 @@ void adc_config()
 	adc_dev = device_get_binding(DT_LABEL(ADC_NID));
 	if (!adc_dev) {
         printk("ADC device_get_binding() failed\n");
-    } 
+    }
     err = adc_channel_setup(adc_dev, &my_channel_cfg);
     if (err) {
         printk("adc_channel_setup() failed with error code %d\n", err);
     }
 
+#ifdef CONFIG_ADC_EMUL
+	adc_emul_value_func_set(adc_dev, ADC_CHANNEL_ID, adc_emul_signal, NULL);
+#endif
+
+#ifdef CONFIG_SOC_FAMILY_NRF
 	/* It is recommended to calibrate the SAADC at least once before use, and whenever the ambient temperature has changed by more than 10 °C */
     NRF_SAADC->TASKS_CALIBRATEOFFSET = 1;
+#endif
+	adc_lut = adc_board_lut();
 }
 
 /** \brief Function to get samples from ADC
- *   
+ *
  *  This function performs an ADC conversion and converts it to the corresponfing tension.
  *
  *  \pre adc_read() has been called
  *
  *  \returns tension in millivolts from ADC.
- * 
+ *
  *  \see adc_config()
 */
 uint16_t adc_sample(void)
@@ -64,10 +459,303 @@ uint16_t adc_sample(void)
 
 	if (ret) {
             printk("adc_read() failed with code %d\n", ret);
-	}	
-	
-        if(adc_sample_buffer[0] > 1023)	// Out of range
-                adc_sample_buffer[0] = 0;
+	}
+
+	return adc_to_mv(adc_sample_buffer[0]);
+}
+
+#define ADC_ACQ_STACK_SIZE 1024 /**< Stack size of the acquisition thread */
+#define ADC_ACQ_PRIO 0          /**< Priority of the acquisition thread, above the application threads */
+
+static K_THREAD_STACK_DEFINE(adc_acq_stack, ADC_ACQ_STACK_SIZE); /**< Stack of the acquisition thread */
+static struct k_thread adc_acq_thread_data;  /**< Acquisition thread */
+K_TIMER_DEFINE(adc_block_timer, NULL, NULL);  /**< Start of each block period */
+
+/** \brief Acquisition thread of the continuous mode
+ *
+ *  Reads one block every block period, as a sequence of ADC_BLOCK_SIZE samplings paced by the
+ * driver, and queues it for adc_block_get(). If the consumer is late the oldest full block is
+ * read again and counted as an overrun, if the consumer holds every block the acquisition
+ * waits for adc_block_release().
+ */
+static void adc_acq_thread(void *argA, void *argB, void *argC)
+{
+	struct adc_block *block;
+	int ret;
+	const struct adc_sequence_options options = {
+		.interval_us = 1000000 / adc_rate_hz,
+		.extra_samplings = ADC_BLOCK_SIZE - 1,
+	};
+	struct adc_sequence sequence = {
+		.options = &options,
+		.channels = BIT(ADC_CHANNEL_ID),
+		.buffer_size = sizeof(block->samples),
+		.resolution = ADC_RESOLUTION,
+	};
+
+	k_timer_start(&adc_block_timer, K_NO_WAIT, K_USEC(ADC_BLOCK_SIZE * options.interval_us));
+
+	while(1)
+	{
+		k_timer_status_sync(&adc_block_timer);	// Start of the next block period
+		if(adc_rate_hz == 0)
+			break;
+
+		block = k_fifo_get(&adc_free_fifo, K_NO_WAIT);
+		if(block == NULL)
+		{
+			block = k_fifo_get(&adc_ready_fifo, K_NO_WAIT);	// Drop the oldest full block
+			if(block != NULL)
+				adc_overruns++;
+		}
+		if(block == NULL)
+			block = k_fifo_get(&adc_free_fifo, K_FOREVER);	// Every block is in use, wait for adc_block_release()
+		if(block == NULL)
+			break;	// Cancelled by adc_continuous_stop()
+
+		sequence.buffer = block->samples;
+		ret = adc_read(adc_dev, &sequence);
+		if (ret) {
+			printk("adc_read() failed with code %d\n", ret);
+			k_fifo_put(&adc_free_fifo, block);
+			continue;
+		}
+		k_fifo_put(&adc_ready_fifo, block);
+	}
+
+	k_timer_stop(&adc_block_timer);
+}
+
+/** \brief Function to start the continuous acquisition
+ *
+ *  With the Zephyr ADC API the blocks are read by an acquisition thread, one block every
+ * ADC_BLOCK_SIZE sample periods, as a sequence of samplings paced by the driver at rate_hz.
+ * This is not DMA driven, the thread runs once per block.
+ *
+ *  \pre adc_config() has been called, all blocks were released
+ *
+ *  \param[in] rate_hz sampling rate (Hz), up to 23 kHz (ADC_ACQ_TIME_US)
+ *
+ *  \returns 0 on success, negative error code otherwise
+ */
+int adc_continuous_start(uint32_t rate_hz)
+{
+	if(rate_hz == 0 || rate_hz > ADC_MAX_RATE_OF(ADC_ACQ_TIME_US))
+		return -EINVAL;
+
+	if(adc_dev == NULL)
+		return -ENODEV;
+
+	if(adc_rate_hz != 0)
+		return -EBUSY;
+
+	adc_blocks_init();
+	adc_rate_hz = rate_hz;
+
+	k_thread_create(&adc_acq_thread_data, adc_acq_stack, K_THREAD_STACK_SIZEOF(adc_acq_stack),
+		adc_acq_thread, NULL, NULL, NULL, ADC_ACQ_PRIO, 0, K_NO_WAIT);
+
+	return 0;
+}
+
+/** \brief Function to stop the continuous acquisition
+ *
+ *  Waits for the block being read, if any.
+ */
+void adc_continuous_stop(void)
+{
+	if(adc_rate_hz == 0)
+		return;
+
+	adc_rate_hz = 0;
+	k_timer_stop(&adc_block_timer);	// Wakes the thread waiting for the block period
+	k_fifo_cancel_wait(&adc_free_fifo);	// or for a free block
+	k_thread_join(&adc_acq_thread_data, K_FOREVER);
+}
 
-	return (uint16_t)(1000*adc_sample_buffer[0]*((float)3/1023)); // Convert the sample to millivolts
+/** \brief Function to get the next full block
+ *
+ *  \param[in] timeout time to wait for a block
+ *
+ *  \returns block of ADC_BLOCK_SIZE raw samples (must be given back with adc_block_release())
+ * or NULL on timeout
+ */
+struct adc_block *adc_block_get(k_timeout_t timeout)
+{
+	return k_fifo_get(&adc_ready_fifo, timeout);
 }
+
+/** \brief Function to give a block back to the ADC
+ *
+ *  \param[in] block block returned by adc_block_get()
+ */
+void adc_block_release(struct adc_block *block)
+{
+	k_fifo_put(&adc_free_fifo, block);
+}
+
+/* Scan mode */
+static const struct adc_scan_channel *scan_table = NULL; /**< Channels to scan */
+static uint8_t scan_n = 0;                               /**< Number of channels to scan */
+
+/** \brief Function to get the reference tension of a channel
+ *
+ *  \param[in] reference reference of the channel
+ *
+ *  \returns reference tension in millivolts, 0 if unknown
+ */
+static int32_t adc_ref_mv(enum adc_reference reference)
+{
+	switch(reference)
+	{
+		case ADC_REF_VDD_1:
+			return ADC_VDD_MV;
+		case ADC_REF_VDD_1_2:
+			return ADC_VDD_MV / 2;
+		case ADC_REF_VDD_1_3:
+			return ADC_VDD_MV / 3;
+		case ADC_REF_VDD_1_4:
+			return ADC_VDD_MV / 4;
+		case ADC_REF_INTERNAL:
+			return adc_ref_internal(adc_dev);
+		default:
+			return 0;
+	}
+}
+
+/** \brief Function to configure the channels of a scan
+ *
+ *  Sets up every channel of the table on the ADC. The table is not copied, it must
+ * stay valid while it is used by adc_scan().
+ *
+ *  \pre adc_config() has been called
+ *
+ *  \param[in] table channels to scan
+ *  \param[in] n number of channels of the table
+ *
+ *  \returns 0 on success, negative error code otherwise
+ */
+int adc_scan_config(const struct adc_scan_channel *table, uint8_t n)
+{
+	uint32_t used = 0;
+	int err;
+
+	if(adc_dev == NULL)
+		return -ENODEV;
+
+	if(table == NULL || n == 0 || n > ADC_SCAN_MAX_CHANNELS)
+		return -EINVAL;
+
+	for(unsigned int i = 0; i < n; i++)
+	{
+		if(table[i].channel_id >= ADC_SCAN_MAX_CHANNELS || (used & BIT(table[i].channel_id)))
+			return -EINVAL;	// Out of range or repeated
+		used |= BIT(table[i].channel_id);
+	}
+
+	scan_n = 0;
+
+	for(unsigned int i = 0; i < n; i++)
+	{
+		struct adc_channel_cfg cfg = {
+			.gain = table[i].gain,
+			.reference = table[i].reference,
+			.acquisition_time = table[i].acquisition_time,
+			.channel_id = table[i].channel_id,
+#ifdef CONFIG_ADC_CONFIGURABLE_INPUTS
+			.input_positive = table[i].input,
+#endif
+		};
+
+		err = adc_channel_setup(adc_dev, &cfg);
+		if (err) {
+			printk("adc_channel_setup() failed for channel %d with error code %d\n", table[i].channel_id, err);
+			return err;
+		}
+
+#ifdef CONFIG_ADC_EMUL
+		adc_emul_value_func_set(adc_dev, table[i].channel_id, adc_emul_signal, NULL);
+#endif
+	}
+
+	scan_table = table;
+	scan_n = n;
+
+	return 0;
+}
+
+/** \brief Function to scan the channels
+ *
+ *  Converts all channels of the table in one sequence and calls the callback of each
+ * channel with its result. Oversampling is a property of the sequence, so channels with
+ * different oversampling are converted in one sequence per oversampling value.
+ *
+ *  \pre adc_scan_config() has been called
+ *
+ *  \param[out] samples raw samples, in the order of the table (can be NULL)
+ *
+ *  \returns 0 on success, negative error code otherwise
+ */
+int adc_scan(int16_t *samples)
+{
+	int16_t buffer[ADC_SCAN_MAX_CHANNELS];	// Interleaved samples, by channel id
+	uint32_t done = 0, channels;
+	unsigned int idx;
+	int32_t mv;
+	int ret;
+	struct adc_sequence sequence = {
+		.buffer = buffer,
+		.buffer_size = sizeof(buffer),
+		.resolution = ADC_RESOLUTION,
+	};
+
+	if(adc_dev == NULL || scan_n == 0)
+		return -ENODEV;
+
+	for(unsigned int i = 0; i < scan_n; i++)
+	{
+		if(done & BIT(i))
+			continue;
+
+		/* Every channel not yet converted with the same oversampling goes in this sequence */
+		channels = 0;
+		for(unsigned int j = i; j < scan_n; j++)
+			if(!(done & BIT(j)) && scan_table[j].oversampling == scan_table[i].oversampling)
+				channels |= BIT(scan_table[j].channel_id);
+
+		sequence.channels = channels;
+		sequence.oversampling = scan_table[i].oversampling;
+
+		ret = adc_read(adc_dev, &sequence);
+		if (ret) {
+			printk("adc_read() failed with code %d\n", ret);
+			return ret;
+		}
+
+		for(unsigned int j = i; j < scan_n; j++)
+		{
+			const struct adc_scan_channel *ch = &scan_table[j];
+
+			if(!(channels & BIT(ch->channel_id)))
+				continue;
+			done |= BIT(j);
+
+			idx = __builtin_popcount(channels & (BIT(ch->channel_id) - 1));	// Samples are stored by ascending channel id
+			if(samples != NULL)
+				samples[j] = buffer[idx];
+
+			if(ch->callback != NULL)
+			{
+				mv = buffer[idx];
+				if(adc_ref_mv(ch->reference) == 0 ||
+				   adc_raw_to_millivolts(adc_ref_mv(ch->reference), ch->gain, ADC_RESOLUTION, &mv) != 0)
+					mv = -1;
+				ch->callback(ch->channel_id, buffer[idx], mv, ch->user_data);
+			}
+		}
+	}
+
+	return 0;
+}
+
+#endif // CONFIG_NRFX_SAADC
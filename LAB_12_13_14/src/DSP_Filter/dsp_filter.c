@@ -0,0 +1,602 @@
+/** \file dsp_filter.c
+ * 	\brief Module implementing a library of fixed-point digital filters
+ *
+ *  Each filter type is a set of operations (struct dsp_filter_ops) selected by its init
+ * function. The block operation of each type runs its own loop with the state held in
+ * locals (the biquads stage by stage, the FIR two outputs per pass over the taps), so a
+ * block costs one indirect call. Multiply-accumulates of Q15 pairs use the SMLALD instruction when the target
+ * has the DSP extension (Cortex-M4), the C fallback gives the same results.
+ *
+ *  \author André Brandão
+ *  \author Emanuel Pereira
+ *  \date 29/05/2022
+ */
+
+#include <stddef.h>
+#include <string.h>
+#include <dsp_filter.h>
+
+#if defined(__ARM_FEATURE_DSP) && defined(__ARM_FEATURE_SIMD32)
+#include <arm_acle.h>
+#endif
+
+#define DSP_BIQUAD_CHUNK 32 /**< Samples of each chunk of the Q31 biquad block (stack buffer) */
+
+/** \brief Function to saturate a value to Q15 */
+static inline q15_t sat_q15(int64_t v)
+{
+    if(v > INT16_MAX)
+        return INT16_MAX;
+    if(v < INT16_MIN)
+        return INT16_MIN;
+    return (q15_t)v;
+}
+
+/** \brief Function to saturate a value to Q31 */
+static inline q31_t sat_q31(int64_t v)
+{
+    if(v > INT32_MAX)
+        return INT32_MAX;
+    if(v < INT32_MIN)
+        return INT32_MIN;
+    return (q31_t)v;
+}
+
+/** \brief Function to multiply and accumulate two pairs of Q15 values
+ *
+ * \returns acc + a[0]*b[0] + a[1]*b[1]
+ */
+static inline int64_t mac_q15x2(const q15_t *a, const q15_t *b, int64_t acc)
+{
+#if defined(__ARM_FEATURE_DSP) && defined(__ARM_FEATURE_SIMD32)
+    int16x2_t pa, pb;
+
+    memcpy(&pa, a, sizeof(pa));
+    memcpy(&pb, b, sizeof(pb));
+    return __smlald(pa, pb, acc);
+#else
+    return acc + (int32_t)a[0] * b[0] + (int32_t)a[1] * b[1];
+#endif
+}
+
+/* ************************************************************************** */
+/* Running median                                                             */
+/* ************************************************************************** */
+
+/** \brief Median step: replaces the oldest sample of the window, O(size) */
+static q15_t median_step(struct dsp_filter *f, q15_t x)
+{
+    q15_t *sorted = f->s.median.sorted;
+    q15_t old = f->s.median.ring[f->s.median.pos];
+    int lo = 0, hi = f->s.median.size - 1, i;
+
+    f->s.median.ring[f->s.median.pos] = x;
+    f->s.median.pos = (f->s.median.pos + 1) % f->s.median.size;
+
+    /* Find the oldest sample in the sorted window */
+    while(lo < hi)
+    {
+        i = (lo + hi) / 2;
+        if(sorted[i] < old)
+            lo = i + 1;
+        else
+            hi = i;
+    }
+    i = lo;
+
+    /* Slide the new sample to its place */
+    if(x > old)
+    {
+        while(i + 1 < f->s.median.size && sorted[i + 1] < x)
+        {
+            sorted[i] = sorted[i + 1];
+            i++;
+        }
+    }
+    else
+    {
+        while(i > 0 && sorted[i - 1] > x)
+        {
+            sorted[i] = sorted[i - 1];
+            i--;
+        }
+    }
+    sorted[i] = x;
+
+    return sorted[f->s.median.size / 2];
+}
+
+/** \brief Median reset: window filled with zeros */
+static void median_reset(struct dsp_filter *f)
+{
+    memset(f->s.median.ring, 0, f->s.median.size * sizeof(q15_t));
+    memset(f->s.median.sorted, 0, f->s.median.size * sizeof(q15_t));
+    f->s.median.pos = 0;
+}
+
+/** \brief Median block: the window is updated sample by sample */
+static void median_block(struct dsp_filter *f, const q15_t *in, q15_t *out, uint32_t n)
+{
+    for(uint32_t i = 0; i < n; i++)
+        out[i] = median_step(f, in[i]);
+}
+
+static const struct dsp_filter_ops median_ops = {DSP_MEDIAN, median_step, median_block, median_reset}; /**< Running median */
+
+/** \brief Function to initialize a running median
+ *
+ *  The output is the middle sample of the sorted window (the upper one if size is even).
+ *
+ *  \param[out] f filter
+ *  \param[in] buf storage of the window, DSP_MEDIAN_BUF_SIZE(size) samples
+ *  \param[in] size window size (1 to DSP_MEDIAN_MAX)
+ *
+ *  \returns 0 on success, -1 if the parameters are invalid
+ */
+int dsp_median_init(struct dsp_filter *f, q15_t *buf, uint16_t size)
+{
+    if(buf == NULL || size == 0 || size > DSP_MEDIAN_MAX)
+        return -1;
+
+    f->ops = &median_ops;
+    f->s.median.ring = buf;
+    f->s.median.sorted = buf + size;
+    f->s.median.size = size;
+    median_reset(f);
+
+    return 0;
+}
+
+/* ************************************************************************** */
+/* Exponential moving average                                                 */
+/* ************************************************************************** */
+
+/** \brief EMA step: y += alpha * (x - y), y kept with 16 fractional bits */
+static q15_t ema_step(struct dsp_filter *f, q15_t x)
+{
+    q31_t acc = f->s.ema.acc;
+
+    acc += (q31_t)(((int64_t)f->s.ema.alpha * ((int64_t)x * 65536 - acc)) >> 15);
+    f->s.ema.acc = acc;
+
+    return sat_q15((acc + 32768) >> 16);    // Rounded
+}
+
+/** \brief EMA reset: output 0 */
+static void ema_reset(struct dsp_filter *f)
+{
+    f->s.ema.acc = 0;
+}
+
+/** \brief EMA block: same as ema_step(), the output kept in a local */
+static void ema_block(struct dsp_filter *f, const q15_t *in, q15_t *out, uint32_t n)
+{
+    q31_t acc = f->s.ema.acc;
+    int64_t alpha = f->s.ema.alpha;
+
+    for(uint32_t i = 0; i < n; i++)
+    {
+        acc += (q31_t)((alpha * ((int64_t)in[i] * 65536 - acc)) >> 15);
+        out[i] = sat_q15((acc + 32768) >> 16);
+    }
+
+    f->s.ema.acc = acc;
+}
+
+static const struct dsp_filter_ops ema_ops = {DSP_EMA, ema_step, ema_block, ema_reset}; /**< Exponential moving average */
+
+/** \brief Function to initialize an exponential moving average
+ *
+ *  \param[out] f filter
+ *  \param[in] alpha weight of the new sample, Q15 (1 to 32767)
+ *
+ *  \returns 0 on success, -1 if alpha is invalid
+ */
+int dsp_ema_init(struct dsp_filter *f, q15_t alpha)
+{
+    if(alpha <= 0)
+        return -1;
+
+    f->ops = &ema_ops;
+    f->s.ema.alpha = alpha;
+    ema_reset(f);
+
+    return 0;
+}
+
+/* ************************************************************************** */
+/* FIR                                                                        */
+/* ************************************************************************** */
+
+/** \brief FIR step: y = sum(taps[k] * x[n-k]), 64-bit accumulator, truncated to Q15 */
+static q15_t fir_step(struct dsp_filter *f, q15_t x)
+{
+    uint16_t n = f->s.fir.ntaps;
+    const q15_t *taps = f->s.fir.taps;
+    const q15_t *s;
+    int64_t acc = 0;
+    int k;
+
+    /* The newest sample goes before the previous one, stored twice so that
+       the last ntaps samples are always contiguous */
+    f->s.fir.pos = (f->s.fir.pos == 0) ? n - 1 : f->s.fir.pos - 1;
+    f->s.fir.state[f->s.fir.pos] = x;
+    f->s.fir.state[f->s.fir.pos + n] = x;
+    s = &f->s.fir.state[f->s.fir.pos];
+
+    for(k = 0; k + 1 < n; k += 2)
+        acc = mac_q15x2(&taps[k], &s[k], acc);
+    if(k < n)
+        acc += (int32_t)taps[k] * s[k];
+
+    return sat_q15(acc >> 15);
+}
+
+/** \brief FIR reset: past samples 0 */
+static void fir_reset(struct dsp_filter *f)
+{
+    memset(f->s.fir.state, 0, 2 * f->s.fir.ntaps * sizeof(q15_t));
+    f->s.fir.pos = 0;
+}
+
+/** \brief FIR block: two outputs per pass over the taps
+ *
+ *  Two new samples go to the state at once, the window of the older one is the window of
+ * the newer one shifted by one sample, so each pair of taps is loaded once for both
+ * outputs. A sample left over (odd count, or the state wrapping) goes through fir_step().
+ */
+static void fir_block(struct dsp_filter *f, const q15_t *in, q15_t *out, uint32_t cnt)
+{
+    uint16_t n = f->s.fir.ntaps;
+    const q15_t *taps = f->s.fir.taps;
+    q15_t *state = f->s.fir.state;
+    const q15_t *s;
+    int64_t acc0, acc1;
+    q15_t x0, x1;
+    uint32_t i = 0;
+    int k;
+
+    while(i < cnt)
+    {
+        if(f->s.fir.pos < 2 || i + 1 == cnt)
+        {
+            out[i] = fir_step(f, in[i]);
+            i++;
+            continue;
+        }
+
+        x0 = in[i];
+        x1 = in[i + 1];
+        f->s.fir.pos -= 2;
+        s = &state[f->s.fir.pos];   // s[0] is x1, s[1] is x0
+        state[f->s.fir.pos + 1] = x0;
+        state[f->s.fir.pos + 1 + n] = x0;
+        state[f->s.fir.pos] = x1;   // Its copy replaces s[n], the oldest sample of the window of x0
+
+        acc0 = 0;
+        acc1 = 0;
+        for(k = 0; k + 1 < n; k += 2)
+        {
+            acc0 = mac_q15x2(&taps[k], &s[k + 1], acc0);
+            acc1 = mac_q15x2(&taps[k], &s[k], acc1);
+        }
+        if(k < n)
+        {
+            acc0 += (int32_t)taps[k] * s[k + 1];
+            acc1 += (int32_t)taps[k] * s[k];
+        }
+        state[f->s.fir.pos + n] = x1;
+
+        out[i] = sat_q15(acc0 >> 15);
+        out[i + 1] = sat_q15(acc1 >> 15);
+        i += 2;
+    }
+}
+
+static const struct dsp_filter_ops fir_ops = {DSP_FIR, fir_step, fir_block, fir_reset}; /**< FIR */
+
+/** \brief Function to initialize a FIR
+ *
+ *  \param[out] f filter
+ *  \param[in] taps coefficients (Q15), taps[0] weights the newest sample
+ *  \param[in] ntaps number of taps
+ *  \param[in] state storage of the past samples, DSP_FIR_STATE_SIZE(ntaps) samples
+ *
+ *  \returns 0 on success, -1 if the parameters are invalid
+ */
+int dsp_fir_init(struct dsp_filter *f, const q15_t *taps, uint16_t ntaps, q15_t *state)
+{
+    if(taps == NULL || state == NULL || ntaps == 0)
+        return -1;
+
+    f->ops = &fir_ops;
+    f->s.fir.taps = taps;
+    f->s.fir.state = state;
+    f->s.fir.ntaps = ntaps;
+    fir_reset(f);
+
+    return 0;
+}
+
+/* ************************************************************************** */
+/* Biquad cascade (direct form I)                                             */
+/* ************************************************************************** */
+
+/** \brief Q15 biquad step
+ *
+ *  Each stage computes y = b0*x + b1*x[n-1] + b2*x[n-2] + a1*y[n-1] + a2*y[n-2]
+ * (a1 and a2 with the sign changed, as CMSIS-DSP), shifted by 15 - post_shift. Unlike
+ * CMSIS-DSP the result is rounded: the samples are millivolts, with no fractional bits,
+ * and the truncation bias would be multiplied by the DC gain of the feedback.
+ */
+static q15_t biquad_q15_step(struct dsp_filter *f, q15_t x)
+{
+    const q15_t *c = f->s.biquad.coeffs;
+    q15_t *st = f->s.biquad.state;
+    int shift = 15 - f->s.biquad.post_shift;
+    int64_t acc;
+    q15_t y;
+
+    for(int i = 0; i < f->s.biquad.nstages; i++, c += 6, st += 4)
+    {
+        acc = (int32_t)c[0] * x;
+        acc = mac_q15x2(&c[2], &st[0], acc);    // b1*x[n-1] + b2*x[n-2]
+        acc = mac_q15x2(&c[4], &st[2], acc);    // a1*y[n-1] + a2*y[n-2]
+        y = sat_q15((acc + (1 << (shift - 1))) >> shift);  // Rounded, truncation bias is amplified by the feedback
+
+        st[1] = st[0];
+        st[0] = x;
+        st[3] = st[2];
+        st[2] = y;
+
+        x = y;  // Input of the next stage
+    }
+
+    return x;
+}
+
+/** \brief Q15 biquad reset: past samples 0 */
+static void biquad_q15_reset(struct dsp_filter *f)
+{
+    memset(f->s.biquad.state, 0, DSP_BIQUAD_STATE_SIZE(f->s.biquad.nstages) * sizeof(q15_t));
+}
+
+/** \brief Q15 biquad block: the whole block goes through each stage in turn, the state of
+ * the stage in locals (the output of a stage is the input of the next one, in out)
+ */
+static void biquad_q15_block(struct dsp_filter *f, const q15_t *in, q15_t *out, uint32_t n)
+{
+    const q15_t *c = f->s.biquad.coeffs;
+    q15_t *st = f->s.biquad.state;
+    int shift = 15 - f->s.biquad.post_shift;
+    int32_t round = 1 << (shift - 1);
+    q15_t xs[2], ys[2];
+    int64_t acc;
+    q15_t x;
+
+    for(int s = 0; s < f->s.biquad.nstages; s++, c += 6, st += 4)
+    {
+        xs[0] = st[0];
+        xs[1] = st[1];
+        ys[0] = st[2];
+        ys[1] = st[3];
+
+        for(uint32_t i = 0; i < n; i++)
+        {
+            x = in[i];
+            acc = (int32_t)c[0] * x;
+            acc = mac_q15x2(&c[2], xs, acc);    // b1*x[n-1] + b2*x[n-2]
+            acc = mac_q15x2(&c[4], ys, acc);    // a1*y[n-1] + a2*y[n-2]
+
+            xs[1] = xs[0];
+            xs[0] = x;
+            ys[1] = ys[0];
+            ys[0] = sat_q15((acc + round) >> shift);
+            out[i] = ys[0];
+        }
+
+        st[0] = xs[0];
+        st[1] = xs[1];
+        st[2] = ys[0];
+        st[3] = ys[1];
+        in = out;   // Input of the next stage
+    }
+}
+
+static const struct dsp_filter_ops biquad_q15_ops = {DSP_BIQUAD_Q15, biquad_q15_step, biquad_q15_block, biquad_q15_reset}; /**< Q15 biquad */
+
+/** \brief Function to initialize a cascade of Q15 biquads
+ *
+ *  \param[out] f filter
+ *  \param[in] coeffs coefficients {b0, 0, b1, b2, a1, a2} of each stage (CMSIS-DSP layout,
+ * a1 and a2 with the sign changed), scaled down by 2^post_shift
+ *  \param[in] nstages number of stages
+ *  \param[in] post_shift scaling of the coefficients (0 to 14, the output is rounded)
+ *  \param[in] state storage of the past samples, DSP_BIQUAD_STATE_SIZE(nstages)
+ *
+ *  \returns 0 on success, -1 if the parameters are invalid
+ */
+int dsp_biquad_q15_init(struct dsp_filter *f, const q15_t *coeffs, uint8_t nstages, int8_t post_shift, q15_t *state)
+{
+    if(coeffs == NULL || state == NULL || nstages == 0 || post_shift < 0 || post_shift > 14)
+        return -1;
+
+    f->ops = &biquad_q15_ops;
+    f->s.biquad.coeffs = coeffs;
+    f->s.biquad.state = state;
+    f->s.biquad.nstages = nstages;
+    f->s.biquad.post_shift = post_shift;
+    biquad_q15_reset(f);
+
+    return 0;
+}
+
+/** \brief Q31 biquad step
+ *
+ *  The sample is extended to Q31, each stage computes the same as the Q15 biquad with
+ * a 64-bit accumulator shifted by 31 - post_shift, the output is rounded to Q15.
+ */
+static q15_t biquad_q31_step(struct dsp_filter *f, q15_t in)
+{
+    const q31_t *c = f->s.biquad.coeffs;
+    q31_t *st = f->s.biquad.state;
+    int shift = 31 - f->s.biquad.post_shift;
+    q31_t x = (q31_t)in * 65536;
+    int64_t acc;
+    q31_t y;
+
+    for(int i = 0; i < f->s.biquad.nstages; i++, c += 5, st += 4)
+    {
+        acc = (int64_t)c[0] * x;
+        acc += (int64_t)c[1] * st[0];
+        acc += (int64_t)c[2] * st[1];
+        acc += (int64_t)c[3] * st[2];
+        acc += (int64_t)c[4] * st[3];
+        y = sat_q31(acc >> shift);
+
+        st[1] = st[0];
+        st[0] = x;
+        st[3] = st[2];
+        st[2] = y;
+
+        x = y;  // Input of the next stage
+    }
+
+    return sat_q15(((int64_t)x + 32768) >> 16);
+}
+
+/** \brief Q31 biquad reset: past samples 0 */
+static void biquad_q31_reset(struct dsp_filter *f)
+{
+    memset(f->s.biquad.state, 0, DSP_BIQUAD_STATE_SIZE(f->s.biquad.nstages) * sizeof(q31_t));
+}
+
+/** \brief Q31 biquad block: stage by stage as the Q15 one. The output of a stage is
+ * kept in Q31 for the next one, so the block is processed in chunks of DSP_BIQUAD_CHUNK
+ * samples through a local buffer.
+ */
+static void biquad_q31_block(struct dsp_filter *f, const q15_t *in, q15_t *out, uint32_t n)
+{
+    q31_t buf[DSP_BIQUAD_CHUNK];
+    const q31_t *c;
+    q31_t *st;
+    int shift = 31 - f->s.biquad.post_shift;
+    q31_t x1, x2, y1, y2;
+    int64_t acc;
+    uint32_t len;
+
+    while(n > 0)
+    {
+        len = n < DSP_BIQUAD_CHUNK ? n : DSP_BIQUAD_CHUNK;
+        for(uint32_t i = 0; i < len; i++)
+            buf[i] = (q31_t)in[i] * 65536;
+
+        c = f->s.biquad.coeffs;
+        st = f->s.biquad.state;
+        for(int s = 0; s < f->s.biquad.nstages; s++, c += 5, st += 4)
+        {
+            x1 = st[0];
+            x2 = st[1];
+            y1 = st[2];
+            y2 = st[3];
+
+            for(uint32_t i = 0; i < len; i++)
+            {
+                acc = (int64_t)c[0] * buf[i];
+                acc += (int64_t)c[1] * x1;
+                acc += (int64_t)c[2] * x2;
+                acc += (int64_t)c[3] * y1;
+                acc += (int64_t)c[4] * y2;
+
+                x2 = x1;
+                x1 = buf[i];
+                y2 = y1;
+                y1 = sat_q31(acc >> shift);
+                buf[i] = y1;
+            }
+
+            st[0] = x1;
+            st[1] = x2;
+            st[2] = y1;
+            st[3] = y2;
+        }
+
+        for(uint32_t i = 0; i < len; i++)
+            out[i] = sat_q15(((int64_t)buf[i] + 32768) >> 16);
+
+        in += len;
+        out += len;
+        n -= len;
+    }
+}
+
+static const struct dsp_filter_ops biquad_q31_ops = {DSP_BIQUAD_Q31, biquad_q31_step, biquad_q31_block, biquad_q31_reset}; /**< Q31 biquad */
+
+/** \brief Function to initialize a cascade of Q31 biquads
+ *
+ *  For low cut-off frequencies, where the poles are close to 1 and Q15 coefficients
+ * are not precise enough.
+ *
+ *  \param[out] f filter
+ *  \param[in] coeffs coefficients {b0, b1, b2, a1, a2} of each stage (a1 and a2 with the
+ * sign changed), scaled down by 2^post_shift
+ *  \param[in] nstages number of stages
+ *  \param[in] post_shift scaling of the coefficients (0 to 31)
+ *  \param[in] state storage of the past samples, DSP_BIQUAD_STATE_SIZE(nstages)
+ *
+ *  \returns 0 on success, -1 if the parameters are invalid
+ */
+int dsp_biquad_q31_init(struct dsp_filter *f, const q31_t *coeffs, uint8_t nstages, int8_t post_shift, q31_t *state)
+{
+    if(coeffs == NULL || state == NULL || nstages == 0 || post_shift < 0 || post_shift > 31)
+        return -1;
+
+    f->ops = &biquad_q31_ops;
+    f->s.biquad.coeffs = coeffs;
+    f->s.biquad.state = state;
+    f->s.biquad.nstages = nstages;
+    f->s.biquad.post_shift = post_shift;
+    biquad_q31_reset(f);
+
+    return 0;
+}
+
+/* ************************************************************************** */
+/* Common interface                                                           */
+/* ************************************************************************** */
+
+/** \brief Function to filter one sample
+ *
+ *  \param[in] f filter
+ *  \param[in] x new sample
+ *
+ *  \returns filter output
+ */
+q15_t dsp_filter_step(struct dsp_filter *f, q15_t x)
+{
+    return f->ops->step(f, x);
+}
+
+/** \brief Function to filter a block of samples
+ *
+ *  \param[in] f filter
+ *  \param[in] in samples
+ *  \param[out] out filter output of each sample (can be the same array as in)
+ *  \param[in] n number of samples
+ */
+void dsp_filter_block(struct dsp_filter *f, const q15_t *in, q15_t *out, uint32_t n)
+{
+    f->ops->block(f, in, out, n);
+}
+
+/** \brief Function to clear the state of a filter (as after init) */
+void dsp_filter_reset(struct dsp_filter *f)
+{
+    f->ops->reset(f);
+}
+
+/** \brief Function to get the type of a filter */
+enum dsp_filter_type dsp_filter_type_get(const struct dsp_filter *f)
+{
+    return f->ops->type;
+}
@@ -0,0 +1,324 @@
+/** \file outlier_filter.c
+ * 	\brief Module implementing an incremental outlier-rejecting moving average
+ *
+ *  The window is a ring of treap nodes: node i holds sample i, so the oldest sample is
+ * removed from the tree and its node is reused for the new one. Nodes are ordered by
+ * (value, index) to make the keys unique. With the count and sum of each subtree the
+ * count and sum of the samples below a limit are found in one descent from the root.
+ *
+ *  \author André Brandão
+ *  \author Emanuel Pereira
+ *  \date 29/05/2022
+ */
+
+#include <stddef.h>
+#include <outlier_filter.h>
+
+#define NIL 0xFFFF /**< Empty subtree */
+
+/** \brief Function to get the number of samples of a subtree */
+static int node_cnt(const struct ofilter *f, uint16_t t)
+{
+    return t == NIL ? 0 : f->nodes[t].cnt;
+}
+
+/** \brief Function to get the sum of the samples of a subtree */
+static int64_t node_sum(const struct ofilter *f, uint16_t t)
+{
+    return t == NIL ? 0 : f->nodes[t].sum;
+}
+
+/** \brief Function to recompute the count and sum of a node from its children */
+static void node_update(struct ofilter *f, uint16_t t)
+{
+    struct ofilter_node *n = &f->nodes[t];
+
+    n->cnt = 1 + node_cnt(f, n->left) + node_cnt(f, n->right);
+    n->sum = n->val + node_sum(f, n->left) + node_sum(f, n->right);
+}
+
+/** \brief Function to compare the keys (value, index) of two nodes
+ *
+ * \returns 1 if the key of node a is lower than the key of node b
+ */
+static int node_less(const struct ofilter *f, uint16_t a, uint16_t b)
+{
+    return f->nodes[a].val < f->nodes[b].val || (f->nodes[a].val == f->nodes[b].val && a < b);
+}
+
+/** \brief Function to insert a node in a subtree
+ *
+ * \returns new root of the subtree
+ */
+static uint16_t treap_insert(struct ofilter *f, uint16_t t, uint16_t k)
+{
+    struct ofilter_node *n;
+    uint16_t c;
+
+    if(t == NIL)
+        return k;
+
+    n = &f->nodes[t];
+
+    if(node_less(f, k, t))
+    {
+        n->left = treap_insert(f, n->left, k);
+        if(f->nodes[n->left].prio > n->prio)    // Rotate right
+        {
+            c = n->left;
+            n->left = f->nodes[c].right;
+            f->nodes[c].right = t;
+            node_update(f, t);
+            node_update(f, c);
+            return c;
+        }
+    }
+    else
+    {
+        n->right = treap_insert(f, n->right, k);
+        if(f->nodes[n->right].prio > n->prio)   // Rotate left
+        {
+            c = n->right;
+            n->right = f->nodes[c].left;
+            f->nodes[c].left = t;
+            node_update(f, t);
+            node_update(f, c);
+            return c;
+        }
+    }
+
+    node_update(f, t);
+    return t;
+}
+
+/** \brief Function to join two subtrees, every key of a is lower than the keys of b
+ *
+ * \returns root of the joined subtree
+ */
+static uint16_t treap_merge(struct ofilter *f, uint16_t a, uint16_t b)
+{
+    if(a == NIL)
+        return b;
+    if(b == NIL)
+        return a;
+
+    if(f->nodes[a].prio > f->nodes[b].prio)
+    {
+        f->nodes[a].right = treap_merge(f, f->nodes[a].right, b);
+        node_update(f, a);
+        return a;
+    }
+
+    f->nodes[b].left = treap_merge(f, a, f->nodes[b].left);
+    node_update(f, b);
+    return b;
+}
+
+/** \brief Function to remove a node from a subtree
+ *
+ * \returns new root of the subtree
+ */
+static uint16_t treap_remove(struct ofilter *f, uint16_t t, uint16_t k)
+{
+    struct ofilter_node *n = &f->nodes[t];
+
+    if(t == k)
+        return treap_merge(f, n->left, n->right);
+
+    if(node_less(f, k, t))
+        n->left = treap_remove(f, n->left, k);
+    else
+        n->right = treap_remove(f, n->right, k);
+
+    node_update(f, t);
+    return t;
+}
+
+/** \brief Function to get the count and sum of the samples lower than a limit
+ *
+ * \param[in] f filter
+ * \param[in] limit upper limit (excluded)
+ * \param[out] sum sum of the samples lower than limit
+ *
+ * \returns number of samples lower than limit
+ */
+static int treap_below(const struct ofilter *f, int64_t limit, int64_t *sum)
+{
+    uint16_t t = f->root;
+    int cnt = 0;
+
+    *sum = 0;
+
+    while(t != NIL)
+    {
+        const struct ofilter_node *n = &f->nodes[t];
+
+        if(n->val < limit)
+        {
+            cnt += node_cnt(f, n->left) + 1;
+            *sum += node_sum(f, n->left) + n->val;
+            t = n->right;
+        }
+        else
+        {
+            t = n->left;
+        }
+    }
+
+    return cnt;
+}
+
+/** \brief Function to get a random priority (xorshift32) */
+static uint32_t random_prio(struct ofilter *f)
+{
+    f->seed ^= f->seed << 13;
+    f->seed ^= f->seed >> 17;
+    f->seed ^= f->seed << 5;
+
+    return f->seed;
+}
+
+/** \brief Function to initialize a filter
+ *
+ *  Fills the window with zeros (as the sample buffer of the applications).
+ *
+ *  \param[in] f filter (storage from OFILTER_DEFINE())
+ *
+ *  \returns 0 on success, -1 if the window size is invalid
+ */
+int ofilter_init(struct ofilter *f)
+{
+    if(f->size <= 0 || f->size > OFILTER_MAX_SIZE)
+        return -1;
+
+    f->root = NIL;
+    f->pos = 0;
+    f->sum = 0;
+    f->seed = 2463534242u;
+
+    for(int i = 0; i < f->size; i++)
+    {
+        f->nodes[i].val = 0;
+        f->nodes[i].prio = random_prio(f);
+        f->nodes[i].left = NIL;
+        f->nodes[i].right = NIL;
+        node_update(f, i);
+        f->root = treap_insert(f, f->root, i);
+    }
+
+    return 0;
+}
+
+/** \brief Function to add a sample to the window
+ *
+ *  Replaces the oldest sample, O(log N).
+ *
+ *  \param[in] f filter
+ *  \param[in] val new sample
+ */
+void ofilter_insert(struct ofilter *f, int val)
+{
+    uint16_t k = f->pos;
+    struct ofilter_node *n = &f->nodes[k];
+
+    f->root = treap_remove(f, f->root, k);
+    f->sum += val - n->val;
+
+    n->val = val;
+    n->left = NIL;
+    n->right = NIL;
+    node_update(f, k);
+    f->root = treap_insert(f, f->root, k);
+
+    f->pos = (f->pos + 1) % f->size;
+}
+
+/** \brief Function to add a block of samples to the window
+ *
+ *  Same window as ofilter_insert() of each sample in turn, but of a block longer than
+ * the window only the last N samples are inserted, the older ones would be replaced
+ * within the block. O(min(n, N) log N).
+ *
+ *  \param[in] f filter
+ *  \param[in] vals new samples, oldest first
+ *  \param[in] n number of samples
+ */
+void ofilter_insert_block(struct ofilter *f, const uint16_t *vals, int n)
+{
+    int skip = n > f->size ? n - f->size : 0;
+
+    f->pos = (f->pos + skip) % f->size;     // Positions of the skipped samples, overwritten below
+
+    for(int i = skip; i < n; i++)
+        ofilter_insert(f, vals[i]);
+}
+
+/** \brief Function to get the filter output
+ *
+ *  Average of the samples within [0.9, 1.1] times the window average, O(log N).
+ * The limits are computed as in the reference (truncated), see ofilter_scan().
+ *
+ *  \param[in] f filter
+ *
+ *  \returns average of the window without the outliers, 0 if every sample is an outlier
+ */
+int ofilter_output(const struct ofilter *f)
+{
+    int64_t avg, high_limit, low_limit, sum_low, sum_high;
+    int cnt;
+
+    avg = f->sum / f->size;
+    high_limit = avg * 11 / 10;
+    low_limit = avg * 9 / 10;
+
+    if(high_limit < low_limit)  // Negative average
+        return 0;
+
+    cnt = treap_below(f, high_limit + 1, &sum_high);
+    cnt -= treap_below(f, low_limit, &sum_low);
+
+    if(cnt == 0)
+        return 0;
+
+    return (sum_high - sum_low) / cnt;
+}
+
+/** \brief Reference implementation of the filter output
+ *
+ *  Full scan of the window with the algorithm of filter(), O(N). Used by the
+ * benchmark to compare with ofilter_output() (the test checks it against filter() itself).
+ *
+ *  \param[in] f filter
+ *
+ *  \returns average of the window without the outliers, 0 if every sample is an outlier
+ */
+int ofilter_scan(const struct ofilter *f)
+{
+    long long sum = 0;
+    int i, j = 0;
+    int avg, high_limit, low_limit;
+
+    for(i = 0; i < f->size; i++)
+        sum += f->nodes[i].val;
+    avg = sum / f->size;
+
+    // Outliers Calculation
+    high_limit = avg * 1.1;
+    low_limit = avg * 0.9;
+
+    sum = 0;
+    for(i = 0; i < f->size; i++)
+    {
+        if(f->nodes[i].val >= low_limit && f->nodes[i].val <= high_limit)
+        {
+            sum += f->nodes[i].val;
+            j++;
+        }
+    }
+
+    // If empty data array the average is zero
+    if(j == 0)
+        return 0;
+
+    return sum / j;
+}
@@ -0,0 +1,48 @@
+/** \file periodic_task.h
+ * 	\brief Module implementing periodic tasks released by a kernel timer
+ *
+ *  A periodic thread calls periodic_task_start() once and periodic_task_wait() at the end
+ * of each job. The releases come from a periodic k_timer, so they are at absolute instants
+ * (start + n * period) and the period does not drift with the execution time of the jobs.
+ * When a job ends after the next release (deadline miss) the releases that passed are either
+ * run back to back (PERIODIC_CATCH_UP) or dropped (PERIODIC_SKIP).
+ *  The release jitter (delay from the release instant to the start of the job) and the deadline
+ * misses of each task are recorded.
+ *
+ * \author André Brandão
+ * \author Emanuel Pereira
+ * \date 29/05/2022
+ */
+#ifndef _PERIODIC_TASK_H
+#define _PERIODIC_TASK_H
+
+#include <zephyr.h>
+
+/** What to do with the releases that passed during a job that missed its deadline */
+enum periodic_policy {
+    PERIODIC_CATCH_UP,  /**< Run one job for each release, without waiting, until back on time */
+    PERIODIC_SKIP,      /**< Drop them, the next job is at the next release */
+};
+
+/** Periodic task */
+struct periodic_task {
+    struct k_timer timer;           /**< Release timer */
+    enum periodic_policy policy;    /**< Deadline miss policy */
+    int64_t period_ticks;           /**< Period (ticks) */
+    int64_t start;                  /**< Instant of release 0 (ticks) */
+    uint64_t release;               /**< Index of the release of the current job */
+    uint32_t pending;               /**< Releases passed and not run yet (PERIODIC_CATCH_UP) */
+    uint32_t jobs;                  /**< Number of jobs */
+    uint32_t misses;                /**< Number of jobs that ended after the next release */
+    uint32_t skipped;               /**< Number of releases dropped (PERIODIC_SKIP) */
+    uint32_t jitter_us;             /**< Release jitter of the current job (us) */
+    uint32_t jitter_max_us;         /**< Peak release jitter (us) */
+    uint64_t jitter_sum_us;         /**< Sum of the release jitters (us) */
+};
+
+void periodic_task_init(struct periodic_task *t, uint32_t period_us, enum periodic_policy policy);
+void periodic_task_start(struct periodic_task *t);
+uint32_t periodic_task_wait(struct periodic_task *t);
+void periodic_task_stats_print(const struct periodic_task *t, const char *name);
+
+#endif // _PERIODIC_TASK_H
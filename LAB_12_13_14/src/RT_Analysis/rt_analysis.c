@@ -0,0 +1,136 @@
+/** \file rt_analysis.c
+ * 	\brief Module implementing fixed priority assignment and response time analysis
+ *
+ *  \author André Brandão
+ *  \author Emanuel Pereira
+ *  \date 18/06/2022
+ */
+
+#include <rt_analysis.h>
+
+/** \brief Function to get the deadline of a task (the period if not set) */
+static uint32_t deadline(const struct rt_task *t)
+{
+    return t->deadline_us ? t->deadline_us : t->period_us;
+}
+
+/** \brief Function to get the ordering key of a task */
+static uint32_t order_key(const struct rt_task *t, enum rt_order order)
+{
+    return order == RT_RATE_MONOTONIC ? t->period_us : deadline(t);
+}
+
+/** \brief Function to get the blocking time of a task
+ *
+ *  Longest critical section of the lower priority tasks, if the mutex is used by the task
+ * or by a task of higher priority (inherited by the lower priority task).
+ */
+static uint32_t blocking(const struct rt_task *tasks, int n, int i)
+{
+    uint32_t b = 0;
+    int used = 0;
+
+    for(int j = 0; j < n; j++)
+    {
+        if(tasks[j].prio <= tasks[i].prio && tasks[j].cs_us > 0)
+            used = 1;
+        else if(tasks[j].prio > tasks[i].prio && tasks[j].cs_us > b)
+            b = tasks[j].cs_us;
+    }
+
+    return used ? b : 0;
+}
+
+/** \brief Function to assign the priorities of a task set
+ *
+ *  Every task gets a different priority, from base_prio (highest) on, by increasing period
+ * or deadline. Ties keep the order of the table.
+ *
+ *  \param[in,out] tasks task table
+ *  \param[in] n number of tasks
+ *  \param[in] order rate or deadline monotonic
+ *  \param[in] base_prio priority of the first task
+ */
+void rt_assign_priorities(struct rt_task *tasks, int n, enum rt_order order, int base_prio)
+{
+    for(int i = 0; i < n; i++)
+    {
+        int rank = 0;   // Tasks before task i
+
+        for(int j = 0; j < n; j++)
+        {
+            if(order_key(&tasks[j], order) < order_key(&tasks[i], order) ||
+               (order_key(&tasks[j], order) == order_key(&tasks[i], order) && j < i))
+                rank++;
+        }
+
+        tasks[i].prio = base_prio + rank;
+    }
+}
+
+/** \brief Function to compute the worst case response times of a task set
+ *
+ *  Iterates the response time recurrence of each task from its execution and blocking
+ * time (see blocking()), the interference comes from the tasks of higher or equal priority (equal priority
+ * is counted as interference, Zephyr runs them in arrival order). The iteration stops at
+ * the fixed point or when the deadline is passed.
+ *
+ *  \param[in,out] tasks task table, with the priorities assigned
+ *  \param[in] n number of tasks
+ *
+ *  \returns number of tasks that can miss their deadline (0 if the set is schedulable)
+ */
+int rt_response_times(struct rt_task *tasks, int n)
+{
+    int misses = 0;
+
+    for(int i = 0; i < n; i++)
+    {
+        uint64_t b = blocking(tasks, n, i);
+        uint64_t r = tasks[i].wcet_us + b, prev = 0;
+
+        while(r != prev && r <= deadline(&tasks[i]))
+        {
+            prev = r;
+            r = tasks[i].wcet_us + b;
+
+            for(int j = 0; j < n; j++)
+            {
+                if(j != i && tasks[j].prio <= tasks[i].prio && tasks[j].period_us > 0)
+                    r += (prev + tasks[j].period_us - 1) / tasks[j].period_us * tasks[j].wcet_us;
+            }
+        }
+
+        if(r > deadline(&tasks[i]))
+        {
+            tasks[i].response_us = UINT32_MAX;
+            misses++;
+        }
+        else
+        {
+            tasks[i].response_us = r;
+        }
+    }
+
+    return misses;
+}
+
+/** \brief Function to get the processor utilization of a task set
+ *
+ *  \param[in] tasks task table
+ *  \param[in] n number of tasks
+ *
+ *  \returns sum of wcet / period (0.01 %)
+ */
+uint32_t rt_utilization(const struct rt_task *tasks, int n)
+{
+    uint64_t u = 0;
+
+    for(int i = 0; i < n; i++)
+    {
+        if(tasks[i].period_us > 0)
+            u += (uint64_t)tasks[i].wcet_us * 10000 / tasks[i].period_us;
+    }
+
+    return u;
+}
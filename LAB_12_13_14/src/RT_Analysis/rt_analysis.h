@@ -0,0 +1,47 @@
+/** \file rt_analysis.h
+ * 	\brief Module implementing fixed priority assignment and response time analysis
+ *
+ *  The tasks are declared in a table (period or minimum inter-arrival time, worst case
+ * execution time, deadline and longest critical section). The priorities are assigned by rate
+ * monotonic (shortest period first) or deadline monotonic (shortest deadline first) order, and
+ * the worst case response time of each task is computed with the classic recurrence
+ *
+ *      R = C + B + sum over the higher priority tasks j of ceil(R / Tj) * Cj
+ *
+ *  The blocking B models one mutex with priority inheritance shared by the tasks with a critical
+ * section: a task is blocked at most once by the longest critical section of a lower priority
+ * task, if it or a higher priority task uses the mutex (direct or push-through blocking).
+ *  The set is schedulable when every response time is within its deadline.
+ *  Priorities follow the Zephyr convention, a lower number is a higher priority.
+ *
+ * \author André Brandão
+ * \author Emanuel Pereira
+ * \date 18/06/2022
+ */
+#ifndef _RT_ANALYSIS_H
+#define _RT_ANALYSIS_H
+
+#include <stdint.h>
+
+/** Priority assignment orders */
+enum rt_order {
+    RT_RATE_MONOTONIC,      /**< Shortest period first */
+    RT_DEADLINE_MONOTONIC,  /**< Shortest deadline first */
+};
+
+/** Task of the analysis */
+struct rt_task {
+    const char *name;       /**< Task name */
+    uint32_t period_us;     /**< Period, or minimum inter-arrival time of a sporadic task (us) */
+    uint32_t wcet_us;       /**< Worst case execution time (us) */
+    uint32_t deadline_us;   /**< Relative deadline (us), 0 for the period */
+    uint32_t cs_us;         /**< Longest critical section on the shared mutex (us), 0 if not used */
+    int prio;               /**< Priority (output of rt_assign_priorities()) */
+    uint32_t response_us;   /**< Worst case response time (output of rt_response_times(), UINT32_MAX if above the deadline) */
+};
+
+void rt_assign_priorities(struct rt_task *tasks, int n, enum rt_order order, int base_prio);
+int rt_response_times(struct rt_task *tasks, int n);
+uint32_t rt_utilization(const struct rt_task *tasks, int n);
+
+#endif // _RT_ANALYSIS_H
@@ -0,0 +1,157 @@
+/** \file spsc_ring.c
+ * 	\brief Module implementing a lock-free single-producer single-consumer ring of samples
+ *
+ *  The head and tail are free running counters (the index is the counter modulo the size,
+ * so the size is a power of 2). The producer writes the sample before publishing the new
+ * head (release), the consumer reads the head (acquire) before reading the samples, and the
+ * same with the roles swapped for the tail, so neither side sees a slot the other one is using.
+ * The samples are also accessed atomically because a snapshot can read a slot while the
+ * producer writes it, as the data of a seqlock with the head as its sequence: the producer
+ * stores the sample with release, after the head of the previous put, and the snapshot loads
+ * the samples with acquire before reading the head again, so a snapshot that read an
+ * overwritten sample also reads the head of that put and discards the copy.
+ *
+ *  \author André Brandão
+ *  \author Emanuel Pereira
+ *  \date 29/05/2022
+ */
+
+#include <stddef.h>
+#include <spsc_ring.h>
+
+/** \brief Function to initialize a ring
+ *
+ *  Empties the ring, clears the counters and fills the samples with zeros (as the sample
+ * buffer of the applications), so a snapshot before the window is full has zeros.
+ *
+ *  \param[in] r ring (storage from SPSC_RING_DEFINE())
+ *
+ *  \returns 0 on success, -1 if the size is not a power of 2
+ */
+int spsc_ring_init(struct spsc_ring *r)
+{
+    if(r->size == 0 || (r->size & (r->size - 1)) != 0)
+        return -1;
+
+    for(uint32_t i = 0; i < r->size; i++)
+        r->data[i] = 0;
+
+    r->overruns = 0;
+    r->underruns = 0;
+    __atomic_store_n(&r->tail, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&r->head, 0, __ATOMIC_RELEASE);
+
+    return 0;
+}
+
+/** \brief Function to put a sample on the ring (producer only)
+ *
+ *  \param[in] r ring
+ *  \param[in] val sample
+ *
+ *  \returns 0 on success, -1 if the ring is full (the sample is dropped)
+ */
+int spsc_ring_put(struct spsc_ring *r, uint16_t val)
+{
+    uint32_t head = __atomic_load_n(&r->head, __ATOMIC_RELAXED);
+    uint32_t tail = __atomic_load_n(&r->tail, __ATOMIC_ACQUIRE);
+
+    if(head - tail >= r->size)
+    {
+        __atomic_store_n(&r->overruns, r->overruns + 1, __ATOMIC_RELAXED);
+        return -1;
+    }
+
+    __atomic_store_n(&r->data[head & (r->size - 1)], val, __ATOMIC_RELEASE);   // After the previous head (snapshot)
+    __atomic_store_n(&r->head, head + 1, __ATOMIC_RELEASE);    // Publish the sample
+
+    return 0;
+}
+
+/** \brief Function to get the oldest sample of the ring (consumer only)
+ *
+ *  \param[in] r ring
+ *  \param[out] val sample
+ *
+ *  \returns 0 on success, -1 if the ring is empty
+ */
+int spsc_ring_get(struct spsc_ring *r, uint16_t *val)
+{
+    uint32_t tail = __atomic_load_n(&r->tail, __ATOMIC_RELAXED);
+    uint32_t head = __atomic_load_n(&r->head, __ATOMIC_ACQUIRE);
+
+    if(head == tail)
+    {
+        __atomic_store_n(&r->underruns, r->underruns + 1, __ATOMIC_RELAXED);
+        return -1;
+    }
+
+    *val = r->data[tail & (r->size - 1)];
+    __atomic_store_n(&r->tail, tail + 1, __ATOMIC_RELEASE);    // Give the slot back to the producer
+
+    return 0;
+}
+
+/** \brief Function to get the number of samples on the ring
+ *
+ *  Exact for the consumer, a lower bound of the free space for the producer.
+ *
+ *  \param[in] r ring
+ *
+ *  \returns number of samples put and not got
+ */
+uint32_t spsc_ring_count(const struct spsc_ring *r)
+{
+    uint32_t tail = __atomic_load_n(&r->tail, __ATOMIC_ACQUIRE);
+    uint32_t head = __atomic_load_n(&r->head, __ATOMIC_ACQUIRE);
+
+    return head - tail;
+}
+
+/** \brief Function to copy the last samples put on the ring (consumer only)
+ *
+ *  Copies the n newest samples, got or not, oldest first. The producer may be writing
+ * over the oldest of them, so the head is read again after the copy: if the producer may
+ * have reached a slot of the window (the sample after the head is being written) the copy
+ * is torn and is done again.
+ *
+ *  \param[in] r ring
+ *  \param[out] window samples (n)
+ *  \param[in] n number of samples, lower than the ring size
+ *
+ *  \returns 0 on success, -1 if n is too big or the copy was torn SPSC_RING_SNAPSHOT_RETRIES times
+ */
+int spsc_ring_snapshot(struct spsc_ring *r, uint16_t *window, uint32_t n)
+{
+    uint32_t first, head;
+
+    if(n >= r->size)
+        return -1;
+
+    for(int retry = 0; retry < SPSC_RING_SNAPSHOT_RETRIES; retry++)
+    {
+        first = __atomic_load_n(&r->head, __ATOMIC_ACQUIRE) - n;
+
+        for(uint32_t i = 0; i < n; i++)
+            window[i] = __atomic_load_n(&r->data[(first + i) & (r->size - 1)], __ATOMIC_ACQUIRE);   // May race the producer
+
+        head = __atomic_load_n(&r->head, __ATOMIC_RELAXED);    // After the copy (acquire loads)
+
+        if(head - first < r->size)      // No slot of the window was written again
+            return 0;
+    }
+
+    return -1;
+}
+
+/** \brief Function to get the number of samples dropped because the ring was full */
+uint32_t spsc_ring_overruns_get(const struct spsc_ring *r)
+{
+    return __atomic_load_n(&r->overruns, __ATOMIC_RELAXED);
+}
+
+/** \brief Function to get the number of gets on an empty ring */
+uint32_t spsc_ring_underruns_get(const struct spsc_ring *r)
+{
+    return __atomic_load_n(&r->underruns, __ATOMIC_RELAXED);
+}
@@ -0,0 +1,106 @@
+/** \file task_stats.c
+ * 	\brief Module implementing timing statistics of the threads
+ *
+ *  Each metric is written by one thread only. The dump reads it without locking, so a line
+ * printed during an update may mix the value being added (it is a diagnostic).
+ *
+ *  \author André Brandão
+ *  \author Emanuel Pereira
+ *  \date 18/06/2022
+ */
+
+#include <task_stats.h>
+#include <sys/printk.h>
+
+/** \brief Function to clear a metric
+ *
+ *  \param[out] m metric
+ */
+void tstats_reset(struct tstats_metric *m)
+{
+    m->count = 0;
+    m->min = UINT32_MAX;
+    m->max = 0;
+    m->sum = 0;
+
+    for(int i = 0; i < TSTATS_BINS; i++)
+        m->hist[i] = 0;
+}
+
+/** \brief Function to add a value to a metric
+ *
+ *  \param[in] m metric
+ *  \param[in] us value (us)
+ */
+void tstats_add(struct tstats_metric *m, uint32_t us)
+{
+    int bin = 0;
+
+    if(m->count == 0)
+        m->min = UINT32_MAX;    // Zero filled (static) metric
+
+    m->count++;
+    m->sum += us;
+    if(us < m->min)
+        m->min = us;
+    if(us > m->max)
+        m->max = us;
+
+    while(us != 0 && bin < TSTATS_BINS - 1)  // Bin of the most significant bit
+    {
+        us >>= 1;
+        bin++;
+    }
+    m->hist[bin]++;
+}
+
+/** \brief Function to get the time between two timing counter values
+ *
+ *  \param[in] start first value (timing_counter_get())
+ *  \param[in] end last value
+ *
+ *  \returns time (us), saturated to UINT32_MAX
+ */
+uint32_t tstats_elapsed_us(timing_t start, timing_t end)
+{
+    uint64_t us = timing_cycles_to_ns(timing_cycles_get(&start, &end)) / 1000;
+
+    return us > UINT32_MAX ? UINT32_MAX : us;
+}
+
+/** \brief Function to print a metric
+ *
+ *  Prints min/avg/max and the non empty histogram bins (lower limit: count).
+ *
+ *  \param[in] m metric
+ *  \param[in] name metric name
+ */
+void tstats_print(const struct tstats_metric *m, const char *name)
+{
+    if(m->count == 0)
+    {
+        printk("  %s: no data\n", name);
+        return;
+    }
+
+    printk("  %s (us): n = %u, min = %u, avg = %u, max = %u\n    hist:",
+           name, m->count, m->min, (uint32_t)(m->sum / m->count), m->max);
+
+    for(int i = 0; i < TSTATS_BINS; i++)
+    {
+        if(m->hist[i])
+            printk(" %s%u: %u", i == TSTATS_BINS - 1 ? ">=" : "", i ? 1u << (i - 1) : 0, m->hist[i]);
+    }
+    printk("\n");
+}
+
+/** \brief Function to print the timing statistics of a thread
+ *
+ *  \param[in] t thread statistics
+ */
+void task_stats_print(const struct task_stats *t)
+{
+    printk("%s\n", t->name);
+    tstats_print(&t->exec, "execution time");
+    tstats_print(&t->jitter, "release jitter");
+}
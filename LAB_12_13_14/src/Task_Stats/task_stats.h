@@ -0,0 +1,43 @@
+/** \file task_stats.h
+ * 	\brief Module implementing timing statistics of the threads
+ *
+ *  Each metric (execution time, release jitter, latency...) keeps the number of values,
+ * min, average, max and a histogram of power of 2 bins, in a fixed size structure: a
+ * thread adds one value per activation and the values are not stored.
+ *  The times are measured with the timing functions (CONFIG_TIMING_FUNCTIONS).
+ *
+ * \author André Brandão
+ * \author Emanuel Pereira
+ * \date 18/06/2022
+ */
+#ifndef _TASK_STATS_H
+#define _TASK_STATS_H
+
+#include <zephyr.h>
+#include <timing/timing.h>
+
+#define TSTATS_BINS 22 /**< Histogram bins: bin 0 counts 0 us, bin k [2^(k-1), 2^k) us, the last one also the bigger values */
+
+/** Statistics of a metric (us) */
+struct tstats_metric {
+    uint32_t count;             /**< Number of values */
+    uint32_t min;               /**< Lowest value */
+    uint32_t max;               /**< Highest value */
+    uint64_t sum;               /**< Sum of the values */
+    uint32_t hist[TSTATS_BINS]; /**< Histogram */
+};
+
+/** Timing statistics of a thread */
+struct task_stats {
+    const char *name;               /**< Thread name */
+    struct tstats_metric exec;      /**< Execution time of each activation */
+    struct tstats_metric jitter;    /**< Delay from the release to the start of each activation */
+};
+
+void tstats_reset(struct tstats_metric *m);
+void tstats_add(struct tstats_metric *m, uint32_t us);
+uint32_t tstats_elapsed_us(timing_t start, timing_t end);
+void tstats_print(const struct tstats_metric *m, const char *name);
+void task_stats_print(const struct task_stats *t);
+
+#endif // _TASK_STATS_H
@@ -9,7 +9,8 @@
  * that sets the time (week day, hour and minute) and light intensity in the memory. To implement this function the
  * system as thread that implements a calendar (week da, hours and minutes). The modes of operation can be set by
  * the board buttons, button 1 sets the Automatic  mode and button 2 the manual mode.
- *  It was implemented recuuring to threads, shared-memory and semaphores.
+ *  It was implemented recuuring to threads, shared-memory and semaphores. The samples go from the sampling
+ * to the processing thread through a lock-free single-producer single-consumer ring.
  *  It was implemented using the board Nordic nrf52840-dk.
  * 
  *  \author André Brandão
@@ -31,14 +32,29 @@
 
 #include <ADC.h>
 #include <PI_controller.h>
+#include <outlier_filter.h>
+#include <dsp_filter.h>
+#include <spsc_ring.h>
+#include <periodic_task.h>
+#include <task_stats.h>
+#include <rt_analysis.h>
 
 #define SAMP_PERIOD_MS  250    /**< Sample period (ms) */
 #define TIMER_PERIOD_MS 60000  /**< Calendar Timer thread period (ms) - 1 minute */
+#define SAMP_POLICY PERIODIC_SKIP       /**< Releases of the sampling thread missed by a late sample are dropped */
+#define TIMER_POLICY PERIODIC_CATCH_UP  /**< Every minute is counted by the calendar, even if late */
 
 #define MANUAL 0    /**< Flag that indicates Manual mode is selected */ 
 #define AUTOMATIC 1 /**< Flag that indicates Automatic mode is selected */ 
 
 #define FILTER_SIZE 10  /**< Window Size of samples (digital filter) */
+#define RING_SIZE 16    /**< Size of the sample ring (power of 2, bigger than FILTER_SIZE) */
+#define FILTER_INCREMENTAL 1 /**< 1 to filter with the O(log FILTER_SIZE) outlier filter, 0 with filter() */
+#define DSP_FILTER 0 /**< 0 for the outlier filter, or the DSP filter type (DSP_MEDIAN, DSP_EMA, DSP_FIR, DSP_BIQUAD_Q15, DSP_BIQUAD_Q31) */
+
+#define DSP_MEDIAN_SIZE 9   /**< Window of the median filter */
+#define DSP_EMA_ALPHA 4096  /**< Weight of the new sample of the EMA filter (Q15, 1/8) */
+#define DSP_FIR_TAPS 8      /**< Taps of the FIR filter */
 #define MEM_SIZE 10     /**< Schedule Memory Size */
 
 #define STACK_SIZE 1024 /**< Size of stack area used by each thread */
@@ -49,11 +65,12 @@
 #define BOARDBUT3 0x18  /**< Address of Board button 3 used to increase light intensity on manual mode */
 #define BOARDBUT4 0x19  /**< Address of Board button 4 used to decrease light intensity on manual mode */
 
-#define thread_sampling_prio 2      /**< Scheduling priority of sampling thread */
-#define thread_processing_prio 2    /**< Scheduling priority of processing thread */
-#define thread_actuation_prio 2     /**< Scheduling priority of actuation thread */
-#define thread_calendarTimer_prio 3 /**< Scheduling priority of calendar timer thread */
-#define thread_interface_prio 1     /**< Scheduling priority of interface thread */
+/* Thread scheduling, the priorities are assigned from the task table (rt_tasks) */
+#define RT_ORDER RT_RATE_MONOTONIC  /**< Priority assignment order (RT_RATE_MONOTONIC or RT_DEADLINE_MONOTONIC) */
+#define RT_BASE_PRIO 1              /**< Priority of the highest priority thread */
+#define RT_STRICT 1                 /**< 1 to not start the threads if the task set is unschedulable, 0 to only warn */
+#define INTERFACE_PERIOD_MS 1000    /**< Minimum time between two user commands (ms) */
+#define CALENDAR_CS_US 2000         /**< Longest critical section on the calendar (print of the system time) */
 
 #define GPIO0_NID DT_NODELABEL(gpio0)   /**< gpio0 Node Label from device tree (refer to dts file) */
 #define PWM0_NID DT_NODELABEL(pwm0)     /**< pwm0 Node Label from device tree (refer to dts file) */
@@ -80,11 +97,12 @@ k_tid_t thread_interface_tid;       /**< Interface thread task ID */
 
 static struct gpio_callback button_cb_data; /**< Buttons callback structures */
 
-/** Circular array to store data */
-typedef struct {
-    int data[FILTER_SIZE];  /**< Array to store data*/
-    int head;   /**< Index of next position to store data */   
-}buffer;
+/* DSP filters parameters and storage */
+static const q15_t dsp_fir_taps[DSP_FIR_TAPS] = {4096, 4096, 4096, 4096, 4096, 4096, 4096, 4096};   /**< Moving average of 8 samples */
+static const q15_t dsp_biquad_q15[DSP_BIQUAD_Q15_COEFFS_SIZE(1)] = {329, 0, 658, 329, 25576, -10508}; /**< Butterworth low-pass, fc = 0.05 fs, post shift 1 */
+static const q31_t dsp_biquad_q31[DSP_BIQUAD_Q31_COEFFS_SIZE(1)] = {21564350, 43128699, 21564350, 1676130396, -688645970}; /**< Same low-pass, Q31 */
+static q15_t dsp_buf[DSP_MEDIAN_BUF_SIZE(DSP_MEDIAN_SIZE) + DSP_FIR_STATE_SIZE(DSP_FIR_TAPS)];    /**< Median window or FIR state */
+static q31_t dsp_state[DSP_BIQUAD_STATE_SIZE(1)];  /**< Biquad state */
 
 /** Memory struct to store user data */
 typedef struct {
@@ -103,7 +121,7 @@ typedef struct {
 
 
 // Global variables (shared memory) to communicate between tasks
-buffer sample_buffer;   /**< Buffer to store samples to communicate between tasks*/ 
+SPSC_RING_DEFINE(sample_ring, RING_SIZE);   /**< Ring to pass the samples to the processing task */
 
 int mode = MANUAL;  /**< System operation mode (MANUAL or AUTOMATIC) */
 int intensity = 0;  /**< Light intensity */ 
@@ -114,14 +132,54 @@ int mem_idx;    /**< Memory index to store data */
 
 Calendar calendar;  /**< Calendar */
 
+struct periodic_task sampling_task; /**< Releases of the sampling thread */
+struct periodic_task calendar_task; /**< Releases of the calendar timer thread */
+
+/* Timing statistics of the threads */
+struct task_stats sampling_stats = { .name = "sampling" };          /**< Timing statistics of the sampling thread */
+struct task_stats processing_stats = { .name = "processing" };      /**< Timing statistics of the processing thread */
+struct task_stats actuation_stats = { .name = "actuation" };        /**< Timing statistics of the actuation thread */
+struct task_stats calendar_stats = { .name = "calendar timer" };    /**< Timing statistics of the calendar timer thread */
+struct task_stats interface_stats = { .name = "interface" };        /**< Timing statistics of the interface thread */
+struct tstats_metric e2e_latency;   /**< Latency from the adc sample to the PWM update */
+
+/** Tasks of the schedulability analysis */
+enum {
+    TASK_SAMPLING,      /**< Sampling thread */
+    TASK_PROCESSING,    /**< Processing thread */
+    TASK_ACTUATION,     /**< Actuation thread */
+    TASK_CALENDAR,      /**< Calendar timer thread */
+    TASK_INTERFACE,     /**< Interface thread */
+    TASK_COUNT          /**< Number of tasks */
+};
+
+/** Task table: period or minimum inter-arrival time, WCET, deadline (0, the period) and critical section (us) */
+struct rt_task rt_tasks[TASK_COUNT] = {
+    [TASK_SAMPLING]     = { "sampling", SAMP_PERIOD_MS * 1000, 300, 0, 0 },
+    [TASK_PROCESSING]   = { "processing", SAMP_PERIOD_MS * 1000, 1000, 0, 100 },    // Sporadic, one run per sample
+    [TASK_ACTUATION]    = { "actuation", SAMP_PERIOD_MS * 1000, 200, 0, 0 },        // Sporadic, one run per processing
+    [TASK_CALENDAR]     = { "calendar timer", TIMER_PERIOD_MS * 1000, 3000, 0, 100 },
+    [TASK_INTERFACE]    = { "interface", INTERFACE_PERIOD_MS * 1000, 5000, 0, CALENDAR_CS_US },  // Sporadic, user commands
+};
+
+/** Measured execution time of each task of rt_tasks (the interface one includes the user typing, not used) */
+static struct tstats_metric *const rt_measured[TASK_COUNT] = {
+    &sampling_stats.exec, &processing_stats.exec, &actuation_stats.exec, &calendar_stats.exec, NULL
+};
+
+timing_t sample_stamp[RING_SIZE];   /**< Instant of each sample of the ring (slot of the sample) */
+timing_t act_release;   /**< Instant the processing thread triggered the actuation */
+timing_t act_sample;    /**< Instant of the newest sample of the dutycycle to apply */
+int act_from_processing;    /**< Set when the actuation is triggered by the processing thread */
+
 /** Data to print week days - index 0 -> Sunday .... index 6 -> Saturday */
 static char *week_days[7] = {"Domingo", "Segunda-feira", "Terça-feira", "Quarta-Feira", "Quinta-Feira",
                              "Sexta-Feira", "Sábado"};
 
 // Semaphores for task synch
-struct k_sem sem_adc;   /**< Semaphore to synch sample and actuation tasks (signals end of sampling)*/
 struct k_sem sem_act;   /**< Semaphore to trigger actuation thread */
-struct k_sem sem_mut;   /**< Semaphore to mutual exclusion on calendar */
+struct k_poll_signal sig_sample;    /**< Signal of a new sample on the ring, to trigger processing thread */
+struct k_mutex mut_calendar;    /**< Mutex (priority inheritance) to mutual exclusion on calendar */
 
 // Thread code prototypes
 void thread_sampling(void *argA, void *argB, void *argC);
@@ -132,7 +190,9 @@ void thread_interface(void *argA, void *argB, void *argC);
 
 // Functions prototypes
 int read_int();
+int rta_check(int, int);
 int filter(int*);
+int dsp_config(struct dsp_filter*, enum dsp_filter_type);
 void array_init(int*, int);
 int array_average(int*, int);
 void input_output_config(void);
@@ -189,32 +249,45 @@ void buttons_cbfunction(const struct device *dev, struct gpio_callback *cb, uint
 void main(void)
 {
     input_output_config();  // config input-output pins 
+
+    timing_init();  // Timing statistics of the threads
+    timing_start();
     
     // Create and init semaphores
-    k_sem_init(&sem_adc, 0, 1);
     k_sem_init(&sem_act, 0, 1);
-    k_sem_init(&sem_mut, 1, 1); // semaphore to implement mutual exclusion
+    k_poll_signal_init(&sig_sample);
+    k_mutex_init(&mut_calendar);    // mutex to implement mutual exclusion
+
+    spsc_ring_init(&sample_ring);   // Empty sample ring
+
+    // Assign the priorities and check the schedulability of the declared WCETs
+    rt_assign_priorities(rt_tasks, TASK_COUNT, RT_ORDER, RT_BASE_PRIO);
+    if(rta_check(0, 1) != 0 && RT_STRICT)
+    {
+        printk("\nTask set unschedulable, threads not started\n");
+        return;
+    }
 
     // Create tasks
     thread_sampling_tid = k_thread_create(&thread_sampling_data, thread_sampling_stack,
         K_THREAD_STACK_SIZEOF(thread_sampling_stack), thread_sampling,
-        NULL, NULL, NULL, thread_sampling_prio, 0, K_NO_WAIT);
+        NULL, NULL, NULL, rt_tasks[TASK_SAMPLING].prio, 0, K_NO_WAIT);
 
-    thread_sampling_tid = k_thread_create(&thread_processing_data, thread_processing_stack,
+    thread_processing_tid = k_thread_create(&thread_processing_data, thread_processing_stack,
         K_THREAD_STACK_SIZEOF(thread_processing_stack), thread_processing,
-        NULL, NULL, NULL, thread_processing_prio, 0, K_NO_WAIT);
+        NULL, NULL, NULL, rt_tasks[TASK_PROCESSING].prio, 0, K_NO_WAIT);
 
     thread_actuation_tid = k_thread_create(&thread_actuation_data, thread_actuation_stack,
         K_THREAD_STACK_SIZEOF(thread_actuation_stack), thread_actuation,
-        NULL, NULL, NULL, thread_actuation_prio, 0, K_NO_WAIT);
+        NULL, NULL, NULL, rt_tasks[TASK_ACTUATION].prio, 0, K_NO_WAIT);
 
     thread_calendarTimer_tid = k_thread_create(&thread_calendarTimer_data, thread_calendarTimer_stack,
         K_THREAD_STACK_SIZEOF(thread_calendarTimer_stack), thread_calendarTimer,
-        NULL, NULL, NULL, thread_calendarTimer_prio, 0, K_NO_WAIT);
+        NULL, NULL, NULL, rt_tasks[TASK_CALENDAR].prio, 0, K_NO_WAIT);
     
     thread_interface_tid = k_thread_create(&thread_interface_data, thread_interface_stack,
         K_THREAD_STACK_SIZEOF(thread_interface_stack), thread_interface,
-        NULL, NULL, NULL, thread_interface_prio, 0, K_NO_WAIT);
+        NULL, NULL, NULL, rt_tasks[TASK_INTERFACE].prio, 0, K_NO_WAIT);
 
     return;
 }
@@ -222,41 +295,44 @@ void main(void)
 /** \brief Sampling thread
  *  
  *  This thread implements the sampling task which only operates in Automatic mode.
- * It's a periodic thread that reads the adc with period SAMP_PERIOD_MS and stores it in the sample buffer.
- * After sampling triggers the processing task.
+ * It's a periodic thread (sampling_task) that reads the adc with period SAMP_PERIOD_MS and puts it on the sample ring.
+ * After sampling signals the processing task (sig_sample). The instant of each sample is kept with it (sample_stamp) to
+ * measure the latency up to the PWM update.
  * 
  * \pre adc_sample()
  * 
  * \see SAMP_PERIOD_MS
+ * \see SAMP_POLICY
  */
 void thread_sampling(void *argA , void *argB, void *argC)
 {
-    /* Timing variables to control task periodicity */
-    int64_t fin_time=0, release_time=0;
-    
+    timing_t start;
+    uint32_t seq = 0;   // Number of samples put on the ring
+
     adc_config();   // Configure adc
     
-    /* Compute next release instant */
-    release_time = k_uptime_get() + SAMP_PERIOD_MS;
+    periodic_task_init(&sampling_task, SAMP_PERIOD_MS * 1000, SAMP_POLICY);
+    periodic_task_start(&sampling_task);    // First release now
 
     while(1)
     {
+        start = timing_counter_get();
+
         if(mode == AUTOMATIC)
         {
-            sample_buffer.data[sample_buffer.head] = adc_sample();  // Get adc sample and store it in sample buffer
+            if(spsc_ring_count(&sample_ring) < RING_SIZE)
+                sample_stamp[seq % RING_SIZE] = start;  // Free slot, the put does not fail
 
-            sample_buffer.head = (sample_buffer.head + 1) % FILTER_SIZE;   // Increment position to store data
+            if(spsc_ring_put(&sample_ring, adc_sample()) == 0)  // Get adc sample, dropped and counted if the ring is full
+                seq++;
 
-            k_sem_give(&sem_adc);    // Signal new sample
+            k_poll_signal_raise(&sig_sample, 0);    // Signal new sample, kept until the processing resets it
         }
+
+        tstats_add(&sampling_stats.exec, tstats_elapsed_us(start, timing_counter_get()));
+        tstats_add(&sampling_stats.jitter, sampling_task.jitter_us);
         
-        /* Wait for next release instant */ 
-        fin_time = k_uptime_get();
-        if(fin_time < release_time)
-        {
-            k_msleep(release_time - fin_time);
-            release_time += SAMP_PERIOD_MS;
-        }
+        periodic_task_wait(&sampling_task);    // Wait for next release instant
     }
 }
 
@@ -264,24 +340,71 @@ void thread_sampling(void *argA , void *argB, void *argC)
  *  
  *  This thread implements the task of processing.
  * It filters the data samples and updates the average of the filtered data samples.
- * It's a sporadic thread triggered by the end of sampling (sampling thread) and as
- * such only operates on Automatic mode. After processing triggers the actuation task.
+ * It's a sporadic thread woken by the end of sampling (sampling thread) and as
+ * such only operates on Automatic mode. It gets every sample put on the ring since its last
+ * run. The signal is reset before the ring is read, so a sample put meanwhile is either read
+ * now or raises the signal again (no lost wakeup). If no sample arrives within two sample periods on Automatic mode the empty get is counted
+ * as an underrun. After processing triggers the actuation task.
  * 
  * \see filter(uint16_t *data)
+ * \see FILTER_INCREMENTAL
+ * \see DSP_FILTER
  * 
  */
 void thread_processing(void *argA , void *argB, void *argC)
 {
     int data=0; // filtered data
     int intensity_real=0;   // real light intensity
+    OFILTER_DEFINE(window, FILTER_SIZE);    // Window of samples of the incremental filter
+    uint16_t sample;
+    uint32_t n, got;
+    uint32_t seq = 0;   // Number of samples got from the ring
+    timing_t start, release = 0, newest = 0;
+#if !FILTER_INCREMENTAL
+    uint16_t samples[FILTER_SIZE];  // Last samples
+    int window_data[FILTER_SIZE];
+#endif
+    struct dsp_filter dsp;
+    int use_dsp;
+    struct k_poll_event event = K_POLL_EVENT_INITIALIZER(K_POLL_TYPE_SIGNAL, K_POLL_MODE_NOTIFY_ONLY, &sig_sample);
     
     PI_init(0.5, 0.5);    // PI controller initialization
+    ofilter_init(&window);
+    use_dsp = (dsp_config(&dsp, DSP_FILTER) == 0);  // Fails for 0, outlier filter
 
     while(1)
     {
-        k_sem_take(&sem_adc, K_FOREVER);    // Wait for new sample
-        
-        k_sem_take(&sem_mut, K_FOREVER);    // Mutual exclusion on calendar operations
+        if(spsc_ring_count(&sample_ring) == 0)
+            k_poll(&event, 1, mode == AUTOMATIC ? K_MSEC(2 * SAMP_PERIOD_MS) : K_FOREVER);    // Wait for new sample
+        k_poll_signal_reset(&sig_sample);   // Samples put from now on raise it again
+        event.state = K_POLL_STATE_NOT_READY;
+
+        start = timing_counter_get();   // Filtering included in the execution time
+        n = spsc_ring_count(&sample_ring);
+        got = 0;
+        do
+        {
+            if(spsc_ring_get(&sample_ring, &sample) != 0)
+                break;  // Woken by the timeout, no sample
+            got++;
+
+            newest = sample_stamp[seq % RING_SIZE];
+            if(got == 1)
+                release = newest;   // The first sample woke the thread
+            seq++;
+
+            if(use_dsp)
+                data = dsp_filter_step(&dsp, sample);   // Filter data, every sample in order
+#if FILTER_INCREMENTAL
+            else
+                ofilter_insert(&window, sample);
+#endif
+        } while(got < n);
+
+        if(got == 0)
+            continue;
+
+        k_mutex_lock(&mut_calendar, K_FOREVER);    // Mutual exclusion on calendar operations
 
         // Check if it's time to change the light intensity based on the user data memory
         for(unsigned int i=0; i < mem_idx; i++)
@@ -292,13 +415,32 @@ void thread_processing(void *argA , void *argB, void *argC)
             }
         }
 
-        k_sem_give(&sem_mut);   // Get out of critical section
+        k_mutex_unlock(&mut_calendar);  // Get out of critical section
 
-        data = filter(sample_buffer.data);   // Filter data
+        if(!use_dsp)
+        {
+#if FILTER_INCREMENTAL
+            data = ofilter_output(&window); // Filter data
+#else
+            if(spsc_ring_snapshot(&sample_ring, samples, FILTER_SIZE) == 0)
+            {
+                for(int i = 0; i < FILTER_SIZE; i++)
+                    window_data[i] = samples[i];
+                data = filter(window_data);   // Filter data
+            }
+#endif
+        }
     
         intensity_real = (data - 250)*100 / 350; // Compute the real light intensity
         
         dutycycle = PI_controller(intensity, intensity_real, dutycycle);    // PI controller algorithm
+
+        act_sample = newest;
+        act_release = timing_counter_get();
+        act_from_processing = 1;
+
+        tstats_add(&processing_stats.exec, tstats_elapsed_us(start, act_release));
+        tstats_add(&processing_stats.jitter, tstats_elapsed_us(release, start));
         
         k_sem_give(&sem_act);   // Trigger actuation thread to update PWM dutycycle
     }
@@ -313,6 +455,8 @@ void thread_processing(void *argA , void *argB, void *argC)
  * value (when on Manual mode) or from the dutycycle value (when on Automatic mode).
  * It's a sporadic thread triggered by the press of button 3 or button 4 or by the
  * end of processing (processing thread), based on the operation mode.
+ *  When triggered by the processing thread the release jitter and the latency from the
+ * sample to the PWM update are measured.
  */
 void thread_actuation(void *argA , void *argB, void *argC)
 {
@@ -320,12 +464,14 @@ void thread_actuation(void *argA , void *argB, void *argC)
     unsigned int pwmPeriod_us = 1000;       /* PWM period in us */
     
     int ton = 0;
+    timing_t start, end;
 
     pwm0_dev = device_get_binding(DT_LABEL(PWM0_NID));
         
     while(1)
     {
         k_sem_take(&sem_act, K_FOREVER);   // Wait for actuation trigger
+        start = timing_counter_get();
 
         /* Compute ton of PWM based on operation mode 
         considering that the OUTPUT pin is on negative logic */
@@ -336,25 +482,37 @@ void thread_actuation(void *argA , void *argB, void *argC)
             ton = pwmPeriod_us - (dutycycle*pwmPeriod_us)/100;
 
         pwm_pin_set_usec(pwm0_dev, PWM_PIN, pwmPeriod_us, ton, PWM_POLARITY_NORMAL);   // Update PWM
+
+        end = timing_counter_get();
+        tstats_add(&actuation_stats.exec, tstats_elapsed_us(start, end));
+        if(act_from_processing)
+        {
+            act_from_processing = 0;
+            tstats_add(&actuation_stats.jitter, tstats_elapsed_us(act_release, start));
+            tstats_add(&e2e_latency, tstats_elapsed_us(act_sample, end));
+        }
     }
 }
 
 /** \brief Calendar Timer thread to implement a calendar 
  *  
- *  This thread is a periodic thread with period 1 minute (TIMER_PERIOD_MS),
+ *  This thread is a periodic thread (calendar_task) with period 1 minute (TIMER_PERIOD_MS),
  * to update the day, hour and minutes
+ *
+ * \see TIMER_POLICY
  */
 void thread_calendarTimer(void *argA, void *argB, void *argC){
 
-    /* Timing variables to control task periodicity */
-    int64_t fin_time=0, release_time=0;
-    
-    /* Compute next release instant */
-    release_time = k_uptime_get() + TIMER_PERIOD_MS;
+    timing_t start;
+
+    periodic_task_init(&calendar_task, TIMER_PERIOD_MS * 1000, TIMER_POLICY);
+    periodic_task_start(&calendar_task);    // First release now, the next ones every minute
 
     while(1)
     { 
-        k_sem_take(&sem_mut, K_FOREVER); // Mutual exclusion on calendar operations
+        start = timing_counter_get();
+
+        k_mutex_lock(&mut_calendar, K_FOREVER); // Mutual exclusion on calendar operations
 
         // increase minutes
         calendar.minute++;
@@ -374,18 +532,18 @@ void thread_calendarTimer(void *argA, void *argB, void *argC){
             calendar.day = (calendar.day + 1) % 7;
         }
         
-        k_sem_give(&sem_mut);   // Get out of critical section
+        k_mutex_unlock(&mut_calendar);  // Get out of critical section
 
         // print day and time in HH : MM format
         printk("\nDAY = %s , %02d h : %02d min ", week_days[calendar.day], calendar.hour, calendar.minute);
+
+        if(rta_check(1, 0) != 0)    // Check the schedulability with the measured WCETs
+            printk("\nWARNING: task set unschedulable with the measured WCETs (command 7)\n");
+
+        tstats_add(&calendar_stats.exec, tstats_elapsed_us(start, timing_counter_get()));
+        tstats_add(&calendar_stats.jitter, calendar_task.jitter_us);
               
-        /* Wait for next release instant */ 
-        fin_time = k_uptime_get();
-        if(fin_time < release_time)
-        {
-            k_msleep(release_time - fin_time);
-            release_time += TIMER_PERIOD_MS;
-        }
+        periodic_task_wait(&calendar_task);    // Wait for next release instant
   }
 
 }
@@ -393,12 +551,16 @@ void thread_calendarTimer(void *argA, void *argB, void *argC){
 /** \brief Thread to implement the user interface 
  *
  * This thread implements the user interface, let's the user add new schedules
- * configurations, check them and change the current date and hour.
+ * configurations, check them and change the current date and hour. It also dumps
+ * the timing statistics of the threads (the execution time of a command includes
+ * the user typing).
  *
  */
 void thread_interface(void *argA , void *argB, void *argC)
 {    
     char command;
+    timing_t start;
+    Calendar new_date;
 
     console_init();
     
@@ -406,11 +568,15 @@ void thread_interface(void *argA , void *argB, void *argC)
     printk("\nPress 2 to check schedules");
     printk("\nPress 3 to change current date and hour");
     printk("\nPress 4 to check system time");
+    printk("\nPress 5 to check periodic tasks statistics");
+    printk("\nPress 6 to check threads timing statistics");
+    printk("\nPress 7 to check the schedulability with the measured WCETs");
 
     while(1)
     {
         printk("\n\rcommand: ");
         command = console_getchar();    // Get user command
+        start = timing_counter_get();
 
         switch(command)
         {
@@ -442,31 +608,98 @@ void thread_interface(void *argA , void *argB, void *argC)
                 break;
 
             case '3':   // Update Date and Hour
-                k_sem_take(&sem_mut, K_FOREVER);    // Mutual exclusion on calendar operations
-                
                 printk("\nSetting New DATE");
                 printk("\nWeek Day: ");
-		        calendar.day = read_int();  // Get Week day
+		        new_date.day = read_int();  // Get Week day
                 
                 printk("\nHour: ");
-		        calendar.hour = read_int(); // Get Hour
+		        new_date.hour = read_int(); // Get Hour
 
 		        printf("\nMinute: ");
-		        calendar.minute = read_int();   // Get Minute 
+		        new_date.minute = read_int();   // Get Minute 
                 
-                k_sem_give(&sem_mut);   // Get out of critical section
+                k_mutex_lock(&mut_calendar, K_FOREVER);    // Mutual exclusion on calendar operations, not held while typing
+                calendar = new_date;
+                k_mutex_unlock(&mut_calendar);  // Get out of critical section
                 break;
             case '4':   // print system day and time in HH : MM format
-                k_sem_take(&sem_mut, K_FOREVER);    // Mutual exclusion on calendar operations
+                k_mutex_lock(&mut_calendar, K_FOREVER);    // Mutual exclusion on calendar operations
                 printk("\nSystem Time");
                 printk("\nDAY = %s , %02d h : %02d min ", week_days[calendar.day], calendar.hour, calendar.minute);
-                k_sem_give(&sem_mut);   // Get out of critical section
+                k_mutex_unlock(&mut_calendar);  // Get out of critical section
+
+                break;
+            case '5':   // Print jitter and deadline misses of the periodic threads
+                printk("\n");
+                periodic_task_stats_print(&sampling_task, "sampling");
+                periodic_task_stats_print(&calendar_task, "calendar timer");
+
+                break;
+            case '6':   // Print execution time, release jitter and latency of the threads
+                printk("\n");
+                task_stats_print(&sampling_stats);
+                task_stats_print(&processing_stats);
+                task_stats_print(&actuation_stats);
+                task_stats_print(&calendar_stats);
+                task_stats_print(&interface_stats);
+                tstats_print(&e2e_latency, "sample to PWM latency");
+
+                break;
+            case '7':   // Print the response time analysis with the measured WCETs
+                rta_check(1, 1);
 
                 break;
             default:
                 break;
         }
+
+        tstats_add(&interface_stats.exec, tstats_elapsed_us(start, timing_counter_get()));
+    }
+}
+
+/** \brief Function to check the schedulability of the threads
+ *
+ *  Runs the response time analysis of the task table, with the declared WCETs or with the
+ * highest of the declared and measured execution times (the measured ones include the blocking
+ * and preemptions, so it is pessimistic).
+ *
+ * \param[in] measured 1 to use the measured execution times
+ * \param[in] verbose 1 to print the analysis
+ *
+ * \returns number of tasks that can miss their deadline (0 if schedulable)
+ */
+int rta_check(int measured, int verbose)
+{
+    struct rt_task tasks[TASK_COUNT];
+    int misses;
+    uint32_t u;
+
+    for(int i = 0; i < TASK_COUNT; i++)
+    {
+        tasks[i] = rt_tasks[i];
+        if(measured && rt_measured[i] && rt_measured[i]->count > 0 && rt_measured[i]->max > tasks[i].wcet_us)
+            tasks[i].wcet_us = rt_measured[i]->max;
+    }
+
+    misses = rt_response_times(tasks, TASK_COUNT);
+
+    if(verbose)
+    {
+        u = rt_utilization(tasks, TASK_COUNT);
+        printk("\nResponse time analysis (%s WCETs), utilization %u.%02u %%\n", measured ? "measured" : "declared",
+               u / 100, u % 100);
+        for(int i = 0; i < TASK_COUNT; i++)
+        {
+            if(tasks[i].response_us == UINT32_MAX)
+                printk("  %-15s prio %d, T = %u us, C = %u us, R > D (deadline miss)\n",
+                       tasks[i].name, tasks[i].prio, tasks[i].period_us, tasks[i].wcet_us);
+            else
+                printk("  %-15s prio %d, T = %u us, C = %u us, R = %u us\n",
+                       tasks[i].name, tasks[i].prio, tasks[i].period_us, tasks[i].wcet_us, tasks[i].response_us);
+        }
     }
+
+    return misses;
 }
 
 /** \brief Function to read integer values from user.
@@ -501,7 +734,8 @@ int read_int()
  *  
  *  This function implements a digital filter that removes the outliers
  * (10% or high deviation from average) from a set of data and computes the average
- * of the remaining samples.  
+ * of the remaining samples. It scans the whole window, the outlier filter module gives the
+ * same result incrementally (ofilter_output()).
  *
  * \param[in] data pointer to array 
  * 
@@ -538,6 +772,35 @@ int filter(int *data)
     return array_average(new_data, j);  // return average of filtered data
 }
 
+/** \brief Function to configure a DSP filter
+ *
+ *  Initializes the filter with the parameters of the application for the given type,
+ * can be called at runtime to change the filter.
+ *
+ * \param[out] f filter
+ * \param[in] type filter type
+ *
+ * \returns 0 on success, -1 if the type is unknown
+ */
+int dsp_config(struct dsp_filter *f, enum dsp_filter_type type)
+{
+    switch(type)
+    {
+        case DSP_MEDIAN:
+            return dsp_median_init(f, dsp_buf, DSP_MEDIAN_SIZE);
+        case DSP_EMA:
+            return dsp_ema_init(f, DSP_EMA_ALPHA);
+        case DSP_FIR:
+            return dsp_fir_init(f, dsp_fir_taps, DSP_FIR_TAPS, dsp_buf);
+        case DSP_BIQUAD_Q15:
+            return dsp_biquad_q15_init(f, dsp_biquad_q15, 1, 1, (q15_t *)dsp_state);
+        case DSP_BIQUAD_Q31:
+            return dsp_biquad_q31_init(f, dsp_biquad_q31, 1, 1, dsp_state);
+        default:
+            return -1;
+    }
+}
+
 /** \brief Function to initialize integer array
  * 
  *  This function fills an integer array with zeros
@@ -0,0 +1,128 @@
+/** \file stressspscring.c
+ * 	\brief Stress test of the lock-free SPSC ring
+ *
+ *  A producer and a consumer thread run flat out on the ring, with random pauses to mix
+ * full and empty rings. The producer puts the count of the samples it put, so the consumer
+ * must get 0, 1, 2, ... and every snapshot must be consecutive: a lost, repeated or torn
+ * sample breaks the sequence. At the end the counters must add up.
+ *
+ * \author André Brandão
+ * \author Emanuel Pereira
+ * \date 29/05/2022
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <sched.h>
+#include "spsc_ring.h"
+
+#define RING_SIZE 16        /**< Ring size */
+#define WINDOW 10           /**< Snapshot size */
+#define NPUTS 500000u       /**< Samples put by the producer */
+
+SPSC_RING_DEFINE(ring, RING_SIZE);
+
+static uint32_t puts_ok;        /**< Samples put */
+static uint32_t attempts;       /**< Calls of spsc_ring_put() */
+static volatile int done;       /**< Producer finished */
+
+/** \brief Producer thread, puts NPUTS samples */
+static void *producer(void *arg)
+{
+    unsigned int seed = 1;
+
+    (void)arg;
+
+    while(puts_ok < NPUTS)
+    {
+        attempts++;
+        if(spsc_ring_put(&ring, (uint16_t)puts_ok) == 0)
+            puts_ok++;
+        else if(rand_r(&seed) % 16 == 0)
+            sched_yield();  // Full, let the consumer run
+
+        if(rand_r(&seed) % 4096 == 0)
+            sched_yield();  // Let the ring empty
+    }
+
+    __atomic_store_n(&done, 1, __ATOMIC_RELEASE);
+    return NULL;
+}
+
+int main(void)
+{
+    pthread_t tid;
+    unsigned int seed = 2;
+    uint32_t gets = 0, snapshots = 0, torn = 0, fails = 0;
+    uint16_t val, window[WINDOW];
+
+    if(spsc_ring_init(&ring) != 0 || spsc_ring_snapshot(&ring, window, RING_SIZE) == 0)
+    {
+        printf("spsc_ring_init() or size check failed\n");
+        return 1;
+    }
+
+    pthread_create(&tid, NULL, producer, NULL);
+
+    while(1)
+    {
+        if(spsc_ring_get(&ring, &val) == 0)
+        {
+            if(val != (uint16_t)gets)
+            {
+                if(fails++ < 10)
+                    printf("get %u: expected %u, got %u\n", gets, (uint16_t)gets, val);
+            }
+            gets++;
+        }
+        else if(__atomic_load_n(&done, __ATOMIC_ACQUIRE) && spsc_ring_count(&ring) == 0)
+        {
+            break;
+        }
+        else if(rand_r(&seed) % 16 == 0)
+        {
+            sched_yield();  // Empty, let the producer run
+        }
+
+        if(rand_r(&seed) % 64 == 0)
+        {
+            if(spsc_ring_snapshot(&ring, window, WINDOW) == 0)
+            {
+                snapshots++;
+                for(int i = 1; i < WINDOW; i++)
+                {
+                    if(window[i] != (uint16_t)(window[i - 1] + 1) && !(window[i - 1] == 0 && window[i] == 0))
+                    {
+                        if(fails++ < 10)
+                            printf("snapshot %u: samples %u and %u not consecutive\n", snapshots, window[i - 1], window[i]);
+                        break;
+                    }
+                }
+            }
+            else
+            {
+                torn++;
+            }
+        }
+
+        if(rand_r(&seed) % 4096 == 0)
+            sched_yield();  // Let the ring fill
+    }
+
+    pthread_join(tid, NULL);
+
+    if(gets != puts_ok || puts_ok + spsc_ring_overruns_get(&ring) != attempts)
+    {
+        printf("counters: puts %u, gets %u, overruns %u\n", puts_ok, gets, spsc_ring_overruns_get(&ring));
+        fails++;
+    }
+
+    printf("%u puts, %u overruns, %u underruns, %u snapshots (%u retried out), %u failures\n",
+           puts_ok, spsc_ring_overruns_get(&ring), spsc_ring_underruns_get(&ring), snapshots, torn, fails);
+
+    if(fails)
+        return 1;
+
+    printf("OK\n");
+    return 0;
+}
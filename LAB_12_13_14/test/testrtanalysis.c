@@ -0,0 +1,94 @@
+/** \file testrtanalysis.c
+ * 	\brief Test of the priority assignment and response time analysis
+ *
+ *  Checks the priorities and response times of task sets solved by hand (textbook
+ * examples), with rate and deadline monotonic orders, blocking and an unschedulable set.
+ *
+ * \author André Brandão
+ * \author Emanuel Pereira
+ * \date 18/06/2022
+ */
+#include <stdio.h>
+#include "rt_analysis.h"
+
+static int fails = 0;
+
+/** \brief Function to check a value */
+static void check(const char *what, long got, long expected)
+{
+    if(got != expected)
+    {
+        printf("%s: got %ld, expected %ld\n", what, got, expected);
+        fails++;
+    }
+}
+
+int main(void)
+{
+    /* Schedulable by rate monotonic, the lowest priority task ends at its deadline */
+    struct rt_task rm[] = {
+        {"t20", 20, 5, 0, 0, 0, 0},
+        {"t7", 7, 3, 0, 0, 0, 0},
+        {"t12", 12, 3, 0, 0, 0, 0},
+    };
+    rt_assign_priorities(rm, 3, RT_RATE_MONOTONIC, 1);
+    check("rm prio t20", rm[0].prio, 3);
+    check("rm prio t7", rm[1].prio, 1);
+    check("rm prio t12", rm[2].prio, 2);
+    check("rm misses", rt_response_times(rm, 3), 0);
+    check("rm R t7", rm[1].response_us, 3);
+    check("rm R t12", rm[2].response_us, 6);
+    check("rm R t20", rm[0].response_us, 20);
+    check("rm utilization", rt_utilization(rm, 3), 2500 + 4285 + 2500);
+
+    /* Unschedulable, utilization above the Liu and Layland bound and a deadline missed */
+    struct rt_task bad[] = {
+        {"t50", 50, 12, 0, 0, 0, 0},
+        {"t40", 40, 10, 0, 0, 0, 0},
+        {"t30", 30, 10, 0, 0, 0, 0},
+    };
+    rt_assign_priorities(bad, 3, RT_RATE_MONOTONIC, 1);
+    check("bad misses", rt_response_times(bad, 3), 1);
+    check("bad R t30", bad[2].response_us, 10);
+    check("bad R t40", bad[1].response_us, 20);
+    check("bad R t50", bad[0].response_us, UINT32_MAX);
+
+    /* Short deadline: misses with rate monotonic, schedulable with deadline monotonic */
+    struct rt_task dm[] = {
+        {"d5", 20, 3, 5, 0, 0, 0},
+        {"t10", 10, 3, 0, 0, 0, 0},
+    };
+    rt_assign_priorities(dm, 2, RT_RATE_MONOTONIC, 1);
+    check("dm-rm misses", rt_response_times(dm, 2), 1);
+    rt_assign_priorities(dm, 2, RT_DEADLINE_MONOTONIC, 1);
+    check("dm prio d5", dm[0].prio, 1);
+    check("dm misses", rt_response_times(dm, 2), 0);
+    check("dm R d5", dm[0].response_us, 3);
+    check("dm R t10", dm[1].response_us, 6);
+
+    /* Blocking by a lower priority task (direct for a, push-through for b) and equal periods (table order) */
+    struct rt_task blk[] = {
+        {"a", 100, 10, 0, 5, 0, 0},
+        {"b", 100, 20, 0, 0, 0, 0},
+        {"c", 1000, 100, 0, 15, 0, 0},
+    };
+    rt_assign_priorities(blk, 3, RT_RATE_MONOTONIC, 1);
+    check("blk prio a", blk[0].prio, 1);
+    check("blk prio b", blk[1].prio, 2);
+    check("blk misses", rt_response_times(blk, 3), 0);
+    check("blk R a", blk[0].response_us, 25);
+    check("blk R b", blk[1].response_us, 45);
+    check("blk R c", blk[2].response_us, 160);
+
+    /* No blocking when the higher priority tasks do not use the mutex */
+    blk[0].cs_us = 0;
+    check("noblk misses", rt_response_times(blk, 3), 0);
+    check("noblk R a", blk[0].response_us, 10);
+    check("noblk R b", blk[1].response_us, 30);
+
+    if(fails)
+        return 1;
+
+    printf("OK\n");
+    return 0;
+}